@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+"""Generates a 3D RC mesh netlist, used to measure the linear solvers.
+
+Every mesh node is connected to its neighbours with resistors and to the ground
+with a capacitor, the bottom layer is tied to the ground through resistors and
+a pulse current source is injected at one corner. The transient system solved
+at every step is G + C/h.
+
+Comparison of the linear solvers on the same mesh:
+    ./scripts/rc_mesh3d.py 40 CHOL > mesh.cir
+    ./build/bspice mesh.cir --headless
+The solver statistics print the factorization and solve timings.
+"""
+
+import sys
+
+
+def mesh(n, solver):
+    node = lambda x, y, z: f"n{x}_{y}_{z}"
+    lines = [f"* 3D RC mesh {n}x{n}x{n}"]
+
+    if solver:
+        lines.append(f".OPTIONS SOLVER={solver}")
+
+    lines.append(f"I1 0 {node(n - 1, n - 1, n - 1)} 0 PULSE 0 1E-3 0 1E-10 1E-10 2E-9 5E-9")
+
+    for x in range(n):
+        for y in range(n):
+            for z in range(n):
+                cur = node(x, y, z)
+                if x + 1 < n: lines.append(f"RX{x}_{y}_{z} {cur} {node(x + 1, y, z)} 10")
+                if y + 1 < n: lines.append(f"RY{x}_{y}_{z} {cur} {node(x, y + 1, z)} 10")
+                if z + 1 < n: lines.append(f"RZ{x}_{y}_{z} {cur} {node(x, y, z + 1)} 10")
+                if z == 0: lines.append(f"RG{x}_{y} {cur} 0 100")
+                lines.append(f"C{x}_{y}_{z} {cur} 0 1E-13")
+
+    lines.append(".TRAN 1E-11 1E-8")
+    lines.append(f".PLOT V({node(n - 1, n - 1, n - 1)}) V({node(n // 2, n // 2, n // 2)})")
+
+    return "\n".join(lines) + "\n"
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.exit("Usage: rc_mesh3d.py <nodes per dimension> [solver]")
+
+    sys.stdout.write(mesh(int(sys.argv[1]), sys.argv[2] if len(sys.argv) > 2 else ""))
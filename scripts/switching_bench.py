@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Measures the accuracy and the timesteps of the transient methods on a switching waveform.
+
+A 10 MHz clock (1 ns edges) drives an RC ladder for 100 periods, the results of
+every method are compared with a fixed timestep Trapezoidal reference at 1 ps:
+    ./scripts/switching_bench.py ./build/bspice
+The error is the maximum over the nodes, at the output timepoints and on the 1 ns
+TRAN grid (the results linearly interpolated, as they are plotted). The adaptive
+methods output the TRAN grid too (interpolated), their timesteps are at most 1/50
+of the span (or TMAX) and land exactly on the source corners.
+"""
+
+import bisect
+import os
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+
+METHODS = ["EULER", "TRAP", "EULER ADAPTIVE", "TRAP ADAPTIVE", "GEAR2 ADAPTIVE", "BDF",
+           "TRAP ADAPTIVE TMAX=1E-8", "BDF TMAX=1E-8"]
+
+
+def netlist(options, step):
+    return "\n".join(["* Switching RC ladder, 100 periods of a 10 MHz clock",
+                      "V1 1 0 0 PULSE 0 1 0 1E-9 1E-9 48E-9 100E-9",
+                      "R1 1 2 100", "C1 2 0 1E-11", "R2 2 3 100", "C2 3 0 1E-10", "R3 3 4 1000", "C3 4 0 1E-10",
+                      f".TRAN {step} 1E-5", ".PLOT V(2) V(3) V(4)", f".OPTIONS {options}"]) + "\n"
+
+
+def run(binary, folder, name, options, step):
+    cir = os.path.join(folder, name + ".cir")
+    raw = os.path.join(folder, name + ".raw")
+
+    with open(cir, "w") as f:
+        f.write(netlist(options, step))
+
+    out = subprocess.run([binary, cir, "--headless", "--raw", raw], capture_output=True, text=True, check=True).stdout
+    steps = re.search(r"Timesteps: (\d+) accepted, (\d+) rejected", out)
+
+    return read_raw(raw), (steps.groups() if steps else ("-", "-"))
+
+
+def read_raw(file):
+    data = open(file, "rb").read()
+    pos = data.index(b"Binary:\n")
+    header = dict(l.split(": ", 1) for l in data[:pos].decode().split("\n") if ": " in l)
+    cols, rows = int(header["No. Variables"]), int(header["No. Points"])
+    vals = struct.unpack(f"{rows * cols}d", data[pos + 8:])
+
+    return [vals[r * cols:(r + 1) * cols] for r in range(rows)]
+
+
+def interp(rows, times, t, k):
+    j = min(max(bisect.bisect_right(times, t) - 1, 0), len(rows) - 2)
+    a, b = rows[j], rows[j + 1]
+
+    return a[k] + (b[k] - a[k]) * (t - times[j]) / (times[j + 1] - times[j])
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.exit("Usage: switching_bench.py <bspice binary>")
+
+    binary = os.path.abspath(sys.argv[1])
+
+    with tempfile.TemporaryDirectory() as folder:
+        ref, _ = run(binary, folder, "ref", "TRAP", "1E-12")
+        ref_t = [r[0] for r in ref]
+        grid = [i * 1e-9 for i in range(10001)]
+
+        print(f"{'method':24} {'points':>8} {'accepted':>9} {'rejected':>9} {'err points':>11} {'err grid':>11}")
+
+        for name in METHODS:
+            rows, (accepted, rejected) = run(binary, folder, name.replace(" ", "_"), name, "1E-9")
+            times = [r[0] for r in rows]
+            cols = range(1, len(rows[0]))
+
+            err_pts = max(abs(r[k] - interp(ref, ref_t, r[0], k)) for r in rows for k in cols)
+            err_grid = max(abs(interp(rows, times, t, k) - interp(ref, ref_t, t, k)) for t in grid for k in cols)
+            print(f"{name:24} {len(rows):8} {accepted:>9} {rejected:>9} {err_pts:11.3e} {err_grid:11.3e}")
@@ -4,9 +4,12 @@
 /** Integer size used inside BSPICE. */
 typedef int IntTp;
 
-/** TODO - Floating point accuracy used inside BSPICE. */
+/** Floating point accuracy used inside BSPICE. */
 typedef double FpTp;
 
+/** Reduced floating point accuracy, used by the mixed precision factorization. */
+typedef float FpLowTp;
+
 #ifdef BSPICE_EIGEN_USE_STLMAPS
     #include <unordered_map>
 
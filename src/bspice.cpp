@@ -16,7 +16,7 @@ static std::string bspice_error_report(return_codes_e errcode)
     switch(errcode)
     {
         case RETURN_SUCCESS: ret_str = ""; break;
-        case FAIL_ARG_NUM: ret_str += "Invalid number of input arguments. Syntax is as follows => ./bspice <filename>"; break;
+        case FAIL_ARG_NUM: ret_str += "Invalid number of input arguments. Syntax is as follows => ./bspice <filename> [--restart] [--load-x0 <file>] [--save-x0 <file>] [--raw <file>] [--wave <file>] [--meas <file>] [--csv <file>] [--tsv <file>] [--headless]"; break;
 
         /* Parser */
         case FAIL_LOADING_FILE: ret_str += "Unable to open input file"; break;
@@ -37,6 +37,10 @@ static std::string bspice_error_report(return_codes_e errcode)
         case FAIL_SIMULATOR_EMPTY: ret_str += "No circuit is has been loaded, can't run empty simulation."; break;
         case FAIL_SIMULATOR_FACTORIZATION: ret_str += "Failure during factorization (Singular matrix)."; break;
         case FAIL_SIMULATOR_SOLVE: ret_str += "Failure during backwards solving (Solve failure)."; break;
+        case FAIL_SIMULATOR_TIMESTEP_TOO_SMALL: ret_str += "Timestep too small, truncation error tolerances can't be met (RELTOL/ABSTOL)."; break;
+        case FAIL_SIMULATOR_RESTART: ret_str += "No valid checkpoint of the netlist to restart the transient from (or SAVE ALL, it can't be resumed)."; break;
+        case FAIL_SIMULATOR_OUTPUT: ret_str += "Failure writing the output file (--raw/--wave/--meas/--csv/--tsv)."; break;
+        case FAIL_SIMULATOR_INITIAL_STATE: ret_str += "Initial state file (--load-x0/--save-x0) missing, invalid or of a different circuit."; break;
 
         /* Plotter engine opcodes - Used inside plot.cpp */
         case FAIL_PLOTTER_IO_OPERATIONS: ret_str += "Failure in opening plot necessary plot I/O."; break;
@@ -50,15 +54,54 @@ static std::string bspice_error_report(return_codes_e errcode)
 }
 
 /*!
-    @brief      The entire simulation run, non-interactive.
+    @brief      Parses the optional command line arguments, after the input file:
+    - --restart: The transient resumes from the last checkpoint (not with SAVE ALL, the waveform file is not resumable).
+    - --load-x0 <file>: The initial state of the transient is loaded from the file (OP skipped).
+    - --save-x0 <file>: The OP is saved to the file, as the initial state of a following run.
+    - --raw <file>: The results are streamed to the file, in the binary SPICE rawfile format.
+    - --wave <file>: The results are streamed to the file, in the chunked, compressed waveform format (see wave_writer).
+    - --meas <file>: The results of the measurements (MEASURE cards) are written to the file, in JSON (default is the netlist with .meas.json).
+    - --csv <file>: The results are exported to the file, comma separated text.
+    - --tsv <file>: The results are exported to the file, tab separated text.
+    - --headless: No plotting, GNUPLOT is not started. The results go only to the output files, a
+    rawfile (netlist with .raw) when none is given. The OP results are still printed.
     @param      argc The command line process's number of arguments.
     @param      argv The command line process's arguments vector.
+    @param      args The simulation arguments.
+    @return     True in case of valid arguments, otherwise false.
+*/
+static bool bspice_parse_args(int argc, char **argv, sim_args_t &args)
+{
+    if(argc < 2) return false;
+
+    for(int i = 2; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+
+        if(arg == "--restart" && !args.restart) args.restart = true;
+        else if(arg == "--load-x0" && i + 1 < argc && args.load_x0.empty()) args.load_x0 = argv[++i];
+        else if(arg == "--save-x0" && i + 1 < argc && args.save_x0.empty()) args.save_x0 = argv[++i];
+        else if(arg == "--raw" && i + 1 < argc && args.raw.empty()) args.raw = argv[++i];
+        else if(arg == "--wave" && i + 1 < argc && args.wave.empty()) args.wave = argv[++i];
+        else if(arg == "--meas" && i + 1 < argc && args.meas.empty()) args.meas = argv[++i];
+        else if(arg == "--csv" && i + 1 < argc && args.csv.empty()) args.csv = argv[++i];
+        else if(arg == "--tsv" && i + 1 < argc && args.tsv.empty()) args.tsv = argv[++i];
+        else if(arg == "--headless" && !args.headless) args.headless = true;
+        else return false;
+    }
+
+    return true;
+}
+
+/*!
+    @brief      The entire simulation run, non-interactive.
+    @param      input_file_name The SPICE netlist.
+    @param      args            The simulation arguments.
     @return     Error code in case of error, otherwise RETURN_SUCESS.
 */
-static return_codes_e bspice_single_run(int argc, char **argv)
+static return_codes_e bspice_single_run(const std::string &input_file_name, const sim_args_t &args)
 {
     return_codes_e errcode = RETURN_SUCCESS;
-    std::string input_file_name(argv[1]);
 
     /* Step 2 - Instantiate a circuit */
     circuit circuit_manager(input_file_name);
@@ -66,11 +109,20 @@ static return_codes_e bspice_single_run(int argc, char **argv)
     if(errcode != RETURN_SUCCESS) return errcode;
 
     /* Step 3 - Proceed to the simulator engine */
-    simulator sim_manager(circuit_manager);
+    simulator sim_manager(circuit_manager, args);
     errcode = sim_manager.run();
     if(errcode != RETURN_SUCCESS) return errcode;
 
-    /* Step 4 - Output the results */
+    /* Step 4 - Export and output the results */
+    if(!args.csv.empty()) errcode = export_text(circuit_manager, sim_manager, args.csv, ',');
+    if(errcode != RETURN_SUCCESS) return errcode;
+
+    if(!args.tsv.empty()) errcode = export_text(circuit_manager, sim_manager, args.tsv, '\t');
+    if(errcode != RETURN_SUCCESS) return errcode;
+
+    /* Headless, only the OP results are printed (no plotting) */
+    if(args.headless && circuit_manager.AnalysisType() != OP) return RETURN_SUCCESS;
+
     return plot(circuit_manager, sim_manager);
 }
 
@@ -82,15 +134,17 @@ static return_codes_e bspice_single_run(int argc, char **argv)
 */
 int main(int argc, char **argv)
 {
-    /* Step 1 - Check for valid number of input arguments */
-    if (argc != 2)
+    sim_args_t args;
+
+    /* Step 1 - Check for valid input arguments */
+    if (!bspice_parse_args(argc, argv, args))
     {
         std::cout << bspice_error_report(FAIL_ARG_NUM) << std::endl;
         return FAIL_ARG_NUM;
     }
 
     /* Enter BSPICE */
-    return_codes_e err = bspice_single_run(argc, argv);
+    return_codes_e err = bspice_single_run(argv[1], args);
     std::cout << bspice_error_report(err) << std::endl;
 
     return err;
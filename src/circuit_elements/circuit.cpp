@@ -1,7 +1,9 @@
 #include <chrono>		/* For time reporting */
 #include <algorithm>
+#include <cmath>
 #include "circuit.hpp"
 #include <unordered_map>    /* TODO - For multimap */
+#include <unordered_set>
 
 
 
@@ -83,6 +85,24 @@ const std::vector<std::string> &circuit::PlotNodes(void) noexcept { return _plot
 */
 const std::vector<std::string> &circuit::PlotSources(void) noexcept { return _plot_sources; }
 
+/*!
+    @brief    Get the nodes with an initial voltage (IC card).
+    @return   The nodes names.
+*/
+const std::vector<std::string> &circuit::ICNodes(void) noexcept { return _ic_nodes; }
+
+/*!
+    @brief    Get the initial voltages of the nodes (IC card), in the order of ICNodes().
+    @return   The voltages.
+*/
+const std::vector<double> &circuit::ICValues(void) noexcept { return _ic_vals; }
+
+/*!
+    @brief    Get the measurements (MEASURE cards).
+    @return   The measurements.
+*/
+const std::vector<measure_spec_t> &circuit::Measures(void) noexcept { return _measures; }
+
 /*!
     @brief    Get the DC source for analysis.
     @return   The DC source name.
@@ -120,10 +140,28 @@ analysis_t circuit::AnalysisType(void) noexcept { return _type; }
 as_scale_t circuit::AnalysisScale(void) noexcept { return _scale; }
 
 /*!
-    @brief    Get the ODE method to be used for transient.
-    @return   The method.
+    @brief    Get the simulator options (OPTIONS card).
+    @return   The options.
 */
-ODE_meth_t circuit::ODEMethod(void) noexcept { return _ode_method; }
+const sim_options_t &circuit::Options(void) noexcept { return _options; }
+
+/*!
+    @brief    Get the checkpoint file of the transient (netlist name with the .ckpt extension).
+    @return   The file name.
+*/
+const std::string &circuit::CheckpointFile(void) noexcept { return _ckpt_file; }
+
+/*!
+    @brief    Get the SPICE netlist file of the circuit.
+    @return   The file name.
+*/
+const std::string &circuit::InputFile(void) noexcept { return _input_file; }
+
+/*!
+    @brief    Get whether all the unknowns are saved (SAVE ALL card), not only the plotted ones.
+    @return   True when all the unknowns are saved, otherwise false.
+*/
+bool circuit::SaveAll(void) noexcept { return _save_all; }
 
 /*!
     @brief    Returns the last error during parsing of the netlist.
@@ -157,7 +195,7 @@ void circuit::clear(void)
     hashmap_str_t().swap(_element_names);
     hashmap_str_t().swap(_nodes);
 
-    /* Leave out the plot names since they are needed... */
+    /* Leave out the plot names and the initial conditions since they are needed... */
 }
 
 
@@ -188,7 +226,10 @@ circuit::circuit(const std::string &input_file_name)
     std::cout << "\n[INFO]: Loading file...\n";
 
     /* Default initialize values in case netlist does not do so */
-    this->_ode_method = BACKWARDS_EULER;
+    this->_options = sim_options_t();
+    this->_ckpt_file = input_file_name + ".ckpt";
+    this->_input_file = input_file_name;
+    this->_save_all = false;
     this->_scale = DEC_SCALE;
     this->_type = OP;
     this->_errcode = FAIL_LOADING_FILE;
@@ -386,7 +427,17 @@ circuit::circuit(const std::string &input_file_name)
         std::cout << "************************************\n";
         std::cout << "Simulation Type: " << this->_type << "\n";
         std::cout << "Scale: " << this->_scale << "\n";
-        std::cout << "ODE method: " << this->_ode_method << "\n";
+        std::cout << "ODE method: " << this->_options.ode_method << " (max order: " << this->_options.max_order << ")\n";
+        std::cout << "Linear solver: " << this->_options.solver << " (LU comparison: " << this->_options.lu_stats << ")\n";
+        std::cout << "Adaptive timestep: " << this->_options.adaptive << " (RELTOL: " << this->_options.reltol << ", ABSTOL: " << this->_options.abstol << ", TMAX: " << this->_options.max_step << ")\n";
+        std::cout << "Factorization cache: " << this->_options.cache_mem << "MB\n";
+        std::cout << "Waveform relaxation: " << this->_options.relaxation << " (partitions: " << this->_options.partitions << ")\n";
+        std::cout << "Checkpoint interval: " << this->_options.ckpt_interval << "s (" << this->_ckpt_file << ")\n";
+        std::cout << "Initial conditions: " << this->_ic_nodes.size() << " nodes (UIC: " << this->_options.uic << ")\n";
+        std::cout << "Save all: " << this->_save_all << "\n";
+        std::cout << "Plot downsampling: " << this->_options.downsample << " (points: " << this->_options.plot_points << ")\n";
+        std::cout << "Results format: " << this->_options.store_format << "\n";
+        std::cout << "Measurements: " << this->_measures.size() << "\n";
         std::cout << "Total nodes to plot: " << this->_plot_nodes.size() << "\n";
         std::cout << "Total sources to plot: " << this->_plot_sources.size() << "\n";
         std::cout << "************************************\n\n";
@@ -411,9 +462,25 @@ return_codes_e circuit::SPICECard(std::vector<std::string> &tokens, parser &matc
 	{
 		return match.parsePLOTCard(tokens, this->_plot_nodes, this->_plot_sources);
 	}
+	else if(spice_card == "IC")
+	{
+		return match.parseICCard(tokens, this->_ic_nodes, this->_ic_vals);
+	}
+	else if(spice_card == "SAVE")
+	{
+		return match.parseSAVECard(tokens, this->_save_all);
+	}
+	else if(spice_card == "MEASURE" || spice_card == "MEAS")
+	{
+		measure_spec_t spec;
+		return_codes_e errcode = match.parseMEASCard(tokens, spec);
+
+		this->_measures.push_back(spec);
+		return errcode;
+	}
 	else if(spice_card == "OPTIONS") /* Means we parse simulator/circuit options and set them directly */
 	{
-	    return setCircuitOptions(tokens);
+	    return setCircuitOptions(tokens, match);
 	}
 
 	/* Base parameters for analysis */
@@ -458,30 +525,152 @@ return_codes_e circuit::SPICECard(std::vector<std::string> &tokens, parser &matc
     Since there is no need for tokanization or special pattern matching, this is here
     inside the circuit class.
     @param  tokens  The tokens that contain the OPTIONS card.
+    @param  match   Syntax parser instantiation (option values).
     @return   The error code, in case of error, otherwise RETURN_SUCCESS.
 */
-return_codes_e circuit::setCircuitOptions(std::vector<std::string> &tokens)
+return_codes_e circuit::setCircuitOptions(std::vector<std::string> &tokens, parser &match)
 {
     auto it = tokens.begin() + 1;
-    bool integr_found = false;
+    auto &opts = this->_options;
+    std::unordered_set<std::string> found;
 
     /* Iteratively find every option card */
     while(it != tokens.end())
     {
-        if(*it == "GEAR2" && !integr_found)
+        /* Options with values are given as <OPTION>=<VALUE> */
+        size_t eq_pos = it->find('=');
+        std::string option = it->substr(0, eq_pos);
+        std::string value = (eq_pos == std::string::npos) ? "" : it->substr(eq_pos + 1);
+
+        /* Every option at most once, the integration methods are one option (by name or METHOD=<name>) */
+        bool method = (option == "GEAR2" || option == "EULER" || option == "TRAP" || option == "BDF" || option == "EXPINT");
+        if(!found.insert(method ? "METHOD" : option).second) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+
+        if(option == "GEAR2")
+        {
+            opts.ode_method = GEAR2;
+        }
+        else if(option == "EULER")
+        {
+            opts.ode_method = BACKWARDS_EULER;
+        }
+        else if(option == "TRAP")
+        {
+            opts.ode_method = TRAPEZOIDAL;
+        }
+        else if(option == "BDF")
+        {
+            opts.ode_method = BDF;
+        }
+        else if(option == "EXPINT")
+        {
+            opts.ode_method = EXPINT;
+        }
+        else if(option == "METHOD")
+        {
+            if(value == "EULER") opts.ode_method = BACKWARDS_EULER;
+            else if(value == "TRAP") opts.ode_method = TRAPEZOIDAL;
+            else if(value == "GEAR2") opts.ode_method = GEAR2;
+            else if(value == "BDF") opts.ode_method = BDF;
+            else if(value == "EXPINT") opts.ode_method = EXPINT;
+            else return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+        }
+        else if(option == "MAXORD")
+        {
+            double order;
+
+            /* Integer order, 1 to 6 (BDF is unstable above) */
+            if(match.parseOptionValue(value, order) != RETURN_SUCCESS) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+            if(order != std::floor(order) || order < 1 || order > 6) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+
+            opts.max_order = static_cast<IntTp>(order);
+        }
+        else if(option == "SOLVER")
+        {
+            /* The solvers that are not compiled in are rejected, instead of falling back silently */
+            if(value == "AUTO") opts.solver = SOLVER_AUTO;
+#ifdef BSPICE_EIGEN_USE_KLU
+            else if(value == "KLU") opts.solver = SOLVER_KLU;
+#endif
+            else if(value == "LU" || value == "SPARSELU") opts.solver = SOLVER_SPARSELU;
+            else if(value == "CHOL" || value == "CHOLESKY") opts.solver = SOLVER_CHOLESKY;
+            else if(value == "BICGSTAB") opts.solver = SOLVER_BICGSTAB;
+            else if(value == "CG") opts.solver = SOLVER_CG;
+#ifdef BSPICE_EIGEN_USE_KLU
+            else if(value == "BTF") opts.solver = SOLVER_BTF;
+#endif
+            else if(value == "MIXED") opts.solver = SOLVER_MIXED;
+            else return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+        }
+        else if(option == "LUSTATS")
+        {
+            opts.lu_stats = true;
+        }
+        else if(option == "ADAPTIVE")
+        {
+            opts.adaptive = true;
+        }
+        else if(option == "RELTOL")
+        {
+            if(match.parseOptionValue(value, opts.reltol) != RETURN_SUCCESS) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+        }
+        else if(option == "ABSTOL")
+        {
+            if(match.parseOptionValue(value, opts.abstol) != RETURN_SUCCESS) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+        }
+        else if(option == "TMAX")
+        {
+            /* Maximum adaptive timestep, may exceed the TRAN step */
+            if(match.parseOptionValue(value, opts.max_step) != RETURN_SUCCESS) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+        }
+        else if(option == "WR")
+        {
+            double partitions = 0;
+
+            /* Optional number of partitions, otherwise one per thread */
+            if(!value.empty() && match.parseOptionValue(value, partitions) != RETURN_SUCCESS) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+            if(partitions != std::floor(partitions)) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+
+            opts.relaxation = true;
+            opts.partitions = static_cast<IntTp>(partitions);
+        }
+        else if(option == "CHECKPOINT")
+        {
+            /* Wall clock interval (s) */
+            if(match.parseOptionValue(value, opts.ckpt_interval) != RETURN_SUCCESS) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+        }
+        else if(option == "UIC")
+        {
+            opts.uic = true;
+        }
+        else if(option == "DOWNSAMPLE")
         {
-            this->_ode_method = GEAR2;
-            integr_found = true;
+            if(value == "NONE") opts.downsample = DOWNSAMPLE_NONE;
+            else if(value == "MINMAX") opts.downsample = DOWNSAMPLE_MINMAX;
+            else if(value == "LTTB") opts.downsample = DOWNSAMPLE_LTTB;
+            else return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
         }
-        else if(*it == "EULER" && !integr_found)
+        else if(option == "PLOTPOINTS")
         {
-            this->_ode_method = BACKWARDS_EULER;
-            integr_found = true;
+            double points;
+
+            /* Integer number of buckets, at least 2 (first and last point) */
+            if(match.parseOptionValue(value, points) != RETURN_SUCCESS) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+            if(points != std::floor(points) || points < 2) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+
+            opts.plot_points = static_cast<IntTp>(points);
+        }
+        else if(option == "STORE")
+        {
+            if(value == "DOUBLE") opts.store_format = STORE_DOUBLE;
+            else if(value == "FLOAT") opts.store_format = STORE_FLOAT;
+            else if(value == "INT16") opts.store_format = STORE_INT16;
+            else return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
         }
-        else if(*it == "TRAP" && !integr_found)
+        else if(option == "CACHEMEM")
         {
-            this->_ode_method = TRAPEZOIDAL;
-            integr_found = true;
+            /* Memory budget (MB) */
+            if(match.parseOptionValue(value, opts.cache_mem) != RETURN_SUCCESS) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
         }
         else
         {
@@ -497,6 +686,7 @@ return_codes_e circuit::setCircuitOptions(std::vector<std::string> &tokens)
 /*!
     @brief    Internal routine, that verifies the following for a given circuit:
   	  - Plot nodes for a plot card already exists in the circuit.
+  	  - Initial condition nodes for an IC card already exists in the circuit.
   	  - DC analysis source already exists in the circuit (if any DC analysis is active)
   	  - Set the circuit dimension and the source offset in the MNA equivalent matrix.
     @return   The error code, in case of error, otherwise RETURN_SUCCESS.
@@ -545,6 +735,39 @@ return_codes_e circuit::verify(void)
 		}
     }
 
+    /* Verify that each initial condition node exists in the circuit */
+    for(auto it = this->_ic_nodes.begin(); it != this->_ic_nodes.end(); it++)
+    {
+        auto node_it = this->_nodes.find(*it);
+
+        /* Does not exist in map (or ground) */
+        if(node_it == nodemap_end)
+        {
+            std::cout << "[ERROR - " << FAIL_PARSER_ELEMENT_NOT_EXISTS << "]: Element <" << *it << "> (IC CARD)" << std::endl;
+            return FAIL_PARSER_ELEMENT_NOT_EXISTS;
+        }
+    }
+
+    /* Verify that each signal of the measurements exists in the circuit (the currents of voltage-source-like elements) */
+    for(auto &it : this->_measures)
+    {
+        for(auto sig : {&it.sig, &it.trig.sig, &it.targ.sig})
+        {
+            bool exists;
+
+            if(sig->name.empty()) continue;
+
+            if(sig->current) exists = (this->_element_names.find(sig->name) != namemap_end) && std::string("VLEH").find(sig->name[0]) != std::string::npos;
+            else exists = (this->_nodes.find(sig->name) != nodemap_end);
+
+            if(!exists)
+            {
+                std::cout << "[ERROR - " << FAIL_PARSER_ELEMENT_NOT_EXISTS << "]: Element <" << sig->name << "> (MEASURE CARD)" << std::endl;
+                return FAIL_PARSER_ELEMENT_NOT_EXISTS;
+            }
+        }
+    }
+
     /* Verify that each CCVS depended source exists */
     for(auto &it : this->_ccvs)
     {
@@ -36,6 +36,9 @@ class circuit
         const hashmap_str_t &ElementNames(void) noexcept;
         const std::vector<std::string> &PlotNodes(void) noexcept;
         const std::vector<std::string> &PlotSources(void) noexcept;
+        const std::vector<std::string> &ICNodes(void) noexcept;
+        const std::vector<double> &ICValues(void) noexcept;
+        const std::vector<measure_spec_t> &Measures(void) noexcept;
         const std::string &DCSource(void) noexcept;
 
         /* Analysis specifics */
@@ -44,13 +47,16 @@ class circuit
         double SimStep(void) noexcept;
         analysis_t AnalysisType(void) noexcept;
         as_scale_t AnalysisScale(void) noexcept;
-        ODE_meth_t ODEMethod(void) noexcept;
+        const sim_options_t &Options(void) noexcept;
+        const std::string &CheckpointFile(void) noexcept;
+        const std::string &InputFile(void) noexcept;
+        bool SaveAll(void) noexcept;
         return_codes_e errcode(void) noexcept;
         bool valid(void) noexcept;
         void clear(void);
 
     private:
-        return_codes_e setCircuitOptions(std::vector<std::string> &tokens);
+        return_codes_e setCircuitOptions(std::vector<std::string> &tokens, parser &match);
         return_codes_e SPICECard(std::vector<std::string> &tokens, parser &match);
         return_codes_e verify(void);
         return_codes_e topology(void);
@@ -81,13 +87,23 @@ class circuit
         double _sim_step;				//!< The simulation step value.
         as_scale_t _scale;				//!< Scale of the analysis.
         analysis_t _type;				//!< Analysis type.
-        ODE_meth_t _ode_method;         //!< ODE method in case of transient.
+        sim_options_t _options;         //!< The simulator options (OPTIONS card).
+        std::string _ckpt_file;         //!< The transient checkpoint file.
+        std::string _input_file;        //!< The SPICE netlist file.
+        bool _save_all;                 //!< All the unknowns are saved to the waveform file (SAVE card).
         std::string _source;			//!< In case of DC analysis - Name of source.
         return_codes_e _errcode;        //!< Flag containing the last errorcode regarding the circuit.
 
         /* SPICE CARDS - Plot */
         std::vector<std::string> _plot_nodes;       //!< The nodes names to be plotted after simulation.
         std::vector<std::string> _plot_sources;     //!< The sources names to be plotted after simulation.
+
+        /* SPICE CARDS - Initial conditions */
+        std::vector<std::string> _ic_nodes;         //!< The nodes names with an initial voltage (transient).
+        std::vector<double> _ic_vals;               //!< The initial voltages of the nodes (transient).
+
+        /* SPICE CARDS - Measurements */
+        std::vector<measure_spec_t> _measures;      //!< The measurements, evaluated during the simulation.
 };
 
 #endif // __CIRCUIT_H //
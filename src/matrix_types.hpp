@@ -20,6 +20,9 @@ typedef std::vector<triplet_eig_cd> tripletList_cd;
 /** Eigen sparse matrix of unknown size (Reals). */
 typedef Eigen::SparseMatrix<double, Eigen::ColMajor, IntTp> SparMatD;
 
+/** Eigen sparse matrix of unknown size, row major (Reals). */
+typedef Eigen::SparseMatrix<double, Eigen::RowMajor, IntTp> SparMatRowD;
+
 /** Eigen sparse matrix of unknown size (Complex). */
 typedef Eigen::SparseMatrix<std::complex<double>, Eigen::ColMajor, IntTp> SparMatCompD;
 
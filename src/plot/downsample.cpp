@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cmath>
+#include "downsample.hpp"
+
+/** Rows transformed at a time (workspace of a trace). */
+static constexpr size_t chunk_rows = 4096;
+
+/*!
+    @brief      Splits the rows in buckets of equal width of the x axis (pixels), the x values are
+    monotonic so every bucket is a range of rows.
+    @param      x           The x values.
+    @param      rows        The number of rows.
+    @param      buckets     The number of buckets.
+    @param      bounds      The bounds, bucket b is the rows [bounds[b], bounds[b + 1]) (may be empty).
+*/
+static void xBuckets(const double *x, size_t rows, size_t buckets, std::vector<size_t> &bounds)
+{
+    double span = x[rows - 1] - x[0];
+
+    bounds.assign(1, 0);
+
+    for(size_t i = 1; i < rows; i++)
+    {
+        size_t b = (span != 0) ? static_cast<size_t>((x[i] - x[0]) / span * buckets) : 0;
+        b = std::min(b, buckets - 1);
+
+        while(bounds.size() <= b) bounds.push_back(i);
+    }
+
+    while(bounds.size() <= buckets) bounds.push_back(rows);
+}
+
+/*!
+    @brief      Selects the first, last, minimum and maximum row of a trace in every bucket, so the
+    envelope of the trace (and every spike) is kept exactly.
+    @param      col         The trace.
+    @param      bounds      The bounds of the buckets.
+    @param      selected    The rows selected, appended.
+*/
+static void selectMinMax(const text_column_t &col, const std::vector<size_t> &bounds, std::vector<size_t> &selected)
+{
+    std::vector<double> vals(chunk_rows);
+
+    for(size_t b = 0; b + 1 < bounds.size(); b++)
+    {
+        size_t begin = bounds[b], end = bounds[b + 1];
+        if(begin == end) continue;
+
+        size_t min_at = begin, max_at = begin;
+        double min = INFINITY, max = -INFINITY;
+
+        for(size_t first = begin; first < end; first += chunk_rows)
+        {
+            size_t count = std::min(chunk_rows, end - first);
+            text_writer::Transform(col, first, count, vals.data());
+
+            for(size_t i = 0; i < count; i++)
+            {
+                if(vals[i] < min) { min = vals[i]; min_at = first + i; }
+                if(vals[i] > max) { max = vals[i]; max_at = first + i; }
+            }
+        }
+
+        selected.insert(selected.end(), {begin, min_at, max_at, end - 1});
+    }
+}
+
+/*!
+    @brief      Selects a row of a trace in every bucket with the Largest-Triangle-Three-Buckets
+    method: the row forming the largest triangle with the row selected in the previous bucket and
+    the average of the next bucket. The first and the last row are always selected.
+    @param      x           The x values.
+    @param      rows        The number of rows.
+    @param      col         The trace.
+    @param      buckets     The number of buckets (with the first and last row).
+    @param      selected    The rows selected, appended.
+*/
+static void selectLTTB(const double *x, size_t rows, const text_column_t &col, size_t buckets, std::vector<size_t> &selected)
+{
+    std::vector<double> vals(chunk_rows);
+    double every = static_cast<double>(rows - 2) / (buckets - 2);
+    auto bound = [&](size_t b) { return std::min(rows - 1, 1 + static_cast<size_t>(b * every)); };
+
+    size_t prev = 0;
+    double prev_y;
+    text_writer::Transform(col, 0, 1, &prev_y);
+
+    selected.push_back(0);
+
+    for(size_t b = 0; b + 2 < buckets; b++)
+    {
+        size_t begin = bound(b), end = bound(b + 1);
+        size_t next_begin = end, next_end = (b + 3 < buckets) ? bound(b + 2) : rows;
+        if(begin == end) continue;
+
+        /* Average of the next bucket (the last row after the last bucket) */
+        double avg_x = 0, avg_y = 0;
+
+        for(size_t first = next_begin; first < next_end; first += chunk_rows)
+        {
+            size_t count = std::min(chunk_rows, next_end - first);
+            text_writer::Transform(col, first, count, vals.data());
+
+            for(size_t i = 0; i < count; i++) { avg_x += x[first + i]; avg_y += vals[i]; }
+        }
+
+        avg_x /= (next_end - next_begin);
+        avg_y /= (next_end - next_begin);
+
+        /* The largest triangle (twice its area) */
+        size_t best = begin;
+        double best_area = -1, best_y = 0, px = x[prev];
+
+        for(size_t first = begin; first < end; first += chunk_rows)
+        {
+            size_t count = std::min(chunk_rows, end - first);
+            text_writer::Transform(col, first, count, vals.data());
+
+            for(size_t i = 0; i < count; i++)
+            {
+                double area = std::abs((px - avg_x) * (vals[i] - prev_y) - (px - x[first + i]) * (avg_y - prev_y));
+                if(area > best_area) { best_area = area; best = first + i; best_y = vals[i]; }
+            }
+        }
+
+        selected.push_back(best);
+        prev = best;
+        prev_y = best_y;
+    }
+
+    selected.push_back(rows - 1);
+}
+
+/*!
+    @brief      Selects the rows of a plot to be displayed, so the plot has a bounded number of points
+    regardless of the length of the run. The traces are selected on their own (in parallel) on the
+    values plotted (the transforms of the columns) and the rows selected by any trace are kept, so
+    the traces still share the x values and every point displayed is an exact sample.
+    @param      x           The x values (monotonic).
+    @param      rows        The number of rows.
+    @param      cols        The traces.
+    @param      method      The downsampling method.
+    @param      buckets     The number of buckets of the x axis (e.g. the pixels of the plot).
+    @param      selected    The rows selected, in ascending order.
+    @return     True when the plot is downsampled, false when every row is to be displayed (few rows
+    or no downsampling).
+*/
+bool downsample(const double *x, size_t rows, const std::vector<text_column_t> &cols,
+                downsample_t method, size_t buckets, std::vector<size_t> &selected)
+{
+    selected.clear();
+
+    /* At most 4 (min/max) or 1 (LTTB) rows per bucket and trace */
+    if(method == DOWNSAMPLE_NONE || cols.empty() || buckets < 2) return false;
+    if(rows <= ((method == DOWNSAMPLE_MINMAX) ? 4 * buckets : buckets)) return false;
+
+    std::vector<std::vector<size_t>> per_trace(cols.size());
+    std::vector<size_t> bounds;
+
+    if(method == DOWNSAMPLE_MINMAX) xBuckets(x, rows, buckets, bounds);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(size_t k = 0; k < cols.size(); k++)
+    {
+        if(method == DOWNSAMPLE_MINMAX) selectMinMax(cols[k], bounds, per_trace[k]);
+        else if(buckets > 2) selectLTTB(x, rows, cols[k], buckets, per_trace[k]);
+        else per_trace[k] = {0, rows - 1};
+    }
+
+    for(auto &it : per_trace) selected.insert(selected.end(), it.begin(), it.end());
+
+    std::sort(selected.begin(), selected.end());
+    selected.erase(std::unique(selected.begin(), selected.end()), selected.end());
+
+    return true;
+}
@@ -0,0 +1,11 @@
+#ifndef __DOWNSAMPLE_H
+#define __DOWNSAMPLE_H
+
+#include <vector>
+#include "simulator_types.hpp"
+#include "text_writer.hpp"
+
+bool downsample(const double *x, size_t rows, const std::vector<text_column_t> &cols,
+                downsample_t method, size_t buckets, std::vector<size_t> &selected);
+
+#endif // __DOWNSAMPLE_H //
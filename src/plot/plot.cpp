@@ -1,10 +1,23 @@
+#include <algorithm>
 #include <fstream>
+#include <future>
 #include <iomanip>
 #include <cstdio>
 #include <limits>
 #include <math.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include "plot.hpp"
+#include "downsample.hpp"
+#include "text_writer.hpp"
+
+/** A plot window, sent to GNUPLOT once its data file is written. */
+typedef struct gnuplot_window
+{
+    std::string commands;           //!< The commands of the window (terminal, options, plot).
+    std::future<size_t> points;     //!< Writes the data file, the points written.
+} gnuplot_window_t;
 
 //! Class that sets up a connection with GNUPLOT for plotting.
 /*!
@@ -13,35 +26,115 @@
   - Connect with Gnuplot utility and manage communication.
   - Create and manage different plot windows.
   - Configure the plots/legends.
+  - Downsample the plots of long runs (display only, see downsample()).
+
+  The data of a window is written in the GNUPLOT binary format (the doubles of every row, x
+  first), so there is no formatting nor parsing of text. The data file of a window is written
+  by a background task while the next windows are prepared, the commands of the window are
+  sent once its file is complete.
 */
 class GNU_plotter
 {
 
     public:
-        GNU_plotter();
+        GNU_plotter(downsample_t method, size_t buckets);
         ~GNU_plotter();
         void plot(circuit &circuit_manager, simulator &simulator_manager);
 
+        /*!
+            @brief      Returns the points sent to GNUPLOT and the points of the results (all the windows).
+            @param      sent    The points sent.
+            @param      total   The points of the results.
+        */
+        void Points(size_t &sent, size_t &total) const noexcept { sent = _sent; total = _total; }
+
     private:
         void nextPlot(void);
         void setPlotOptions(analysis_t type, as_scale_t scale, std::string &sweep, bool source, bool mag);
         void sendPlotData(const std::vector<double> &xvals,
-                          const std::vector<std::vector<double>> &yvals,
+                          const result_store<double> &yvals,
                           bool log);
         void sendPlotData(const std::vector<double> &xvals,
-                          const std::vector<std::vector<std::complex<double>>> &yvals,
+                          const result_store<std::complex<double>> &yvals,
                           bool mag, bool log);
+        void sendColumns(const std::vector<double> &xvals, const std::vector<text_column_t> &cols);
         void finalize(const std::vector<std::string> &plotnames);
+        void sendWindows(size_t count);
 
         FILE *_pipe;                            //! File handler for the GNUPLOT sub-process pipe.
-        std::ofstream _data_file;               //! The active output data file.
         std::vector<std::string> _file_names;   //! The vector of all the file names used.
+        std::vector<gnuplot_window_t> _windows; //! The plot windows.
+        size_t _windows_sent = 0;               //! The windows sent to GNUPLOT.
+        downsample_t _method;                   //! The downsampling method of the plots.
+        size_t _buckets;                        //! The buckets of the x axis of the downsampled plots.
+        size_t _sent = 0;                       //! Points sent to GNUPLOT.
+        size_t _total = 0;                      //! Points of the results.
 };
 
 /*!
-    @brief    Default constructor, creates the GNUPLOT pipe.
+    @brief      Writes the data file of a plot window, in the GNUPLOT binary format (the doubles of
+    every row, the x value first). The file is mapped in memory and the rows are written in place.
+    Only the rows selected by the downsampling are written for a long run.
+    @param      file        The data file.
+    @param      xvals       The x values vector, simulation vector.
+    @param      cols        The columns, y values.
+    @param      method      The downsampling method.
+    @param      buckets     The buckets of the x axis of the downsampling.
+    @return     The points (rows) written.
 */
-GNU_plotter::GNU_plotter()
+static size_t writePlotData(const std::string &file, const std::vector<double> &xvals, const std::vector<text_column_t> &cols,
+                            downsample_t method, size_t buckets)
+{
+    static constexpr size_t block_rows = 4096;
+
+    std::vector<size_t> rows;
+    bool selected = downsample(xvals.data(), xvals.size(), cols, method, buckets, rows);
+
+    size_t points = selected ? rows.size() : xvals.size();
+    size_t width = cols.size() + 1;
+    size_t bytes = points * width * sizeof(double);
+
+    int fd = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    void *map = MAP_FAILED;
+
+    if(fd >= 0 && ftruncate(fd, bytes) == 0 && bytes) map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(fd >= 0) close(fd);
+
+    if(fd < 0 || (bytes && map == MAP_FAILED))
+    {
+        throw std::runtime_error("[CRITICAL ERROR]: Could not open files related to GNUPLOT");
+    }
+
+    double *out = static_cast<double *>(map);
+    std::vector<double> vals(block_rows);
+
+    for(size_t first = 0; first < points; first += block_rows)
+    {
+        size_t count = std::min(block_rows, points - first);
+        double *row = out + first * width;
+
+        for(size_t i = 0; i < count; i++) row[i * width] = xvals[selected ? rows[first + i] : first + i];
+
+        for(size_t k = 0; k < cols.size(); k++)
+        {
+            if(selected) for(size_t i = 0; i < count; i++) text_writer::Transform(cols[k], rows[first + i], 1, &vals[i]);
+            else text_writer::Transform(cols[k], first, count, vals.data());
+
+            for(size_t i = 0; i < count; i++) row[i * width + k + 1] = vals[i];
+        }
+    }
+
+    if(bytes) munmap(map, bytes);
+
+    return points;
+}
+
+/*!
+    @brief    Constructor, creates the GNUPLOT pipe.
+    @param    method    The downsampling method of the plots.
+    @param    buckets   The buckets of the x axis of the downsampled plots.
+*/
+GNU_plotter::GNU_plotter(downsample_t method, size_t buckets) : _method(method), _buckets(buckets)
 {
     _pipe = popen("gnuplot -persistent", "w");
 
@@ -57,12 +150,14 @@ GNU_plotter::GNU_plotter()
 */
 GNU_plotter::~GNU_plotter()
 {
+    /* Wait for the data files still written */
+    for(auto &it : this->_windows) if(it.points.valid()) it.points.wait();
+
     /* Close gnuplot */
     fprintf(this->_pipe, "pause -5\n\n quit\n");
     pclose(this->_pipe);
 
-    /* Close and remove files */
-    if(this->_data_file)  this->_data_file.close();
+    /* Remove files */
     for(auto &it : this->_file_names) remove(it.c_str());
 }
 
@@ -71,42 +166,58 @@ GNU_plotter::~GNU_plotter()
 */
 void GNU_plotter::nextPlot()
 {
-    /* Close previous file */
-    if(this->_data_file) this->_data_file.close();
-
     /* Ascending number */
-    std::string filename = ".gnuplotdata" + std::to_string(_file_names.size()) +  ".plt";
+    std::string filename = ".gnuplotdata" + std::to_string(_file_names.size()) +  ".bin";
     _file_names.push_back(filename);
 
-    fprintf(this->_pipe, "set term qt %ld\n", _file_names.size() - 1);
-
-    /* Create the new file */
-    _data_file = std::ofstream(filename, std::ios::out);
-
-    // TODO - Handle
-    if(!this->_data_file)
-    {
-        throw std::runtime_error("[CRITICAL ERROR]: Could not open files related to GNUPLOT");
-    }
+    /* The commands are sent with the rest of the window */
+    _windows.emplace_back();
+    _windows.back().commands = "set term qt " + std::to_string(_file_names.size() - 1) + "\n";
 }
 
 /*!
-    @brief      Sends the final plot command to GNUPLOT to display the graph.
+    @brief      Forms the final plot command of the current window and sends the previous windows
+    to GNUPLOT (their data files are complete by now, or soon).
     @param      plotnames     The legend names for the plots.
 */
 void GNU_plotter::finalize(const std::vector<std::string> &plotnames)
 {
-    /* Send the final commands to plot the vectors */
-    fprintf(this->_pipe, "plot '%s' using 1:2 title '%s' with lines", this->_file_names.back().c_str(), plotnames.front().c_str());
+    std::string &commands = this->_windows.back().commands;
+    std::string binary = " binary format='";
+
+    /* Every row is the x value and a double per trace */
+    for(size_t i = 0; i <= plotnames.size(); i++) binary += "%double";
+    binary += "'";
+
+    commands += "plot '" + this->_file_names.back() + "'" + binary + " using 1:2 title '" + plotnames.front() + "' with lines";
 
     for (size_t i = 1; i < plotnames.size(); i++)
     {
-        fprintf(this->_pipe, ",'' using 1:%ld title '%s' with lines", (i + 2), plotnames[i].c_str());
+        commands += ",''" + binary + " using 1:" + std::to_string(i + 2) + " title '" + plotnames[i] + "' with lines";
     }
 
-    /* Newline to finish command and flush for synchronization */
-    fprintf(this->_pipe, "\n");
-    fflush(this->_pipe);
+    /* Newline to finish command */
+    commands += "\n";
+
+    sendWindows(this->_windows.size() - 1);
+}
+
+/*!
+    @brief      Sends the windows to GNUPLOT, in order, waiting for their data files.
+    @param      count     The windows to be sent (from the first one).
+*/
+void GNU_plotter::sendWindows(size_t count)
+{
+    for(; this->_windows_sent < count; this->_windows_sent++)
+    {
+        auto &window = this->_windows[this->_windows_sent];
+
+        if(window.points.valid()) this->_sent += window.points.get();
+
+        /* Flush for synchronization */
+        fprintf(this->_pipe, "%s", window.commands.c_str());
+        fflush(this->_pipe);
+    }
 }
 
 /*!
@@ -115,33 +226,18 @@ void GNU_plotter::finalize(const std::vector<std::string> &plotnames)
     @param      yvals     The y values vector(s), result(s) vector.
     @param      log       Whether the data is in logarithmic scale or not.
 */
-void GNU_plotter::sendPlotData(const std::vector<double> &xvals, const std::vector<std::vector<double>> &yvals, bool log)
+void GNU_plotter::sendPlotData(const std::vector<double> &xvals, const result_store<double> &yvals, bool log)
 {
-	for(size_t i = 0; i < xvals.size(); i++)
-	{
-	    auto &tmp = yvals[i];
-
-		/* First iteration send also the x value */
-		this->_data_file << xvals[i];
-
-		/* Create the columns of data */
-		if(log)
-		{
-		    for(size_t k = 0; k < tmp.size(); k++)
-		        this->_data_file << "\t" << 20 * std::log10(tmp[k]);
-		}
-		else
-		{
-		    for(size_t k = 0; k < tmp.size(); k++)
-		        this->_data_file << "\t" << tmp[k];
-		}
-
-		/* Next sim time */
-		this->_data_file << "\n";
-	}
+    std::vector<text_column_t> cols(yvals.Cols());
 
-	/* Endl also performs a flush */
-	this->_data_file << std::endl;
+    for(size_t k = 0; k < yvals.Cols(); k++)
+    {
+        cols[k].real = &yvals;
+        cols[k].col = k;
+        cols[k].transform = log ? TEXT_DB : TEXT_VALUE;
+    }
+
+    sendColumns(xvals, cols);
 }
 
 /*!
@@ -151,42 +247,31 @@ void GNU_plotter::sendPlotData(const std::vector<double> &xvals, const std::vect
     @param      mag       Whether to send magnitude data or phase.
     @param      log       Whether the data is in logarithmic scale or not.
 */
-void GNU_plotter::sendPlotData(const std::vector<double> &xvals, const std::vector<std::vector<std::complex<double>>> &yvals, bool log, bool mag)
+void GNU_plotter::sendPlotData(const std::vector<double> &xvals, const result_store<std::complex<double>> &yvals, bool log, bool mag)
 {
-    for(size_t i = 0; i < xvals.size(); i++)
-    {
-        auto &tmp = yvals[i];
+    std::vector<text_column_t> cols(yvals.Cols());
 
-        /* First iteration send also the x value */
-        this->_data_file << xvals[i];
-
-        /* Create the columns of data */
-        if(mag)
-        {
-            if(log)
-            {
-                for(size_t k = 0; k < tmp.size(); k++)
-                    this->_data_file << "\t" << 20 * std::log10(std::abs(tmp[k]));
-            }
-            else
-            {
-                for(size_t k = 0; k < tmp.size(); k++)
-                    this->_data_file << "\t" << std::abs(tmp[k]);
-            }
-        }
-        else
-        {
-            /* Arg returns in radians convert to degrees */
-            for(size_t k = 0; k < tmp.size(); k++)
-                this->_data_file << "\t" << std::arg(tmp[k]) * 180/M_PI;
-        }
-
-        /* Next sim time */
-        this->_data_file << "\n";
+    for(size_t k = 0; k < yvals.Cols(); k++)
+    {
+        cols[k].complex = &yvals;
+        cols[k].col = k;
+        cols[k].transform = !mag ? TEXT_PHASE : (log ? TEXT_DB : TEXT_MAG);
     }
 
-    /* Endl also performs a flush */
-    this->_data_file << std::endl;
+    sendColumns(xvals, cols);
+}
+
+/*!
+    @brief      Starts writing the data file of the current window in the background (the results
+    are not modified while plotting).
+    @param      xvals     The x values vector, simulation vector.
+    @param      cols      The columns, y values.
+*/
+void GNU_plotter::sendColumns(const std::vector<double> &xvals, const std::vector<text_column_t> &cols)
+{
+    this->_total += xvals.size();
+    this->_windows.back().points = std::async(std::launch::async, writePlotData, this->_file_names.back(),
+                                              std::cref(xvals), cols, this->_method, this->_buckets);
 }
 
 /*!
@@ -257,9 +342,8 @@ void GNU_plotter::setPlotOptions(analysis_t type, as_scale_t scale, std::string
     xlabel += "\n";
     ylabel += "\n";
 
-    /* Form the commands and send */
-    string commands = title + xlabel + ylabel + legend + grid + scaleauto;
-    fprintf(this->_pipe, "%s", commands.c_str());
+    /* Form the commands, sent with the window */
+    this->_windows.back().commands += title + xlabel + ylabel + legend + grid + scaleauto;
 }
 
 /*!
@@ -342,6 +426,9 @@ void GNU_plotter::plot(circuit &circuit_manager, simulator &simulator_manager)
             finalize(plotnodes);
         }
 	}
+
+	/* The last window */
+	sendWindows(this->_windows.size());
 }
 
 /*!
@@ -362,11 +449,10 @@ void print_cout(circuit &circuit_manager, simulator &simulator_manager)
         std::cout << "Branch currents:\n";
 
         auto &res = simulator_manager.SourceResults();
-        auto &tmp = res.front();
 
-        for(size_t i = 0; i < tmp.size(); i++)
+        for(size_t i = 0; i < res.Cols(); i++)
         {
-            std::cout << "\t" << plotsources[i] << ": "  << tmp[i] << "\n";
+            std::cout << "\t" << plotsources[i] << ": "  << res.Get(0, i) << "\n";
         }
     }
 
@@ -376,15 +462,85 @@ void print_cout(circuit &circuit_manager, simulator &simulator_manager)
         std::cout << "Node Voltages:\n";
 
         auto &res = simulator_manager.NodesResults();
-        auto &tmp = res.front();
 
-        for(size_t i = 0; i < tmp.size(); i++)
+        for(size_t i = 0; i < res.Cols(); i++)
         {
-            std::cout << "\t" << plotnodes[i] << ": "  << tmp[i] << "\n";
+            std::cout << "\t" << plotnodes[i] << ": "  << res.Get(0, i) << "\n";
         }
     }
 }
 
+/*!
+    @brief      Exports the results (PRINT or PLOT cards) to a text file, a header row with the names
+    and a row per point, the scale first (except for OP). The numbers are in the shortest form that
+    reads back to the same double. For AC the magnitude (dB for a logarithmic scale) and the phase
+    in degrees of every variable are written.
+    @param      circuit_manager     The simulated circuit.
+    @param      simulator_manager   The simulator engine, containing the results of the simulation.
+    @param      file                The file.
+    @param      separator           The separator of the columns (',' for CSV, '\t' for TSV).
+    @return     The error code, in case of error, otherwise RETURN_SUCCESS.
+*/
+return_codes_e export_text(circuit &circuit_manager, simulator &simulator_manager, const std::string &file, char separator)
+{
+    auto lower = [](std::string name) { std::transform(name.begin(), name.end(), name.begin(), ::tolower); return name; };
+    auto analysis_type = circuit_manager.AnalysisType();
+    bool log = (circuit_manager.AnalysisScale() == LOG_SCALE);
+
+    std::vector<std::string> names;
+    std::vector<text_column_t> cols;
+
+    switch(analysis_type)
+    {
+        case TRAN: names.push_back("time"); break;
+        case AC: names.push_back("frequency"); break;
+        case DC: names.push_back(lower(circuit_manager.DCSource())); break;
+        default: break;
+    }
+
+    /* The columns, nodes then sources */
+    auto add = [&](const std::vector<std::string> &vars, const char *type, auto &res, auto &res_cd)
+    {
+        for(size_t k = 0; k < vars.size(); k++)
+        {
+            std::string name = lower(vars[k]) + ")";
+            text_column_t col;
+            col.col = k;
+
+            if(analysis_type != AC)
+            {
+                col.real = &res;
+                names.push_back(type + ("(" + name));
+                cols.push_back(col);
+                continue;
+            }
+
+            col.complex = &res_cd;
+            col.transform = log ? TEXT_DB : TEXT_MAG;
+            names.push_back(type + std::string(log ? "db(" : "m(") + name);
+            cols.push_back(col);
+
+            col.transform = TEXT_PHASE;
+            names.push_back(type + ("p(" + name));
+            cols.push_back(col);
+        }
+    };
+
+    add(circuit_manager.PlotNodes(), "v", simulator_manager.NodesResults(), simulator_manager.NodesResultsCd());
+    add(circuit_manager.PlotSources(), "i", simulator_manager.SourceResults(), simulator_manager.SourceResultsCd());
+
+    /* OP has a single point and no scale */
+    auto &xvals = simulator_manager.SimulationVec();
+    const double *scale = (analysis_type != OP) ? xvals.data() : nullptr;
+    size_t rows = (analysis_type != OP) ? xvals.size() : 1;
+
+    text_writer writer(file, separator);
+    writer.Header(names);
+    writer.Write(scale, rows, cols);
+
+    return writer.Flush() ? RETURN_SUCCESS : FAIL_SIMULATOR_OUTPUT;
+}
+
 /*!
     @brief      Wrapper that calls the appropriate routines for plotting of data.
     @param      circuit_manager     The simulated circuit.
@@ -399,8 +555,13 @@ return_codes_e plot(circuit &circuit_manager, simulator &simulator_manager)
     /* OP analysis needs only printing of the values */
     if(circuit_manager.AnalysisType() != OP)
     {
-        GNU_plotter plotter;
+        GNU_plotter plotter(circuit_manager.Options().downsample, circuit_manager.Options().plot_points);
+        size_t sent, total;
+
         plotter.plot(circuit_manager, simulator_manager);
+        plotter.Points(sent, total);
+
+        if(sent < total) std::cout << "[INFO]: Plots downsampled to " << sent << " of " << total << " points (the results keep every point)\n";
     }
     else
     {
@@ -3,5 +3,6 @@
 
 #include "sim_engine.hpp"
 return_codes_e plot(circuit &circuit_manager, simulator &simulator_manager);
+return_codes_e export_text(circuit &circuit_manager, simulator &simulator_manager, const std::string &file, char separator);
 
 #endif // __PLOT_H //
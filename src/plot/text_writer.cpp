@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <omp.h>
+#include "text_writer.hpp"
+
+/*!
+    @brief      Constructor, opens the file.
+    @param      file        The file.
+    @param      separator   The separator of the columns (e.g. ',' or '\t').
+    @param      precision   Significant digits, 0 for the shortest form that reads back to the same value.
+*/
+text_writer::text_writer(const std::string &file, char separator, int precision)
+                         : _out(file, std::ios::binary | std::ios::trunc), _separator(separator), _precision(precision)
+{
+}
+
+/*!
+    @brief      Writes the header row, the names of the columns.
+    @param      names       The names (scale first).
+*/
+void text_writer::Header(const std::vector<std::string> &names)
+{
+    std::string row;
+
+    for(size_t k = 0; k < names.size(); k++)
+    {
+        if(k) row += _separator;
+        row += names[k];
+    }
+
+    row += '\n';
+    _out.write(row.data(), row.size());
+}
+
+/*!
+    @brief      Writes the rows of the samples. Groups of blocks of rows are formatted in parallel,
+    every block in its own buffer, and the buffers are written in order.
+    @param      scale       The scale (time/frequency/sweep) of the rows, first column (none when null).
+    @param      rows        The number of rows.
+    @param      cols        The columns.
+*/
+void text_writer::Write(const double *scale, size_t rows, const std::vector<text_column_t> &cols)
+{
+    size_t row_bytes = (cols.size() + 1) * (_number_bytes + 1) + 1;
+    size_t block_rows = std::clamp<size_t>(_block_bytes / row_bytes, 1, _max_block_rows);
+    size_t group = omp_get_max_threads();
+
+    _text.resize(group);
+    _values.resize(group);
+
+    for(size_t first = 0; first < rows; first += group * block_rows)
+    {
+        size_t blocks = std::min(group, (rows - first + block_rows - 1) / block_rows);
+
+        #pragma omp parallel for schedule(static, 1) if(blocks > 1)
+        for(size_t b = 0; b < blocks; b++)
+        {
+            size_t begin = first + b * block_rows;
+            FormatBlock(scale, begin, std::min(block_rows, rows - begin), cols, _text[b], _values[b]);
+        }
+
+        for(size_t b = 0; b < blocks; b++) _out.write(_text[b].data(), _text[b].size());
+    }
+}
+
+/*!
+    @brief      Writes the rest of the file and flushes it.
+    @return     True in case of success, otherwise false.
+*/
+bool text_writer::Flush(void)
+{
+    _out.flush();
+    return static_cast<bool>(_out);
+}
+
+/*!
+    @brief      Computes the transform of the samples of a column (the values written), read from the
+    results (decoded, see result_store).
+    @param      col         The column.
+    @param      first       The first sample.
+    @param      count       The number of samples.
+    @param      out         The values.
+*/
+void text_writer::Transform(const text_column_t &col, size_t first, size_t count, double *out)
+{
+    if(col.complex)
+    {
+        std::complex<double> in[_read_rows];
+
+        for(size_t done = 0; done < count; done += _read_rows, out += _read_rows)
+        {
+            size_t n = std::min(_read_rows, count - done);
+            col.complex->Read(col.col, first + done, n, in);
+
+            switch(col.transform)
+            {
+                case TEXT_DB: for(size_t i = 0; i < n; i++) out[i] = 20 * std::log10(std::abs(in[i])); break;
+                case TEXT_PHASE: for(size_t i = 0; i < n; i++) out[i] = std::arg(in[i]) * 180 / M_PI; break;
+                default: for(size_t i = 0; i < n; i++) out[i] = std::abs(in[i]); break;
+            }
+        }
+    }
+    else
+    {
+        col.real->Read(col.col, first, count, out);
+
+        if(col.transform == TEXT_DB) for(size_t i = 0; i < count; i++) out[i] = 20 * std::log10(out[i]);
+    }
+}
+
+/*!
+    @brief      Formats a block of rows. The transforms (magnitude, dB, phase) are computed first,
+    column by column, then the rows are formatted.
+    @param      scale       The scale of the rows (none when null).
+    @param      first       The first row of the block.
+    @param      count       The rows of the block.
+    @param      cols        The columns.
+    @param      text        The formatted rows.
+    @param      values      Workspace of the transformed samples (column-major).
+*/
+void text_writer::FormatBlock(const double *scale, size_t first, size_t count, const std::vector<text_column_t> &cols,
+                              std::vector<char> &text, std::vector<double> &values) const
+{
+    size_t ncols = cols.size();
+    values.resize(ncols * count);
+
+    /* The transforms of the block, column by column */
+    for(size_t k = 0; k < ncols; k++) Transform(cols[k], first, count, values.data() + k * count);
+
+    /* The rows, the buffer has room for the longest ones */
+    text.resize(count * ((ncols + 1) * (_number_bytes + 1) + 1));
+
+    char *pos = text.data();
+
+    for(size_t i = 0; i < count; i++)
+    {
+        if(scale) pos = Number(pos, scale[first + i]);
+
+        for(size_t k = 0; k < ncols; k++)
+        {
+            if(scale || k) *pos++ = _separator;
+            pos = Number(pos, values[k * count + i]);
+        }
+
+        *pos++ = '\n';
+    }
+
+    text.resize(pos - text.data());
+}
+
+/*!
+    @brief      Formats a number.
+    @param      pos         Where to format it (room for _number_bytes).
+    @param      val         The number.
+    @return     The end of the number.
+*/
+char *text_writer::Number(char *pos, double val) const
+{
+    if(_precision > 0) return std::to_chars(pos, pos + _number_bytes, val, std::chars_format::general, _precision).ptr;
+
+    return std::to_chars(pos, pos + _number_bytes, val).ptr;
+}
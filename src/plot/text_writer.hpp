@@ -0,0 +1,71 @@
+#ifndef __TEXT_WRITER_H
+#define __TEXT_WRITER_H
+
+#include <complex>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "result_store.hpp"
+
+/** Transform of the samples of a column, applied before formatting. */
+typedef enum text_transforms
+{
+    TEXT_VALUE = 0,     //!< The value (real samples).
+    TEXT_DB,            //!< 20 * log10 of the value (real samples) or of the magnitude (complex samples).
+    TEXT_MAG,           //!< The magnitude (complex samples).
+    TEXT_PHASE,         //!< The phase in degrees (complex samples).
+} text_transform_t;
+
+/** A column of a text file, a column of the results (one of real/complex is set). */
+typedef struct text_column
+{
+    const result_store<double> *real = nullptr;                     //!< Real results.
+    const result_store<std::complex<double>> *complex = nullptr;    //!< Complex results.
+    size_t col = 0;                                                 //!< The column of the results.
+    text_transform_t transform = TEXT_VALUE;        //!< The transform of the samples.
+} text_column_t;
+
+//! Writer of numeric text files (gnuplot data, CSV/TSV), a row per point.
+/*!
+  The numbers are formatted with std::to_chars, in the shortest form that reads back to the same
+  double (precision 0) or with a number of significant digits (as printf %g), directly in memory,
+  so there is no stream formatting and no flush per row.\n
+  The rows are split in blocks, the transforms (magnitude, dB, phase) of a block are computed
+  column by column before its rows are formatted. The blocks are formatted in parallel, each in
+  its own buffer, and written to the file in order with a single write per block.
+*/
+class text_writer
+{
+    public:
+        text_writer(const std::string &file, char separator, int precision = 0);
+
+        void Header(const std::vector<std::string> &names);
+        void Write(const double *scale, size_t rows, const std::vector<text_column_t> &cols);
+        bool Flush(void);
+
+        static void Transform(const text_column_t &col, size_t first, size_t count, double *out);
+
+        /*!
+            @brief      Returns whether the file was opened and all the writes succeeded so far.
+            @return     True in case of success, otherwise false.
+        */
+        bool Valid(void) const noexcept { return static_cast<bool>(_out); }
+
+    private:
+        void FormatBlock(const double *scale, size_t first, size_t count, const std::vector<text_column_t> &cols,
+                         std::vector<char> &text, std::vector<double> &values) const;
+        char *Number(char *pos, double val) const;
+
+        static constexpr size_t _block_bytes = 1024 * 1024;     //!< Target size of the text of a block.
+        static constexpr size_t _max_block_rows = 4096;         //!< Maximum rows of a block.
+        static constexpr size_t _number_bytes = 32;             //!< Maximum length of a formatted number.
+        static constexpr size_t _read_rows = 256;               //!< Complex samples read at a time by the transforms.
+
+        std::ofstream _out;                         //!< The file.
+        char _separator;                            //!< The separator of the columns.
+        int _precision;                             //!< Significant digits, 0 for the shortest round-trip form.
+        std::vector<std::vector<char>> _text;       //!< The formatted rows, per block of a group.
+        std::vector<std::vector<double>> _values;   //!< Workspace of the transformed samples, per block of a group.
+};
+
+#endif // __TEXT_WRITER_H //
@@ -0,0 +1,124 @@
+#include "breakpoints.hpp"
+
+/*!
+    @brief    Default constructor.
+*/
+breakpoint_queue::breakpoint_queue() noexcept
+{
+    _tstop = 0;
+    _eps = 0;
+    _nonlinear = false;
+}
+
+/*!
+    @brief      Adds the corners of a transient source. Only the timing parameters are kept,
+    sources with the same timing are merged into one generator.
+    @param      type        The type of the source.
+    @param      tvals       The time values (PWL only).
+    @param      vvals       The parameters of the source.
+*/
+void breakpoint_queue::AddSource(tran_source_t type, const std::vector<double> &tvals, const std::vector<double> &vvals)
+{
+    std::vector<double> params;
+
+    switch(type)
+    {
+        case EXP_SOURCE: params = {vvals[2], vvals[4]}; break;                                  /* td1, td2 */
+        case SINE_SOURCE: params = {vvals[3]}; break;                                           /* td */
+        case PULSE_SOURCE: params = {vvals[2], vvals[3], vvals[4], vvals[5], vvals[6]}; break;  /* td, tr, tf, pw, per */
+        case PWL_SOURCE: params = tvals; break;
+        default: return; /* Constant, no corners */
+    }
+
+    _nonlinear |= (type == EXP_SOURCE || type == SINE_SOURCE);
+
+    /* Type first in the key, the parameters have different meaning per type */
+    std::vector<double> key = params;
+    key.insert(key.begin(), static_cast<double>(type));
+
+    if(_keys.insert(std::move(key)).second) _gens.push_back({type, std::move(params), 0});
+}
+
+/*!
+    @brief      Prepares the queue for a simulation, with the first corner of every source
+    after the start time.
+    @param      tstart      Start of the simulation.
+    @param      tstop       End of the simulation.
+    @param      eps         Time resolution, corners closer than this are merged.
+*/
+void breakpoint_queue::Build(double tstart, double tstop, double eps)
+{
+    _tstop = tstop;
+    _eps = eps;
+    _heap = decltype(_heap)();
+
+    for(size_t idx = 0; idx < _gens.size(); idx++)
+    {
+        double time = 0;
+        bool found = false;
+        auto &gen = _gens[idx];
+        gen.next = 0;
+
+        while((found = Corner(gen, time)) && time <= tstart + eps);
+
+        if(found && time < tstop - eps) _heap.push({time, idx});
+    }
+}
+
+/*!
+    @brief      Returns the first breakpoint after a given time, the ones up to the time are
+    dropped. In case there are no more breakpoints, the end of the simulation is returned.
+    @param      time        The current time.
+    @return     The next breakpoint.
+*/
+double breakpoint_queue::Next(double time)
+{
+    while(!_heap.empty() && _heap.top().first <= time + _eps)
+    {
+        double corner;
+        size_t idx = _heap.top().second;
+        _heap.pop();
+
+        /* Next corner of the same generator */
+        if(Corner(_gens[idx], corner) && corner < _tstop - _eps) _heap.push({corner, idx});
+    }
+
+    return _heap.empty() ? _tstop : _heap.top().first;
+}
+
+/*!
+    @brief      Generates the next corner of a source, in increasing time order.
+    @param      gen         The generator.
+    @param      time        The corner time.
+    @return     True in case of a new corner, otherwise false (no more corners).
+*/
+bool breakpoint_queue::Corner(generator_t &gen, double &time)
+{
+    auto &p = gen.params;
+    size_t idx = gen.next++;
+
+    switch(gen.type)
+    {
+        case EXP_SOURCE:
+        case SINE_SOURCE:
+        case PWL_SOURCE:
+        {
+            if(idx >= p.size()) return false;
+            time = p[idx];
+            return true;
+        }
+        case PULSE_SOURCE:
+        {
+            /* Rise start, rise end, fall start, fall end of every period */
+            const double td = p[0], tr = p[1], tf = p[2], pw = p[3], per = p[4];
+            const double offsets[4] = {0, tr, tr + pw, tr + pw + tf};
+            size_t period = idx / 4;
+
+            if(period > 0 && !(per > 0)) return false;
+
+            time = td + period * per + offsets[idx % 4];
+            return true;
+        }
+        default: return false;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef __BREAKPOINTS_H
+#define __BREAKPOINTS_H
+
+#include <queue>
+#include <set>
+#include <vector>
+#include "simulator_types.hpp"
+
+//! Queue of the transient source breakpoints (corners), in time order.
+/*!
+  Every transient source has a known set of times where its value or its derivative is
+  discontinuous (PULSE edges, PWL points, EXP and SIN delays). The time stepper lands exactly
+  on them, instead of stepping over the corners.\n
+  The corners are generated lazily per source and merged with a min-heap, so the memory is
+  proportional to the number of sources and not to the number of periods. Sources with the
+  same corner times (e.g. clocks with the same timing) share one generator.
+*/
+class breakpoint_queue
+{
+    public:
+        /* Constructors */
+        breakpoint_queue() noexcept;
+
+        void AddSource(tran_source_t type, const std::vector<double> &tvals, const std::vector<double> &vvals);
+        void Build(double tstart, double tstop, double eps);
+        double Next(double time);
+
+        /*!
+            @brief      Returns whether all the sources are linear between the breakpoints (PULSE, PWL).
+            @return     True in case of piecewise linear sources, otherwise false.
+        */
+        bool PiecewiseLinear(void) const noexcept { return !_nonlinear; }
+
+    private:
+        /** Corner generator of one (or more identical) sources. */
+        typedef struct breakpoint_generator
+        {
+            tran_source_t type;             //!< The type of the source.
+            std::vector<double> params;     //!< The timing parameters (PWL: the time points).
+            size_t next;                    //!< Index of the next corner.
+        } generator_t;
+
+        typedef std::pair<double, size_t> entry_t;   //!< Corner time and generator.
+
+        bool Corner(generator_t &gen, double &time);
+
+        std::vector<generator_t> _gens;                                                         //!< The generators.
+        std::set<std::vector<double>> _keys;                                                    //!< Type and parameters of the generators (deduplication).
+        std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> _heap;        //!< Next corner of each generator.
+        double _tstop;                                                                          //!< End of the simulation.
+        double _eps;                                                                            //!< Time resolution.
+        bool _nonlinear;                                                                        //!< Sources that are not linear between the breakpoints (EXP, SIN).
+};
+
+#endif // __BREAKPOINTS_H //
@@ -0,0 +1,357 @@
+#include <algorithm>
+#include "btf_solver.hpp"
+
+extern "C" {
+#include <btf.h>
+}
+
+/** btf_order for the index type of the matrices (int/long) */
+static inline int btf_order_idx(int n, int Ap[], int Ai[], double maxwork, double *work, int P[], int Q[], int R[], int *nmatch, int Work[])
+{
+    return btf_order(n, Ap, Ai, maxwork, work, P, Q, R, nmatch, Work);
+}
+
+static inline long int btf_order_idx(long int n, long int Ap[], long int Ai[], double maxwork, double *work, long int P[], long int Q[], long int R[],
+                                     long int *nmatch, long int Work[])
+{
+    return btf_l_order(n, Ap, Ai, maxwork, work, P, Q, R, nmatch, Work);
+}
+
+/*!
+    @brief      Computes the block triangular form of the matrix and performs the
+    symbolic analysis of every diagonal block.
+    @param      mat     The matrix.
+    @return     True in case of success, otherwise false (structurally singular matrix).
+*/
+template<typename MatTp>
+bool btf_linear_solver<MatTp>::analyze(const MatTp &mat)
+{
+    auto begin = std::chrono::high_resolution_clock::now();
+
+    MatTp tmp;
+    const MatTp *src = &mat;
+
+    /* The value mapping needs the compressed form */
+    if(!mat.isCompressed())
+    {
+        tmp = mat;
+        tmp.makeCompressed();
+        src = &tmp;
+    }
+
+    _dim = src->cols();
+    _nnz = src->nonZeros();
+    _blocks.clear();
+    _levels.clear();
+
+    /* 1) Orderings - Row matching and blocks of the variables */
+    std::vector<IntTp> row_var, var_block;
+    IntTp block_num = BlockOrder(*src, row_var, var_block);
+    if(block_num == 0) return false;
+
+    /* 2) Variables and equations of each block */
+    std::vector<IntTp> var_local(_dim);
+    std::vector<IntTp> var_row(_dim);
+    _blocks.resize(block_num);
+
+    for(IntTp row = 0; row < _dim; row++) var_row[row_var[row]] = row;
+
+    for(IntTp var = 0; var < _dim; var++)
+    {
+        auto &block = _blocks[var_block[var]];
+        var_local[var] = block.vars.size();
+        block.vars.push_back(var);
+        block.rows.push_back(var_row[var]);
+    }
+
+    /* 3) Diagonal block patterns (with the value mapping) and entries outside of the blocks */
+    const IntTp *outer = src->outerIndexPtr();
+    const IntTp *inner = src->innerIndexPtr();
+    std::vector<std::pair<IntTp, IntTp>> entries;
+
+    for(IntTp k = 0; k < block_num; k++)
+    {
+        auto &block = _blocks[k];
+        IntTp block_sz = block.vars.size();
+        std::vector<IntTp> col_count(block_sz, 0);
+
+        for(IntTp col = 0; col < block_sz; col++)
+        {
+            IntTp var = block.vars[col];
+            for(IntTp idx = outer[var]; idx < outer[var + 1]; idx++)
+            {
+                IntTp row_block = var_block[row_var[inner[idx]]];
+                IntTp local_row = var_local[row_var[inner[idx]]];
+
+                if(row_block == k) col_count[col]++;
+                else _blocks[row_block].off.push_back({local_row, var, idx});
+            }
+        }
+
+        /* Rows are sorted inside the columns after compression, keep the same order for the mapping */
+        block.mat.resize(block_sz, block_sz);
+        block.mat.reserve(col_count);
+
+        for(IntTp col = 0; col < block_sz; col++)
+        {
+            IntTp var = block.vars[col];
+            entries.clear();
+
+            for(IntTp idx = outer[var]; idx < outer[var + 1]; idx++)
+            {
+                if(var_block[row_var[inner[idx]]] == k) entries.push_back({var_local[row_var[inner[idx]]], idx});
+            }
+
+            std::sort(entries.begin(), entries.end());
+            for(auto &entry : entries)
+            {
+                block.mat.insert(entry.first, col) = 1;
+                block.val_map.push_back(entry.second);
+            }
+        }
+
+        block.mat.makeCompressed();
+    }
+
+    /* Workspaces, the solves do not allocate for a single right hand side */
+    for(auto &block : _blocks)
+    {
+        block.off_vals.resize(block.off.size());
+        block.work.resize(block.vars.size(), 1);
+    }
+
+    /* 4) Dependency levels, blocks only depend on previous blocks */
+    std::vector<IntTp> block_level(block_num, 0);
+
+    for(IntTp k = 0; k < block_num; k++)
+    {
+        for(auto &entry : _blocks[k].off)
+        {
+            block_level[k] = std::max(block_level[k], block_level[var_block[entry.col]] + 1);
+        }
+
+        if(block_level[k] >= (IntTp)_levels.size()) _levels.resize(block_level[k] + 1);
+        _levels[block_level[k]].push_back(k);
+    }
+
+    /* 5) Symbolic analysis of the blocks, in parallel */
+    #pragma omp parallel for schedule(dynamic)
+    for(IntTp k = 0; k < block_num; k++)
+    {
+        auto &block = _blocks[k];
+        if(block.vars.size() == 1) continue;
+
+        block.solver = std::make_unique<BlockSolverTp>();
+        block.solver->analyzePattern(block.mat);
+    }
+
+    /* Statistics */
+    this->_stats.blocks = block_num;
+    this->_stats.levels = _levels.size();
+    this->_stats.block_size.resize(block_num);
+    this->_stats.block_time.assign(block_num, 0);
+
+    for(IntTp k = 0; k < block_num; k++) this->_stats.block_size[k] = _blocks[k].vars.size();
+
+    this->_stats.analyze_count++;
+    this->_stats.analyze_time += this->elapsed(begin);
+
+    return true;
+}
+
+/*!
+    @brief      Performs the numeric factorization of the diagonal blocks in parallel.
+    The matrix must have the same pattern as the analyzed one.
+    @param      mat     The matrix.
+    @return     True in case of success, otherwise false.
+*/
+template<typename MatTp>
+bool btf_linear_solver<MatTp>::refactor(const MatTp &mat)
+{
+    auto begin = std::chrono::high_resolution_clock::now();
+
+    MatTp tmp;
+    const MatTp *src = &mat;
+
+    if(!mat.isCompressed())
+    {
+        tmp = mat;
+        tmp.makeCompressed();
+        src = &tmp;
+    }
+
+    if(src->cols() != _dim || src->nonZeros() != _nnz) return false;
+
+    const ScalarTp *vals = src->valuePtr();
+    IntTp block_num = _blocks.size();
+    bool ret = true;
+
+    /* All the blocks are independent during the factorization */
+    #pragma omp parallel for schedule(dynamic) reduction(&&:ret)
+    for(IntTp k = 0; k < block_num; k++)
+    {
+        auto block_begin = std::chrono::high_resolution_clock::now();
+        ret = FactorBlock(_blocks[k], vals) && ret;
+        this->_stats.block_time[k] += this->elapsed(block_begin);
+    }
+
+    this->_stats.factor_count++;
+    this->_stats.factor_time += this->elapsed(begin);
+
+    return ret;
+}
+
+/*!
+    @brief      Solves the factorized system for one right hand side.
+    @param      rh      The right hand side.
+    @param      sol     The solution.
+    @return     True in case of success, otherwise false.
+*/
+template<typename MatTp>
+bool btf_linear_solver<MatTp>::solve(const VecTp &rh, VecTp &sol)
+{
+    auto begin = std::chrono::high_resolution_clock::now();
+    bool ret = SolveBlocks(rh, sol);
+
+    this->_stats.solve_count++;
+    this->_stats.solve_time += this->elapsed(begin);
+
+    return ret;
+}
+
+/*!
+    @brief      Solves the factorized system for many right hand sides.
+    @param      rh      The right hand sides (columns).
+    @param      sol     The solutions (columns).
+    @return     True in case of success, otherwise false.
+*/
+template<typename MatTp>
+bool btf_linear_solver<MatTp>::solveMulti(const MultiVecTp &rh, MultiVecTp &sol)
+{
+    auto begin = std::chrono::high_resolution_clock::now();
+    bool ret = SolveBlocks(rh, sol);
+
+    this->_stats.solve_count += rh.cols();
+    this->_stats.solve_time += this->elapsed(begin);
+
+    return ret;
+}
+
+/*!
+    @brief      Computes the block triangular form of the matrix with btf_order (SuiteSparse BTF):
+    a maximum transversal gives a zero-free diagonal and the strongly connected components of the
+    matched graph are the diagonal blocks. BTF orders the blocks upper triangular, they are numbered
+    here in reverse, so that each block depends only on the blocks with lower indices.
+    @param      mat         The matrix (compressed).
+    @param      row_var     The variable matched to each row.
+    @param      var_block   The block of each variable.
+    @return     The number of blocks, 0 in case of a structurally singular matrix.
+*/
+template<typename MatTp>
+IntTp btf_linear_solver<MatTp>::BlockOrder(const MatTp &mat, std::vector<IntTp> &row_var, std::vector<IntTp> &var_block)
+{
+    std::vector<IntTp> P(_dim), Q(_dim), R(_dim + 1), work(5 * _dim);
+    IntTp *outer = const_cast<IntTp *>(mat.outerIndexPtr());
+    IntTp *inner = const_cast<IntTp *>(mat.innerIndexPtr());
+    IntTp nmatch = 0;
+    double flops = 0;
+
+    IntTp block_num = btf_order_idx(_dim, outer, inner, 0, &flops, P.data(), Q.data(), R.data(), &nmatch, work.data());
+    if(nmatch < _dim) return 0;
+
+    row_var.resize(_dim);
+    var_block.resize(_dim);
+
+    for(IntTp b = 0; b < block_num; b++)
+    {
+        for(IntTp k = R[b]; k < R[b + 1]; k++)
+        {
+            row_var[P[k]] = Q[k];
+            var_block[Q[k]] = block_num - 1 - b;
+        }
+    }
+
+    return block_num;
+}
+
+/*!
+    @brief      Loads the values of a block from the system matrix and factorizes it.
+    @param      block   The block.
+    @param      vals    The values of the system matrix.
+    @return     True in case of success, otherwise false.
+*/
+template<typename MatTp>
+bool btf_linear_solver<MatTp>::FactorBlock(block_t &block, const ScalarTp *vals)
+{
+    ScalarTp *block_vals = block.mat.valuePtr();
+    IntTp nnz = block.val_map.size();
+
+    for(IntTp idx = 0; idx < nnz; idx++) block_vals[idx] = vals[block.val_map[idx]];
+    for(size_t idx = 0; idx < block.off.size(); idx++) block.off_vals[idx] = vals[block.off[idx].idx];
+
+    /* Singleton blocks are solved with a division */
+    if(!block.solver) return block_vals[0] != ScalarTp(0);
+
+    block.solver->factorize(block.mat);
+    return block.solver->info() == Eigen::Success;
+}
+
+/*!
+    @brief      Solves the blocks level by level, the blocks of each level in parallel. Every
+    block is solved in place in its workspace, sized once for a single right hand side.
+    @param      rh      The right hand side(s).
+    @param      sol     The solution(s).
+    @return     True in case of success, otherwise false.
+*/
+template<typename MatTp>
+template<typename DenseTp>
+bool btf_linear_solver<MatTp>::SolveBlocks(const DenseTp &rh, DenseTp &sol)
+{
+    bool ret = true;
+    sol.resize(rh.rows(), rh.cols());
+
+    for(auto &level : _levels)
+    {
+        IntTp level_sz = level.size();
+
+        #pragma omp parallel for schedule(dynamic) reduction(&&:ret) if(level_sz > 1)
+        for(IntTp idx = 0; idx < level_sz; idx++)
+        {
+            auto block_begin = std::chrono::high_resolution_clock::now();
+            auto &block = _blocks[level[idx]];
+            IntTp block_sz = block.vars.size();
+            auto &local = block.work;
+
+            local.resize(block_sz, rh.cols());
+
+            /* Right hand side minus the contributions of the solved blocks */
+            for(IntTp row = 0; row < block_sz; row++) local.row(row) = rh.row(block.rows[row]);
+
+            for(size_t off = 0; off < block.off.size(); off++)
+            {
+                local.row(block.off[off].row) -= block.off_vals[off] * sol.row(block.off[off].col);
+            }
+
+            /* In place, the block solvers copy the right hand side to the solution first */
+            if(block.solver)
+            {
+                local = block.solver->solve(local);
+                ret = (block.solver->info() == Eigen::Success) && ret;
+            }
+            else
+            {
+                local /= block.mat.valuePtr()[0];
+            }
+
+            for(IntTp row = 0; row < block_sz; row++) sol.row(block.vars[row]) = local.row(row);
+
+            this->_stats.block_time[level[idx]] += this->elapsed(block_begin);
+        }
+    }
+
+    return ret;
+}
+
+/* Explicit instantiations - Real and complex systems */
+template class btf_linear_solver<SparMatD>;
+template class btf_linear_solver<SparMatCompD>;
@@ -0,0 +1,82 @@
+#ifndef __BTF_SOLVER_H
+#define __BTF_SOLVER_H
+
+#include "linear_solver.hpp"
+
+/* Solver of the diagonal blocks, BTF is built along with KLU (SuiteSparse) */
+#include "KLUSupport"
+
+/** KLU for the diagonal blocks */
+template<typename MatTp> using btf_block_solver = Eigen::KLU<MatTp>;
+
+//! Linear solver on the block triangular form (BTF) of the system, with parallel blocks.
+/*!
+  The system is permuted to block triangular form with SuiteSparse BTF (btf_order), the same
+  ordering KLU uses internally:
+  - A maximum transversal (row matching) gives a zero-free diagonal.
+  - The strongly connected components of the matched graph are the diagonal blocks,
+  ordered so that every block depends only on the blocks before it.\n
+  The diagonal blocks are factorized independently and in parallel (OpenMP). The solve
+  groups the blocks in dependency levels, the blocks of the same level are solved in
+  parallel after subtracting the contributions of the already solved levels.
+  Circuits made of independent or weakly coupled parts (e.g. power grids of different
+  domains) split in many blocks, while a fully coupled circuit ends up in a single block.
+*/
+template<typename MatTp>
+class btf_linear_solver : public linear_solver<MatTp>
+{
+    public:
+        typedef linear_solver<MatTp> BaseTp;                //!< The interface.
+        typedef typename BaseTp::ScalarTp ScalarTp;         //!< Scalar of the system.
+        typedef typename BaseTp::VecTp VecTp;               //!< Dense vector type.
+        typedef typename BaseTp::MultiVecTp MultiVecTp;     //!< Dense multi-vector type.
+        typedef btf_block_solver<MatTp> BlockSolverTp;      //!< Solver of the diagonal blocks.
+
+        /*!
+            @brief      Constructor.
+            @param      type    The type of the implementation.
+        */
+        btf_linear_solver(solver_t type) noexcept : BaseTp(type) {}
+
+        /* Solver phases */
+        bool analyze(const MatTp &mat) override;
+        bool refactor(const MatTp &mat) override;
+        bool solve(const VecTp &rh, VecTp &sol) override;
+        bool solveMulti(const MultiVecTp &rh, MultiVecTp &sol) override;
+
+    private:
+        /** Entry of a block row outside of the diagonal block. */
+        typedef struct off_block_entry
+        {
+            IntTp row;          //!< Local row in the block.
+            IntTp col;          //!< Global column (variable of a previous block).
+            IntTp idx;          //!< Index in the values of the system matrix.
+        } off_entry_t;
+
+        /** Diagonal block of the BTF. */
+        typedef struct btf_block
+        {
+            std::vector<IntTp> vars;                    //!< Global variables (columns) of the block.
+            std::vector<IntTp> rows;                    //!< Global equations (rows) of the block.
+            std::vector<IntTp> val_map;                 //!< System matrix value index, for each block non-zero.
+            std::vector<off_entry_t> off;               //!< Entries outside of the diagonal block.
+            std::vector<ScalarTp> off_vals;             //!< Values of the entries outside of the diagonal block.
+            MatTp mat;                                  //!< The diagonal block.
+            MultiVecTp work;                            //!< Workspace of the solves (a column per right hand side).
+            std::unique_ptr<BlockSolverTp> solver;      //!< Solver of the block (size > 1 only).
+        } block_t;
+
+        /* Ordering */
+        IntTp BlockOrder(const MatTp &mat, std::vector<IntTp> &row_var, std::vector<IntTp> &var_block);
+
+        /* Block operations */
+        bool FactorBlock(block_t &block, const ScalarTp *vals);
+        template<typename DenseTp> bool SolveBlocks(const DenseTp &rh, DenseTp &sol);
+
+        IntTp _dim = 0;                                 //!< Dimension of the system.
+        IntTp _nnz = 0;                                 //!< Non-zeros of the analyzed system.
+        std::vector<block_t> _blocks;                   //!< The diagonal blocks, in dependency order.
+        std::vector<std::vector<IntTp>> _levels;        //!< Blocks of each dependency level.
+};
+
+#endif // __BTF_SOLVER_H //
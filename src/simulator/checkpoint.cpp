@@ -0,0 +1,216 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include "checkpoint.hpp"
+
+/*!
+    @brief      Returns whether a checkpoint is due, the interval has passed since the last one
+    and no write is in progress.
+    @return     True when a checkpoint is due, otherwise false.
+*/
+bool checkpoint::Due(void)
+{
+    if(!(_interval > 0)) return false;
+
+    if(_pending.valid())
+    {
+        if(_pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+        Collect();
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - _last).count() >= _interval;
+}
+
+/*!
+    @brief      Writes a checkpoint in the background.
+    @param      state       The integrator state.
+    @param      rows        The rows of results after the previous checkpoint (flat).
+*/
+void checkpoint::Save(ckpt_state_t &&state, std::vector<double> &&rows)
+{
+    if(_pending.valid()) _pending.wait();
+    Collect();
+
+    _last = std::chrono::steady_clock::now();
+    _pending = std::async(std::launch::async, [this, state = std::move(state), rows = std::move(rows)]() { return Write(state, rows); });
+}
+
+/*!
+    @brief      Reads the last checkpoint.
+    @param      state       The integrator state.
+    @param      rows        All the rows of results up to the checkpoint (flat).
+    @return     True in case of success, otherwise false (no checkpoint or invalid).
+*/
+bool checkpoint::Load(ckpt_state_t &state, std::vector<double> &rows)
+{
+    std::ifstream in(_file, std::ios::binary);
+    char magic[sizeof(_magic)];
+    IntTp hist_sz = 0, meas_sz = 0;
+
+    auto get = [&](auto &val) { in.read(reinterpret_cast<char *>(&val), sizeof(val)); };
+
+    in.read(magic, sizeof(magic));
+    if(!in || std::memcmp(magic, _magic, sizeof(_magic))) return false;
+
+    get(state.method); get(state.adaptive); get(state.dim); get(state.tstop); get(state.step); get(state.nodes); get(state.sources); get(state.rows);
+    get(state.h); get(state.order); get(state.order_steps); get(state.accepted); get(state.rejected); get(state.breakpoints);
+    get(hist_sz);
+
+    if(!in || hist_sz <= 0 || state.dim <= 0 || state.rows <= 0) return false;
+
+    state.hist_t.resize(hist_sz);
+    state.hist_x.assign(hist_sz, DensVecD(state.dim));
+
+    for(auto &it : state.hist_t) get(it);
+    for(auto &it : state.hist_x) in.read(reinterpret_cast<char *>(it.data()), state.dim * sizeof(double));
+
+    /* The measurements */
+    get(meas_sz);
+    if(!in || meas_sz < 0) return false;
+
+    state.measures.resize(meas_sz);
+    in.read(reinterpret_cast<char *>(state.measures.data()), meas_sz * sizeof(double));
+
+    if(!in) return false;
+
+    /* The rows of another netlist (.PLOT/.SAVE) can't be read */
+    if(static_cast<size_t>(1 + state.nodes + state.sources) != _row_sz) return false;
+
+    /* The rows after the state (failed write) are ignored */
+    std::ifstream rows_in(_file + ".rows", std::ios::binary);
+    rows.resize(state.rows * _row_sz);
+    rows_in.read(reinterpret_cast<char *>(rows.data()), rows.size() * sizeof(double));
+
+    return rows_in.gcount() == static_cast<std::streamsize>(rows.size() * sizeof(double));
+}
+
+/*!
+    @brief      Removes the checkpoint files, at the start of a new simulation.
+*/
+void checkpoint::Reset(void)
+{
+    std::error_code err;
+
+    std::filesystem::remove(_file, err);
+    std::filesystem::remove(_file + ".rows", err);
+}
+
+/*!
+    @brief      Waits for the write in progress and removes the checkpoint files, at the end of
+    a complete simulation.
+*/
+void checkpoint::Finish(void)
+{
+    if(_pending.valid()) _pending.wait();
+    Collect();
+    Reset();
+}
+
+/*!
+    @brief      Collects the result of a finished write.
+*/
+void checkpoint::Collect(void)
+{
+    if(!_pending.valid()) return;
+
+    if(_pending.get()) _written++;
+    else std::cout << "[INFO]: Checkpoint write to " << _file << " failed\n";
+}
+
+/*!
+    @brief      Writes a checkpoint, the new rows are appended first and then the state replaces
+    the previous one.
+    @param      state       The integrator state.
+    @param      rows        The rows of results after the previous checkpoint (flat).
+    @return     True in case of success, otherwise false.
+*/
+bool checkpoint::Write(const ckpt_state_t &state, const std::vector<double> &rows) const
+{
+    namespace fs = std::filesystem;
+    std::string rows_file = _file + ".rows", tmp_file = _file + ".tmp";
+    std::error_code err;
+
+    /* Rows of the previous checkpoints only, the ones of a failed write are dropped */
+    uintmax_t start = (state.rows * _row_sz - rows.size()) * sizeof(double);
+    uintmax_t size = fs::exists(rows_file, err) ? fs::file_size(rows_file, err) : 0;
+
+    if(err || size < start) return false;
+    if(size > start) fs::resize_file(rows_file, start, err);
+    if(err) return false;
+
+    std::ofstream rows_out(rows_file, std::ios::binary | std::ios::app);
+    rows_out.write(reinterpret_cast<const char *>(rows.data()), rows.size() * sizeof(double));
+    rows_out.close();
+    if(!rows_out) return false;
+
+    /* The state, replaced atomically */
+    std::ofstream out(tmp_file, std::ios::binary | std::ios::trunc);
+    IntTp hist_sz = state.hist_x.size();
+
+    auto put = [&](const auto &val) { out.write(reinterpret_cast<const char *>(&val), sizeof(val)); };
+
+    out.write(_magic, sizeof(_magic));
+    put(state.method); put(state.adaptive); put(state.dim); put(state.tstop); put(state.step); put(state.nodes); put(state.sources); put(state.rows);
+    put(state.h); put(state.order); put(state.order_steps); put(state.accepted); put(state.rejected); put(state.breakpoints);
+    put(hist_sz);
+
+    for(auto &it : state.hist_t) put(it);
+    for(auto &it : state.hist_x) out.write(reinterpret_cast<const char *>(it.data()), state.dim * sizeof(double));
+
+    IntTp meas_sz = state.measures.size();
+    put(meas_sz);
+    out.write(reinterpret_cast<const char *>(state.measures.data()), meas_sz * sizeof(double));
+
+    out.close();
+    if(!out) return false;
+
+    return std::rename(tmp_file.c_str(), _file.c_str()) == 0;
+}
+
+/** File signature and version of the initial state files. */
+static constexpr char state_magic[8] = {'B', 'S', 'P', 'X', '0', '0', '0', '1'};
+
+/*!
+    @brief      Writes a solution of the system (the OP), to be used as the initial state of a
+    following transient. The file holds the signature, the dimension and the solution.
+    @param      file        The state file.
+    @param      x           The solution.
+    @return     True in case of success, otherwise false.
+*/
+bool writeStateFile(const std::string &file, const DensVecD &x)
+{
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    IntTp dim = x.size();
+
+    out.write(state_magic, sizeof(state_magic));
+    out.write(reinterpret_cast<const char *>(&dim), sizeof(dim));
+    out.write(reinterpret_cast<const char *>(x.data()), dim * sizeof(double));
+    out.close();
+
+    return static_cast<bool>(out);
+}
+
+/*!
+    @brief      Reads the initial state of the transient, written by writeStateFile().
+    @param      file        The state file.
+    @param      dim         The dimension of the system.
+    @param      x           The solution.
+    @return     True in case of success, otherwise false (no file, invalid or different system).
+*/
+bool readStateFile(const std::string &file, IntTp dim, DensVecD &x)
+{
+    std::ifstream in(file, std::ios::binary);
+    char magic[sizeof(state_magic)];
+    IntTp file_dim = 0;
+
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(&file_dim), sizeof(file_dim));
+    if(!in || std::memcmp(magic, state_magic, sizeof(state_magic)) || file_dim != dim) return false;
+
+    x.resize(dim);
+    in.read(reinterpret_cast<char *>(x.data()), dim * sizeof(double));
+
+    return static_cast<bool>(in);
+}
@@ -0,0 +1,85 @@
+#ifndef __CHECKPOINT_H
+#define __CHECKPOINT_H
+
+#include <chrono>
+#include <future>
+#include <string>
+#include "matrix_types.hpp"
+#include "simulator_types.hpp"
+
+/** The state of a transient integrator, saved in a checkpoint. */
+typedef struct transient_checkpoint_state
+{
+    IntTp method = 0;               //!< The ODE method (ODE_meth_t).
+    IntTp adaptive = 0;             //!< Adaptive timestep (1) or fixed (0).
+    IntTp dim = 0;                  //!< The dimension of the system.
+    double tstop = 0;               //!< End of the simulation.
+    double step = 0;                //!< The timestep of the TRAN card.
+    IntTp nodes = 0;                //!< Nodes in a row of results.
+    IntTp sources = 0;              //!< Sources in a row of results.
+    IntTp rows = 0;                 //!< Rows of results up to the checkpoint.
+    double h = 0;                   //!< The next timestep.
+    IntTp order = 0;                //!< The order of the next step (variable order BDF only).
+    IntTp order_steps = 0;          //!< Steps taken at the current order (variable order BDF only).
+    IntTp accepted = 0;             //!< Accepted timesteps.
+    IntTp rejected = 0;             //!< Rejected timesteps.
+    IntTp breakpoints = 0;          //!< Source breakpoints landed on.
+    std::vector<double> hist_t;     //!< Times of the solution history, the current time last.
+    std::vector<DensVecD> hist_x;   //!< The solution history, the current solution last.
+    std::vector<double> measures;   //!< The accumulators of the measurements, up to the checkpoint (see measure_engine).
+} ckpt_state_t;
+
+//! Periodic checkpoints of a transient simulation, written asynchronously.
+/*!
+  A checkpoint consists of two files:
+  - <file>: The integrator state (see ckpt_state_t), replaced atomically (written to a temporary
+  file and renamed) so a crash during a write leaves the previous checkpoint valid.
+  - <file>.rows: The rows of results (time, nodes, sources), appended. Every checkpoint appends
+  only the rows after the previous one, the rows after the last valid state are dropped.\n
+  The writes run in a separate thread, the time stepping only copies the state and the new rows.
+  A checkpoint is due when the wall clock interval has passed and the previous write is finished,
+  so a slow disk skips checkpoints instead of stalling the simulation.
+*/
+class checkpoint
+{
+    public:
+        /*!
+            @brief      Constructor.
+            @param      file        The checkpoint file.
+            @param      interval    The wall clock interval of the checkpoints (s, 0 for none).
+            @param      row_sz      The size of a row of results (time, nodes, sources).
+        */
+        checkpoint(const std::string &file, double interval, size_t row_sz) noexcept
+                   : _file(file), _interval(interval), _row_sz(row_sz), _last(std::chrono::steady_clock::now()) {}
+
+        bool Due(void);
+        void Save(ckpt_state_t &&state, std::vector<double> &&rows);
+        bool Load(ckpt_state_t &state, std::vector<double> &rows);
+        void Reset(void);
+        void Finish(void);
+
+        /*!
+            @brief      Returns the number of checkpoints written.
+            @return     The number of checkpoints.
+        */
+        IntTp Written(void) const noexcept { return _written; }
+
+    private:
+        bool Write(const ckpt_state_t &state, const std::vector<double> &rows) const;
+        void Collect(void);
+
+        static constexpr char _magic[8] = {'B', 'S', 'P', 'C', 'K', 'P', 'T', '3'};     //!< File signature and version.
+
+        std::string _file;                                  //!< The checkpoint (state) file.
+        double _interval;                                   //!< Wall clock interval of the checkpoints (s).
+        size_t _row_sz;                                     //!< Size of a row of results.
+        std::chrono::steady_clock::time_point _last;        //!< Time of the last checkpoint.
+        std::future<bool> _pending;                         //!< The write in progress.
+        IntTp _written = 0;                                 //!< Checkpoints written.
+};
+
+/* Initial state of the transient (x(0)), saved by a previous run */
+bool writeStateFile(const std::string &file, const DensVecD &x);
+bool readStateFile(const std::string &file, IntTp dim, DensVecD &x);
+
+#endif // __CHECKPOINT_H //
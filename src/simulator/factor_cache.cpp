@@ -0,0 +1,118 @@
+#include <cmath>
+#include "factor_cache.hpp"
+
+/*!
+    @brief      Looks up the factorization of a coefficient, which becomes the most recently used.
+    @param      a       The coefficient of C.
+    @return     The factorized solver in case of a hit, otherwise nullptr.
+*/
+template<typename MatTp>
+linear_solver<MatTp> *factor_cache<MatTp>::Find(double a)
+{
+    auto it = _index.find(Key(a));
+
+    if(it == _index.end() || std::abs(it->second->a - a) > _rel_eps * a)
+    {
+        _stats.misses++;
+        return nullptr;
+    }
+
+    /* Move to the front, the list iterators stay valid */
+    _entries.splice(_entries.begin(), _entries, it->second);
+    _stats.hits++;
+
+    return it->second->solver.get();
+}
+
+/*!
+    @brief      Factorizes the matrix of a coefficient and caches it as the most recently used.
+    The least recently used entries are evicted until the new factorization fits in the budget,
+    the size of the new one is estimated from the existing entries (same pattern). The most
+    recently used entry is always kept, so a budget smaller than two factorizations is exceeded
+    by one, rather than leaving nothing to reuse.
+    @param      a       The coefficient of C.
+    @param      mat     The matrix (G + a*C).
+    @return     The factorized solver in case of success, otherwise nullptr.
+*/
+template<typename MatTp>
+linear_solver<MatTp> *factor_cache<MatTp>::Insert(double a, const MatTp &mat)
+{
+    long long key = Key(a);
+    std::unique_ptr<linear_solver<MatTp>> solver;
+
+    /* Replace any entry with the same key */
+    auto it = _index.find(key);
+    if(it != _index.end())
+    {
+        _memory -= it->second->memory;
+        solver = std::move(it->second->solver);
+        _entries.erase(it->second);
+        _index.erase(it);
+    }
+
+    /* Evict the least recently used, the first one is recycled (symbolic analysis kept) */
+    while(_entries.size() > 1 && _memory + _entries.front().memory > _budget)
+    {
+        auto &lru = _entries.back();
+
+        if(solver) accumulateSolverStats(_dropped, lru.solver->Stats());
+        else solver = std::move(lru.solver);
+
+        _memory -= lru.memory;
+        _index.erase(lru.key);
+        _entries.pop_back();
+        _stats.evictions++;
+    }
+
+    bool ret = solver ? solver->refactor(mat) : (solver = CreateLinearSolver<MatTp>(_type, _spd))->factor(mat);
+
+    if(!ret)
+    {
+        accumulateSolverStats(_dropped, solver->Stats());
+        return nullptr;
+    }
+
+    double memory = Memory(*solver, mat);
+    _entries.push_front({key, a, memory, std::move(solver)});
+    _index[key] = _entries.begin();
+    _memory += memory;
+
+    _stats.entries = std::max(_stats.entries, (IntTp)_entries.size());
+    _stats.memory = std::max(_stats.memory, _memory);
+
+    return _entries.front().solver.get();
+}
+
+/*!
+    @brief      Returns the statistics of all the solvers used by the cache (counts and times).
+    @return     The statistics.
+*/
+template<typename MatTp>
+solver_stats_t factor_cache<MatTp>::SolverStats(void) const
+{
+    solver_stats_t stats = _dropped;
+
+    for(auto &entry : _entries) accumulateSolverStats(stats, entry.solver->Stats());
+
+    return stats;
+}
+
+/*!
+    @brief      Returns the memory of a factorization, as reported by the solver. When the solver
+    does not report it, the L and U factors are assumed to have at least the pattern of the matrix.
+    @param      solver      The factorized solver.
+    @param      mat         The factorized matrix.
+    @return     The memory (bytes).
+*/
+template<typename MatTp>
+double factor_cache<MatTp>::Memory(const linear_solver<MatTp> &solver, const MatTp &mat) const noexcept
+{
+    constexpr double entry_sz = sizeof(typename MatTp::Scalar) + sizeof(IntTp);
+    double memory = solver.Stats().factor_memory;
+
+    return (memory > 0) ? memory : 2 * mat.nonZeros() * entry_sz;
+}
+
+/* Explicit instantiations - Real and complex systems */
+template class factor_cache<SparMatD>;
+template class factor_cache<SparMatCompD>;
@@ -0,0 +1,78 @@
+#ifndef __FACTOR_CACHE_H
+#define __FACTOR_CACHE_H
+
+#include <list>
+#include <unordered_map>
+#include "linear_solver.hpp"
+
+/** Statistics gathered by the factorization cache during its lifetime. */
+typedef struct factor_cache_statistics
+{
+    IntTp hits = 0;                 //!< Lookups served by a cached factorization.
+    IntTp misses = 0;               //!< Lookups that required a new factorization.
+    IntTp evictions = 0;            //!< Factorizations dropped to stay within the memory budget.
+    IntTp entries = 0;              //!< Peak number of cached factorizations.
+    double memory = 0;              //!< Peak memory of the cached factorizations (bytes).
+} cache_stats_t;
+
+//! LRU cache of numeric factorizations of the transient system G + a*C, keyed by the coefficient a.
+/*!
+  With a variable timestep the left hand matrix changes with every step change. The coefficient
+  a depends only on the timestep (and the step history for BDF), so the cache keeps the
+  factorizations of the recent coefficients and returning to a previous timestep costs only a
+  lookup. The coefficient is hashed on a logarithmic scale (_levels per octave), a hit requires
+  the same coefficient up to rounding.\n
+  The memory of the factorizations is bounded by a budget. When a new factorization does not fit,
+  the least recently used solver is recycled for it, which also reuses its symbolic analysis.
+  The most recently used factorization is never evicted.
+*/
+template<typename MatTp>
+class factor_cache
+{
+    public:
+        /*!
+            @brief      Constructor.
+            @param      type        The linear solver to be used for the factorizations.
+            @param      spd         Whether the system is symmetric positive definite.
+            @param      budget      The memory budget (bytes).
+        */
+        factor_cache(solver_t type, bool spd, double budget) noexcept : _type(type), _spd(spd), _budget(budget) {}
+
+        linear_solver<MatTp> *Find(double a);
+        linear_solver<MatTp> *Insert(double a, const MatTp &mat);
+
+        /*!
+            @brief      Returns the statistics gathered by the cache.
+            @return     The statistics.
+        */
+        const cache_stats_t &Stats(void) const noexcept { return _stats; }
+
+        solver_stats_t SolverStats(void) const;
+
+    private:
+        /** A cached factorization. */
+        typedef struct cache_entry
+        {
+            long long key;                                  //!< The hashed coefficient.
+            double a;                                       //!< The exact coefficient of the factorization.
+            double memory;                                  //!< Memory of the factorization (bytes).
+            std::unique_ptr<linear_solver<MatTp>> solver;   //!< The factorized solver.
+        } entry_t;
+
+        long long Key(double a) const noexcept { return std::llround(std::log2(a) * _levels); }
+        double Memory(const linear_solver<MatTp> &solver, const MatTp &mat) const noexcept;
+
+        static constexpr double _levels = 256;          //!< Hash levels per octave of the coefficient.
+        static constexpr double _rel_eps = 1e-12;       //!< Relative difference of a matching coefficient.
+
+        solver_t _type;                                 //!< The linear solver of the factorizations.
+        bool _spd;                                      //!< Symmetric positive definite system.
+        double _budget;                                 //!< The memory budget (bytes).
+        double _memory = 0;                             //!< Current memory of the entries (bytes).
+        std::list<entry_t> _entries;                    //!< The entries, most recently used first.
+        std::unordered_map<long long, typename std::list<entry_t>::iterator> _index;   //!< Entries by key.
+        solver_stats_t _dropped;                        //!< Accumulated statistics of the released solvers.
+        cache_stats_t _stats;                           //!< The statistics of the cache.
+};
+
+#endif // __FACTOR_CACHE_H //
@@ -0,0 +1,163 @@
+#include "krylov_expm.hpp"
+
+/*!
+    @brief      Builds the Arnoldi basis of the shift-and-invert matrix M = (C + g*G)^-1 * C for
+    an initial vector, until the approximation of exp(tau*A)*w converges. The convergence is checked
+    every second dimension, by the change of the approximation. An invariant subspace (breakdown)
+    gives the exact result, as does a singular H (the new direction is only rounding).
+    @param      shift_solver    The factorized (G + C/g).
+    @param      tran_mat        The transient MNA matrix (C).
+    @param      gamma           The shift g.
+    @param      w               The initial vector.
+    @param      tau             The (largest) time of the approximation.
+    @param      tol             The absolute tolerance of the approximation.
+    @param      converged       Whether the approximation converged within the maximum dimension.
+    @return     True in case of success, otherwise false (solver failure).
+*/
+bool krylov_expm::Build(linear_solver<SparMatD> &shift_solver, const SparMatD &tran_mat, double gamma, const DensVecD &w,
+                        double tau, double tol, bool &converged)
+{
+    DensVecD vec, coeffs, coeffs_old;
+
+    converged = false;
+    _dim = 0;
+
+    /* Start from M*w, consistent with the algebraic equations */
+    _tmp.noalias() = tran_mat * w;
+    if(!shift_solver.solve(_tmp, vec)) return false;
+    vec /= gamma;
+
+    _beta = vec.norm();
+
+    /* No differential part, the exponential term vanishes */
+    if(_beta == 0)
+    {
+        converged = true;
+        return true;
+    }
+
+    _basis.resize(w.size(), _max_dim + 1);
+    _hess.setZero(_max_dim + 1, _max_dim);
+    _basis.col(0) = vec / _beta;
+
+    for(IntTp col = 0; col < _max_dim; col++)
+    {
+        /* M*v => (G + C/g)^-1 * C*v / g */
+        _tmp.noalias() = tran_mat * _basis.col(col);
+        if(!shift_solver.solve(_tmp, vec)) return false;
+        vec /= gamma;
+
+        double vec_norm = vec.norm();
+
+        /* Modified Gram-Schmidt */
+        for(IntTp row = 0; row <= col; row++)
+        {
+            _hess(row, col) = _basis.col(row).dot(vec);
+            vec -= _hess(row, col) * _basis.col(row);
+        }
+
+        _hess(col + 1, col) = vec.norm();
+        _dim = col + 1;
+
+        /* Singular H, the last direction is only rounding in the null space of C and it is dropped */
+        if(_hess.topLeftCorner(_dim, _dim).partialPivLu().rcond() < _sing_tol)
+        {
+            if(--_dim) Reduced(_dim, gamma);
+            converged = true;
+            return true;
+        }
+
+        /* Invariant subspace (up to rounding), the approximation is exact */
+        if(_hess(col + 1, col) <= _break_tol * vec_norm)
+        {
+            Reduced(_dim, gamma);
+            converged = true;
+            return true;
+        }
+
+        _basis.col(col + 1) = vec / _hess(col + 1, col);
+
+        if(_dim % 2 && _dim != _max_dim) continue;
+
+        /* Change of the approximation, the basis is orthonormal so it is measured on the coefficients */
+        Reduced(_dim, gamma);
+        Expm(tau * _red, _exp);
+        coeffs.noalias() = _exp * _start;
+
+        if(coeffs_old.size())
+        {
+            double change = (coeffs.head(coeffs_old.size()) - coeffs_old).squaredNorm() + coeffs.tail(_dim - coeffs_old.size()).squaredNorm();
+
+            if(_beta * std::sqrt(change) <= tol)
+            {
+                converged = true;
+                return true;
+            }
+        }
+
+        coeffs_old = coeffs;
+    }
+
+    return true;
+}
+
+/*!
+    @brief      Adds the approximation of exp(tau*A)*w, from the current basis, to a vector.
+    @param      tau     The time.
+    @param      out     The vector.
+*/
+void krylov_expm::Apply(double tau, DensVecD &out)
+{
+    if(!_dim) return;
+
+    Expm(tau * _red, _exp);
+    _coeffs.noalias() = _exp * _start;
+    _tmp.noalias() = _basis.leftCols(_dim) * _coeffs;
+    out += _beta * _tmp;
+}
+
+/*!
+    @brief      Forms the reduced matrix Ht = (I - H^-1) / g of a basis dimension, and the
+    coefficients of the initial vector (w = beta * V * H^-1 * e1).
+    @param      dim         The dimension.
+    @param      gamma       The shift g.
+*/
+void krylov_expm::Reduced(IntTp dim, double gamma)
+{
+    DenseMatD hess_inv = _hess.topLeftCorner(dim, dim).partialPivLu().inverse();
+
+    _red = (DenseMatD::Identity(dim, dim) - hess_inv) / gamma;
+    _start = hess_inv.col(0);
+}
+
+/*!
+    @brief      Computes the exponential of a (small) dense matrix, with the diagonal Pade approximant
+    of degree 6 and scaling and squaring.
+    @param      mat     The matrix.
+    @param      res     The exponential.
+*/
+void krylov_expm::Expm(const DenseMatD &mat, DenseMatD &res)
+{
+    constexpr IntTp degree = 6;
+
+    /* Scale to norm <= 1/2, the approximant is accurate to double precision there */
+    double norm = mat.cwiseAbs().rowwise().sum().maxCoeff();
+    IntTp squarings = (norm > 0.5) ? static_cast<IntTp>(std::ceil(std::log2(norm / 0.5))) : 0;
+
+    DenseMatD scaled = mat * std::exp2(-squarings);
+    DenseMatD power = DenseMatD::Identity(mat.rows(), mat.cols());
+    DenseMatD num = power, den = power;
+    double coeff = 1;
+
+    for(IntTp k = 1; k <= degree; k++)
+    {
+        coeff *= (double)(degree - k + 1) / (k * (2 * degree - k + 1));
+        power = power * scaled;
+        num += coeff * power;
+        den += ((k % 2) ? -coeff : coeff) * power;
+    }
+
+    res = den.partialPivLu().solve(num);
+
+    for(IntTp idx = 0; idx < squarings; idx++) res = res * res;
+}
@@ -0,0 +1,57 @@
+#ifndef __KRYLOV_EXPM_H
+#define __KRYLOV_EXPM_H
+
+#include "linear_solver.hpp"
+
+//! Shift-and-invert Krylov approximation of the matrix exponential of a linear MNA system.
+/*!
+  For the homogeneous system C*x' + G*x = 0 the solution is x(t) = exp(t*A)*x(0), with A = -C^-1 * G.
+  C is usually singular (nodes without capacitors, voltage sources), so A is never formed. Instead
+  the Arnoldi basis is built for the shift-and-invert matrix M = (C + g*G)^-1 * C = (I - g*A)^-1, which
+  only needs the factorization of (G + C/g).\n
+  The basis is started from M*w instead of w. M maps every vector to the consistent (differential)
+  subspace, so any violation of the algebraic equations in w (rounding) is removed instead of being
+  carried into the basis. With M*V = V*H (Arnoldi) and beta*V*e1 = M*w, the exponential is
+  approximated as exp(t*A)*w = beta*V*exp(t*Ht)*H^-1*e1, where Ht = (I - H^-1) / g. The basis does not
+  depend on t, one basis serves every time of the interval. The small dense exponential is computed
+  with a Pade approximant and scaling and squaring.
+*/
+class krylov_expm
+{
+    public:
+        /*!
+            @brief      Constructor.
+            @param      max_dim     Maximum dimension of the Krylov subspace.
+        */
+        krylov_expm(IntTp max_dim) noexcept : _max_dim(max_dim) {}
+
+        bool Build(linear_solver<SparMatD> &shift_solver, const SparMatD &tran_mat, double gamma, const DensVecD &w,
+                   double tau, double tol, bool &converged);
+        void Apply(double tau, DensVecD &out);
+
+        /*!
+            @brief      Returns the dimension of the last basis.
+            @return     The dimension.
+        */
+        IntTp Dim(void) const noexcept { return _dim; }
+
+    private:
+        void Reduced(IntTp dim, double gamma);
+        void Expm(const DenseMatD &mat, DenseMatD &res);
+
+        static constexpr double _break_tol = 1e-7;      //!< Relative norm of a new direction that is only rounding (breakdown).
+        static constexpr double _sing_tol = 1e-10;      //!< Reciprocal condition of a singular H.
+
+        IntTp _max_dim;         //!< Maximum dimension of the subspace.
+        IntTp _dim = 0;         //!< Dimension of the current basis.
+        double _beta = 0;       //!< Norm of the initial vector M*w.
+        DenseMatD _basis;       //!< The orthonormal basis (columns).
+        DenseMatD _hess;        //!< The Hessenberg matrix of M.
+        DenseMatD _red;         //!< The reduced matrix Ht of the current basis.
+        DensVecD _start;        //!< The coefficients of w in the current basis (H^-1 * e1).
+        DensVecD _coeffs;       //!< Workspace of the coefficients.
+        DenseMatD _exp;         //!< Workspace of the dense exponential.
+        DensVecD _tmp;          //!< Workspace of the products.
+};
+
+#endif // __KRYLOV_EXPM_H //
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include "linear_solver.hpp"
+#include "mixed_solver.hpp"
+
+/* For solver engines, BTF is built along with KLU (SuiteSparse) */
+#ifdef BSPICE_EIGEN_USE_KLU
+    #include "KLUSupport"
+    #include "btf_solver.hpp"
+
+    /** KLU direct solvers - Supports both int/long*/
+    template<typename MatTp> using klu_solver = Eigen::KLU<MatTp>;
+#endif
+
+/** Eigen direct solver - Supports both int/long */
+template<typename MatTp> using sparselu_solver = Eigen::SparseLU<MatTp, Eigen::COLAMDOrdering<IntTp>>;
+
+/** Cholesky direct solver for SPD systems (R, C, ICS circuits and grounded IVS) - Supports both int/long */
+typedef Eigen::SimplicialLLT<SparMatD, Eigen::Lower, Eigen::AMDOrdering<IntTp>> cholesky_solver;
+
+/** BiCGSTAB iterative solver, with incomplete LU preconditioner */
+template<typename MatTp> using bicgstab_solver = Eigen::BiCGSTAB<MatTp, Eigen::IncompleteLUT<typename MatTp::Scalar, IntTp>>;
+
+/** Conjugate Gradient iterative solver for SPD systems, with incomplete Cholesky preconditioner */
+typedef Eigen::ConjugateGradient<SparMatD, Eigen::Lower | Eigen::Upper, Eigen::IncompleteCholesky<double, Eigen::Lower, Eigen::AMDOrdering<IntTp>>> cg_solver;
+
+
+
+/*!
+    @brief      Creates the linear solver to be used for a system. In case of SOLVER_AUTO
+    the solver is picked based on the structure, Cholesky for SPD systems and LU (KLU when
+    available) for the rest. Solvers that do not apply to the system (SPD only or complex systems)
+    fall back to the default LU solver. The solvers that are not compiled in (KLU, BTF) are
+    rejected by the SOLVER option already.
+    @param      type    The requested solver.
+    @param      spd     Whether the system is symmetric positive definite.
+    @return     The solver.
+*/
+template<typename MatTp>
+std::unique_ptr<linear_solver<MatTp>> CreateLinearSolver(solver_t type, bool spd)
+{
+    constexpr bool is_real = std::is_same<typename MatTp::Scalar, double>::value;
+
+#ifdef BSPICE_EIGEN_USE_KLU
+    const solver_t default_lu = SOLVER_KLU;
+#else
+    const solver_t default_lu = SOLVER_SPARSELU;
+#endif
+
+    /* Resolve the automatic choice, and the choices that do not apply */
+    if(type == SOLVER_AUTO) type = (spd && is_real) ? SOLVER_CHOLESKY : default_lu;
+    if((type == SOLVER_CHOLESKY || type == SOLVER_CG) && !(spd && is_real)) type = default_lu;
+
+    switch(type)
+    {
+#ifdef BSPICE_EIGEN_USE_KLU
+        case SOLVER_KLU: return std::make_unique<direct_linear_solver<MatTp, klu_solver<MatTp>>>(type);
+        case SOLVER_BTF: return std::make_unique<btf_linear_solver<MatTp>>(type);
+#endif
+        case SOLVER_MIXED: return std::make_unique<mixed_linear_solver<MatTp>>(type);
+        case SOLVER_BICGSTAB: return std::make_unique<iterative_linear_solver<MatTp, bicgstab_solver<MatTp>>>(type);
+        /* The SPD solvers see the system with the grounded voltage sources eliminated */
+        case SOLVER_CHOLESKY:
+        {
+            if constexpr (is_real) return std::make_unique<reduced_linear_solver<MatTp>>(std::make_unique<direct_linear_solver<MatTp, cholesky_solver>>(type));
+            break;
+        }
+        case SOLVER_CG:
+        {
+            if constexpr (is_real) return std::make_unique<reduced_linear_solver<MatTp>>(std::make_unique<iterative_linear_solver<MatTp, cg_solver>>(type));
+            break;
+        }
+        default: break;
+    }
+
+    return std::make_unique<direct_linear_solver<MatTp, sparselu_solver<MatTp>>>(SOLVER_SPARSELU);
+}
+
+/*!
+    @brief      Returns the name of a solver type.
+    @param      type    The type.
+    @return     The name.
+*/
+const char *SolverName(solver_t type)
+{
+    switch(type)
+    {
+        case SOLVER_KLU: return "KLU";
+        case SOLVER_SPARSELU: return "SparseLU";
+        case SOLVER_CHOLESKY: return "Cholesky";
+        case SOLVER_BICGSTAB: return "BiCGSTAB";
+        case SOLVER_CG: return "CG";
+        case SOLVER_BTF: return "BTF";
+        case SOLVER_MIXED: return "Mixed precision LU";
+        default: return "Auto";
+    }
+}
+
+/*!
+    @brief      Adds the counts and times of a solver to accumulated statistics, for the analyses
+    that use more than one solver.
+    @param      dst     The accumulated statistics.
+    @param      src     The statistics of the solver.
+*/
+void accumulateSolverStats(solver_stats_t &dst, const solver_stats_t &src) noexcept
+{
+    dst.analyze_count += src.analyze_count;
+    dst.factor_count += src.factor_count;
+    dst.solve_count += src.solve_count;
+    dst.iterations += src.iterations;
+    dst.analyze_time += src.analyze_time;
+    dst.factor_time += src.factor_time;
+    dst.solve_time += src.solve_time;
+}
+
+/*!
+    @brief      Prints the statistics of a linear solver to the standard output.
+    @param      stats   The statistics.
+    @param      type    The type of the solver.
+*/
+void printSolverStats(const solver_stats_t &stats, solver_t type)
+{
+    std::cout << "Solver: " << SolverName(type) << "\n";
+    std::cout << "\tAnalyze: " << stats.analyze_count << " (" << stats.analyze_time << "ms)\n";
+    std::cout << "\tFactor: " << stats.factor_count << " (" << stats.factor_time << "ms)\n";
+    std::cout << "\tSolve: " << stats.solve_count << " (" << stats.solve_time << "ms)\n";
+
+    if(type == SOLVER_BICGSTAB || type == SOLVER_CG)
+    {
+        std::cout << "\tIterations: " << stats.iterations << "\n";
+    }
+
+    if(type == SOLVER_MIXED)
+    {
+        std::cout << "\tRefinement iterations: " << stats.iterations << "\n";
+        if(stats.memory_saved >= 0) std::cout << "\tMemory saved (net of the matrix copies): " << stats.memory_saved / 1024 << "KB\n";
+        else std::cout << "\tMemory overhead (net of the matrix copies): " << -stats.memory_saved / 1024 << "KB\n";
+        if(stats.precision_fallback) std::cout << "\tRefinement stalled, switched to full precision\n";
+    }
+
+    /* Cholesky factor, and the LU factorization of the same matrix when measured (LUSTATS) */
+    if(stats.factor_nnz > 0)
+    {
+        std::cout << "\tFactor non-zeros: " << stats.factor_nnz << "\n";
+        std::cout << "\tFactor memory: " << stats.factor_memory / 1024 << "KB\n";
+        std::cout << "\tFactor flops: " << stats.factor_flops << "\n";
+    }
+
+    if(stats.lu_nnz > 0)
+    {
+        std::cout << "\tLU of the same matrix (measured once): " << stats.lu_nnz << " non-zeros, " << stats.lu_memory / 1024 << "KB, ";
+        std::cout << stats.lu_time << "ms (Cholesky: " << stats.factor_time / stats.factor_count << "ms per factorization)\n";
+    }
+
+    /* Block triangular form, the slowest blocks are listed */
+    if(stats.blocks > 0)
+    {
+        const IntTp max_listed = 5;
+        std::vector<IntTp> order(stats.blocks);
+        IntTp largest = *std::max_element(stats.block_size.begin(), stats.block_size.end());
+
+        for(IntTp k = 0; k < stats.blocks; k++) order[k] = k;
+        std::sort(order.begin(), order.end(), [&](IntTp a, IntTp b) { return stats.block_time[a] > stats.block_time[b]; });
+
+        std::cout << "\tBlocks: " << stats.blocks << " (largest: " << largest << ", levels: " << stats.levels << ")\n";
+
+        for(IntTp k = 0; k < std::min(max_listed, stats.blocks); k++)
+        {
+            IntTp block = order[k];
+            std::cout << "\t\tBlock " << block << ": size " << stats.block_size[block] << " (" << stats.block_time[block] << "ms)\n";
+        }
+    }
+}
+
+/* Explicit instantiations - Real and complex systems */
+template std::unique_ptr<linear_solver<SparMatD>> CreateLinearSolver<SparMatD>(solver_t type, bool spd);
+template std::unique_ptr<linear_solver<SparMatCompD>> CreateLinearSolver<SparMatCompD>(solver_t type, bool spd);
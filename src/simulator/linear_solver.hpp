@@ -0,0 +1,685 @@
+#ifndef __LINEAR_SOLVER_H
+#define __LINEAR_SOLVER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <iostream>
+#include "matrix_types.hpp"
+#include "simulator_types.hpp"
+#include "sparselu_adapter.hpp"
+
+/** Statistics gathered by a linear solver during its lifetime. */
+typedef struct linear_solver_statistics
+{
+    IntTp analyze_count = 0;        //!< Number of symbolic analyses.
+    IntTp factor_count = 0;         //!< Number of numeric factorizations.
+    IntTp solve_count = 0;          //!< Number of solved right hand sides.
+    IntTp iterations = 0;           //!< Total iterations (iterative solvers and the mixed precision refinement only).
+    double analyze_time = 0;        //!< Time spent in symbolic analysis (ms).
+    double factor_time = 0;         //!< Time spent in numeric factorization (ms).
+    double solve_time = 0;          //!< Time spent in solves (ms).
+    double factor_nnz = 0;          //!< Non-zeros of the last factor (0 when unknown).
+    double factor_flops = 0;        //!< Flops of the last factorization (0 when unknown).
+    double factor_memory = 0;       //!< Memory of the last factor (bytes, 0 when unknown).
+    double lu_nnz = 0;              //!< Non-zeros of the LU factors of the same matrix, measured once (0 when not measured, Cholesky only).
+    double lu_memory = 0;           //!< Memory of the LU factors (bytes, 0 when not measured, Cholesky only).
+    double lu_time = 0;             //!< Time of the LU numeric factorization (ms, 0 when not measured, Cholesky only).
+    IntTp blocks = 0;               //!< Number of diagonal blocks (BTF solver only).
+    IntTp levels = 0;               //!< Number of dependency levels of the blocks (BTF solver only).
+    std::vector<IntTp> block_size;  //!< Dimension of each block (BTF solver only).
+    std::vector<double> block_time; //!< Factorization and solve time of each block (ms, BTF solver only).
+    double memory_saved = 0;        //!< Net memory saved against a full precision LU, matrix copies included (bytes, negative for a loss, mixed solver only).
+    bool precision_fallback = false;//!< Switched to full precision after a stalled refinement (mixed solver only).
+} solver_stats_t;
+
+//! Abstract linear solver interface, used by the simulation engine for every analysis.
+/*!
+  The interface splits the solution of a sparse system in the usual phases, so that the
+  engine can reuse the symbolic analysis when only the values of the matrix change:
+  - analyze: Symbolic analysis (ordering) on the pattern of the matrix.
+  - refactor: Numeric factorization, with the pattern already analyzed.
+  - factor: Both of the above.
+  - solve/solveMulti: Solution for one or many right hand sides.\n
+  The concrete solver is picked at runtime (.OPTIONS SOLVER=...), see CreateLinearSolver().
+*/
+template<typename MatTp>
+class linear_solver
+{
+    public:
+        typedef typename MatTp::Scalar ScalarTp;                                        //!< Scalar of the system.
+        typedef Eigen::Matrix<ScalarTp, Eigen::Dynamic, 1> VecTp;                       //!< Dense vector type.
+        typedef Eigen::Matrix<ScalarTp, Eigen::Dynamic, Eigen::Dynamic> MultiVecTp;     //!< Dense multi-vector type.
+
+        virtual ~linear_solver() {}
+
+        /* Solver phases */
+        virtual bool analyze(const MatTp &mat) = 0;
+        virtual bool refactor(const MatTp &mat) = 0;
+        virtual bool solve(const VecTp &rh, VecTp &sol) = 0;
+        virtual bool solveMulti(const MultiVecTp &rh, MultiVecTp &sol) = 0;
+
+        /*!
+            @brief      Performs the symbolic analysis and the numeric factorization of the matrix.
+            @param      mat     The matrix.
+            @return     True in case of success, otherwise false.
+        */
+        bool factor(const MatTp &mat) { return analyze(mat) && refactor(mat); }
+
+        /*!
+            @brief      Returns the type of the solver.
+            @return     The type.
+        */
+        solver_t Type(void) const noexcept { return _type; }
+
+        /*!
+            @brief      Returns the statistics gathered by the solver.
+            @return     The statistics.
+        */
+        const solver_stats_t &Stats(void) const noexcept { return _stats; }
+
+        /*!
+            @brief      Sets whether the first factorization is repeated once with LU, to compare
+            the factor size and time (Cholesky only, the other solvers ignore it).
+            @param      measure     True to measure the LU factorization.
+        */
+        void MeasureLU(bool measure) noexcept { _measure_lu = measure; }
+
+    protected:
+        /*!
+            @brief      Constructor, only accessible from the implementations.
+            @param      type    The type of the implementation.
+        */
+        linear_solver(solver_t type) noexcept { _type = type; }
+
+        /*!
+            @brief      Returns the milliseconds passed since a given time point.
+            @param      begin   The starting time point.
+            @return     The elapsed time (ms).
+        */
+        static double elapsed(std::chrono::high_resolution_clock::time_point begin)
+        {
+            auto end = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double, std::milli>(end - begin).count();
+        }
+
+        solver_t _type;             //!< The type of the implementation.
+        solver_stats_t _stats;      //!< The statistics of the solver.
+        bool _measure_lu = false;   //!< The first factorization is repeated with LU (Cholesky only).
+};
+
+//! Linear solver implementation for the Eigen direct solvers (KLU, SparseLU, Cholesky).
+/*!
+  Any solver following the Eigen sparse direct solver API (analyzePattern/factorize/solve)
+  can be used. For the Cholesky solver, the factor size and flops are also recorded, and on
+  request (.OPTIONS LUSTATS) the first matrix is factorized once with LU as well, to compare.
+*/
+template<typename MatTp, typename EigenSolverTp>
+class direct_linear_solver : public linear_solver<MatTp>
+{
+    public:
+        typedef linear_solver<MatTp> BaseTp;                //!< The interface.
+        typedef typename BaseTp::VecTp VecTp;               //!< Dense vector type.
+        typedef typename BaseTp::MultiVecTp MultiVecTp;     //!< Dense multi-vector type.
+
+        /*!
+            @brief      Constructor.
+            @param      type    The type of the implementation.
+        */
+        direct_linear_solver(solver_t type) noexcept : BaseTp(type) {}
+
+        /*!
+            @brief      Performs the symbolic analysis of the matrix.
+            @param      mat     The matrix.
+            @return     True in case of success, otherwise false.
+        */
+        bool analyze(const MatTp &mat) override
+        {
+            auto begin = std::chrono::high_resolution_clock::now();
+            _solver.analyzePattern(mat);
+
+            this->_stats.analyze_count++;
+            this->_stats.analyze_time += this->elapsed(begin);
+
+            /* Not all solvers report the state after analysis, failures surface in the factorization */
+            return true;
+        }
+
+        /*!
+            @brief      Performs the numeric factorization of the matrix, same pattern as analyzed.
+            @param      mat     The matrix.
+            @return     True in case of success, otherwise false.
+        */
+        bool refactor(const MatTp &mat) override
+        {
+            auto begin = std::chrono::high_resolution_clock::now();
+            _solver.factorize(mat);
+
+            this->_stats.factor_count++;
+            this->_stats.factor_time += this->elapsed(begin);
+
+            if(_solver.info() != Eigen::Success) return false;
+
+            /* Factor memory in (value + row index) per non-zero, where the solver reports the factor size */
+            constexpr double entry_sz = sizeof(typename MatTp::Scalar) + sizeof(IntTp);
+
+            /* Factor statistics only for Cholesky, sum(colcount^2) flops */
+            if constexpr (std::is_base_of<Eigen::SimplicialCholeskyBase<EigenSolverTp>, EigenSolverTp>::value)
+            {
+                auto &L = _solver.matrixL().nestedExpression();
+                double flops = 0;
+
+                for(Eigen::Index k = 0; k < L.outerSize(); k++)
+                {
+                    double colcount = L.outerIndexPtr()[k + 1] - L.outerIndexPtr()[k];
+                    flops += colcount * colcount;
+                }
+
+                this->_stats.factor_nnz = L.nonZeros();
+                this->_stats.factor_flops = flops;
+                this->_stats.factor_memory = L.nonZeros() * entry_sz;
+
+                /* Same matrix with LU, measured once */
+                if(this->_measure_lu && this->_stats.lu_nnz == 0)
+                {
+                    Eigen::SparseLU<MatTp, Eigen::COLAMDOrdering<IntTp>> lu;
+                    lu.analyzePattern(mat);
+
+                    auto lu_begin = std::chrono::high_resolution_clock::now();
+                    lu.factorize(mat);
+
+                    if(lu.info() == Eigen::Success)
+                    {
+                        this->_stats.lu_time = this->elapsed(lu_begin);
+                        this->_stats.lu_nnz = lu.nnzL() + lu.nnzU();
+                        this->_stats.lu_memory = this->_stats.lu_nnz * entry_sz;
+                    }
+                }
+            }
+            else if constexpr (std::is_same<EigenSolverTp, Eigen::SparseLU<MatTp, Eigen::COLAMDOrdering<IntTp>>>::value)
+            {
+                this->_stats.factor_memory = (_solver.nnzL() + _solver.nnzU()) * entry_sz;
+            }
+
+            return true;
+        }
+
+        /*!
+            @brief      Solves the factorized system for one right hand side.
+            @param      rh      The right hand side.
+            @param      sol     The solution.
+            @return     True in case of success, otherwise false.
+        */
+        bool solve(const VecTp &rh, VecTp &sol) override
+        {
+            auto begin = std::chrono::high_resolution_clock::now();
+
+            /* Cholesky, the permutations go through a work vector (Eigen permutes in place with a temporary mask) */
+            if constexpr (std::is_same<EigenSolverTp, Eigen::SimplicialLLT<MatTp, Eigen::Lower, Eigen::AMDOrdering<IntTp>>>::value)
+            {
+                _work.resize(rh.size());
+                _work.noalias() = _solver.permutationP() * rh;
+                _solver.matrixL().solveInPlace(_work);
+                _solver.matrixU().solveInPlace(_work);
+                sol.resize(rh.size());
+                sol.noalias() = _solver.permutationPinv() * _work;
+            }
+            /* SparseLU, the same through the adapter (Eigen allocates workspaces per solve) */
+            else if constexpr (std::is_same<EigenSolverTp, Eigen::SparseLU<MatTp, Eigen::COLAMDOrdering<IntTp>>>::value)
+            {
+                _lu_solve.solve(_solver, rh, sol);
+            }
+            else sol = _solver.solve(rh);
+
+            this->_stats.solve_count++;
+            this->_stats.solve_time += this->elapsed(begin);
+
+            return _solver.info() == Eigen::Success;
+        }
+
+        /*!
+            @brief      Solves the factorized system for many right hand sides.
+            @param      rh      The right hand sides (columns).
+            @param      sol     The solutions (columns).
+            @return     True in case of success, otherwise false.
+        */
+        bool solveMulti(const MultiVecTp &rh, MultiVecTp &sol) override
+        {
+            auto begin = std::chrono::high_resolution_clock::now();
+            sol = _solver.solve(rh);
+
+            this->_stats.solve_count += rh.cols();
+            this->_stats.solve_time += this->elapsed(begin);
+
+            return _solver.info() == Eigen::Success;
+        }
+
+    private:
+        EigenSolverTp _solver;      //!< The Eigen solver.
+        VecTp _work;                //!< Workspace of a solve (Cholesky only).
+        sparselu_adapter<EigenSolverTp> _lu_solve;  //!< Allocation free solves (SparseLU only).
+};
+
+//! Linear solver implementation for the Eigen iterative solvers (BiCGSTAB, CG).
+/*!
+  The factorization phases build the preconditioner. Every solve starts from the previous
+  solution as initial guess, which is close to the next one in DC sweeps and transient.
+*/
+template<typename MatTp, typename EigenSolverTp>
+class iterative_linear_solver : public linear_solver<MatTp>
+{
+    public:
+        typedef linear_solver<MatTp> BaseTp;                //!< The interface.
+        typedef typename BaseTp::VecTp VecTp;               //!< Dense vector type.
+        typedef typename BaseTp::MultiVecTp MultiVecTp;     //!< Dense multi-vector type.
+
+        /*!
+            @brief      Constructor.
+            @param      type    The type of the implementation.
+        */
+        iterative_linear_solver(solver_t type) noexcept : BaseTp(type)
+        {
+            _solver.setTolerance(1e-12);
+        }
+
+        /*!
+            @brief      Performs the symbolic analysis of the preconditioner.
+            @param      mat     The matrix.
+            @return     True in case of success, otherwise false.
+        */
+        bool analyze(const MatTp &mat) override
+        {
+            auto begin = std::chrono::high_resolution_clock::now();
+
+            /* The solver keeps a reference, hold the matrix here */
+            _mat = mat;
+            _solver.analyzePattern(_mat);
+
+            this->_stats.analyze_count++;
+            this->_stats.analyze_time += this->elapsed(begin);
+
+            return true;
+        }
+
+        /*!
+            @brief      Builds the preconditioner for the matrix, same pattern as analyzed.
+            @param      mat     The matrix.
+            @return     True in case of success, otherwise false.
+        */
+        bool refactor(const MatTp &mat) override
+        {
+            auto begin = std::chrono::high_resolution_clock::now();
+
+            _mat = mat;
+            _solver.factorize(_mat);
+            _guess = VecTp::Zero(_mat.rows());
+
+            this->_stats.factor_count++;
+            this->_stats.factor_time += this->elapsed(begin);
+
+            return _solver.info() == Eigen::Success;
+        }
+
+        /*!
+            @brief      Solves the system for one right hand side.
+            @param      rh      The right hand side.
+            @param      sol     The solution.
+            @return     True in case of convergence, otherwise false.
+        */
+        bool solve(const VecTp &rh, VecTp &sol) override
+        {
+            auto begin = std::chrono::high_resolution_clock::now();
+            sol = _solver.solveWithGuess(rh, _guess);
+            this->_stats.iterations += _solver.iterations();
+
+            /* The recursive residual may drift after a breakdown, retry once from zero */
+            bool converged = (_solver.info() == Eigen::Success) && residualCheck(rh, sol);
+
+            if(!converged)
+            {
+                sol = _solver.solve(rh);
+                this->_stats.iterations += _solver.iterations();
+                converged = (_solver.info() == Eigen::Success) && residualCheck(rh, sol);
+            }
+
+            _guess = sol;
+
+            this->_stats.solve_count++;
+            this->_stats.solve_time += this->elapsed(begin);
+
+            return converged;
+        }
+
+        /*!
+            @brief      Solves the system for many right hand sides.
+            @param      rh      The right hand sides (columns).
+            @param      sol     The solutions (columns).
+            @return     True in case of convergence, otherwise false.
+        */
+        bool solveMulti(const MultiVecTp &rh, MultiVecTp &sol) override
+        {
+            sol.resize(rh.rows(), rh.cols());
+
+            /* Column by column, through the kept workspaces */
+            for(Eigen::Index k = 0; k < rh.cols(); k++)
+            {
+                _col_rh = rh.col(k);
+                if(!solve(_col_rh, _col_sol)) return false;
+                sol.col(k) = _col_sol;
+            }
+
+            return true;
+        }
+
+    private:
+        /*!
+            @brief      Checks the true residual of a solution, against the solver tolerance.
+            @param      rh      The right hand side.
+            @param      sol     The solution.
+            @return     True if the residual is acceptable, otherwise false.
+        */
+        bool residualCheck(const VecTp &rh, const VecTp &sol)
+        {
+            double rh_norm = rh.norm();
+            if(!std::isfinite(sol.squaredNorm())) return false;
+
+            return (rh - _mat * sol).norm() <= 1e3 * _solver.tolerance() * rh_norm;
+        }
+
+        MatTp _mat;                 //!< The system matrix (referenced by the solver).
+        VecTp _guess;               //!< Initial guess for the next solve.
+        VecTp _col_rh;              //!< Workspace of a right hand side (solveMulti).
+        VecTp _col_sol;             //!< Workspace of a solution (solveMulti).
+        EigenSolverTp _solver;      //!< The Eigen solver.
+};
+
+//! Linear solver wrapper that eliminates the grounded voltage sources, for the SPD solvers.
+/*!
+  A voltage source with one terminal to ground fixes the voltage of its node. Its branch row
+  has a single non-zero (+-1) on the column of the node, mirrored by its branch column. Every
+  such pair of node and branch unknowns is dropped from the system: the known voltage moves to
+  the right hand side, the remaining unknowns are solved with the wrapped solver, and the branch
+  current is recovered from the row of the node. What remains of an R, C, ICS circuit is symmetric
+  positive definite (see MNA::CheckSPDStructure). Without such pairs the matrix passes through.\n
+  The pairs are found on the matrix of the symbolic analysis, the numeric factorizations only copy
+  the values (same pattern), so the solves do not allocate.
+*/
+template<typename MatTp>
+class reduced_linear_solver : public linear_solver<MatTp>
+{
+    public:
+        typedef linear_solver<MatTp> BaseTp;                //!< The interface.
+        typedef typename BaseTp::ScalarTp ScalarTp;         //!< Scalar of the system.
+        typedef typename BaseTp::VecTp VecTp;               //!< Dense vector type.
+        typedef typename BaseTp::MultiVecTp MultiVecTp;     //!< Dense multi-vector type.
+
+        /*!
+            @brief      Constructor.
+            @param      solver  The solver of the reduced system.
+        */
+        reduced_linear_solver(std::unique_ptr<BaseTp> solver) noexcept : BaseTp(solver->Type()), _solver(std::move(solver)) {}
+
+        /*!
+            @brief      Finds the grounded voltage sources and performs the symbolic analysis of the reduced matrix.
+            @param      mat     The matrix.
+            @return     True in case of success, otherwise false.
+        */
+        bool analyze(const MatTp &mat) override
+        {
+            FindEliminated(mat);
+            _solver->MeasureLU(this->_measure_lu);
+
+            bool ret = _node.empty() ? _solver->analyze(mat) : _solver->analyze(_red);
+            this->_stats = _solver->Stats();
+
+            return ret;
+        }
+
+        /*!
+            @brief      Performs the numeric factorization of the reduced matrix, same pattern as analyzed.
+            @param      mat     The matrix.
+            @return     True in case of success, otherwise false.
+        */
+        bool refactor(const MatTp &mat) override
+        {
+            if(!_node.empty())
+            {
+                const ScalarTp *vals = mat.valuePtr();
+                ScalarTp *red_vals = _red.valuePtr();
+
+                std::copy(vals, vals + _vals.size(), _vals.begin());
+                for(size_t k = 0; k < _src.size(); k++) red_vals[k] = vals[_src[k]];
+            }
+
+            bool ret = _solver->refactor(_node.empty() ? mat : _red);
+            this->_stats = _solver->Stats();
+
+            return ret;
+        }
+
+        /*!
+            @brief      Solves the factorized system for one right hand side.
+            @param      rh      The right hand side.
+            @param      sol     The solution.
+            @return     True in case of success, otherwise false.
+        */
+        bool solve(const VecTp &rh, VecTp &sol) override
+        {
+            if(_node.empty())
+            {
+                bool ret = _solver->solve(rh, sol);
+                this->_stats = _solver->Stats();
+                return ret;
+            }
+
+            sol.resize(rh.size());
+            sol.setZero();
+
+            /* Known node voltages, from the branch rows */
+            for(size_t e = 0; e < _node.size(); e++) sol[_node[e]] = rh[_branch[e]] / _vals[_branch_val[e]];
+
+            /* Right hand side of the reduced system, the known voltages moved over */
+            for(Eigen::Index k = 0; k < rh.size(); k++) if(_map[k] != -1) _rh_red[_map[k]] = rh[k];
+
+            for(size_t e = 0; e < _node.size(); e++)
+            {
+                for(IntTp k = _col_ptr[e]; k < _col_ptr[e + 1]; k++) _rh_red[_map[_col_row[k]]] -= _vals[_col_val[k]] * sol[_node[e]];
+            }
+
+            bool ret = _solver->solve(_rh_red, _sol_red);
+            this->_stats = _solver->Stats();
+
+            for(Eigen::Index k = 0; k < rh.size(); k++) if(_map[k] != -1) sol[k] = _sol_red[_map[k]];
+
+            /* Branch currents, from the rows of the nodes */
+            for(size_t e = 0; e < _node.size(); e++)
+            {
+                ScalarTp sum = rh[_node[e]];
+                for(IntTp k = _row_ptr[e]; k < _row_ptr[e + 1]; k++) sum -= _vals[_row_val[k]] * sol[_row_col[k]];
+
+                sol[_branch[e]] = sum / _vals[_node_val[e]];
+            }
+
+            return ret;
+        }
+
+        /*!
+            @brief      Solves the factorized system for many right hand sides.
+            @param      rh      The right hand sides (columns).
+            @param      sol     The solutions (columns).
+            @return     True in case of success, otherwise false.
+        */
+        bool solveMulti(const MultiVecTp &rh, MultiVecTp &sol) override
+        {
+            if(_node.empty())
+            {
+                bool ret = _solver->solveMulti(rh, sol);
+                this->_stats = _solver->Stats();
+                return ret;
+            }
+
+            sol.resize(rh.rows(), rh.cols());
+
+            /* Column by column, through the kept workspaces */
+            for(Eigen::Index k = 0; k < rh.cols(); k++)
+            {
+                _col_rh = rh.col(k);
+                if(!solve(_col_rh, _col_sol)) return false;
+                sol.col(k) = _col_sol;
+            }
+
+            return true;
+        }
+
+    private:
+        /*!
+            @brief      Finds the pairs of node and branch unknowns of the grounded voltage sources, and
+            builds the pattern of the reduced matrix (values by index in the matrix).
+            @param      mat     The matrix (compressed, otherwise nothing is eliminated).
+        */
+        void FindEliminated(const MatTp &mat)
+        {
+            IntTp dim = mat.rows();
+            const IntTp *outer = mat.outerIndexPtr();
+            const IntTp *inner = mat.innerIndexPtr();
+            const ScalarTp *vals = mat.valuePtr();
+
+            _node.clear();
+            _branch.clear();
+            _node_val.clear();
+            _branch_val.clear();
+
+            if(!mat.isCompressed()) return;
+
+            /* Non-zeros per row, and the column of the last one */
+            std::vector<IntTp> row_count(dim, 0), row_col(dim, -1);
+
+            for(IntTp j = 0; j < dim; j++)
+            {
+                for(IntTp k = outer[j]; k < outer[j + 1]; k++)
+                {
+                    if(vals[k] == ScalarTp(0)) continue;
+                    row_count[inner[k]]++;
+                    row_col[inner[k]] = j;
+                }
+            }
+
+            /* A branch b, with single non-zeros A(p, b) and A(b, p) on the column/row of its node p */
+            std::vector<IntTp> pair(dim, -1);
+            _map.assign(dim, 0);
+
+            for(IntTp b = 0; b < dim; b++)
+            {
+                if(outer[b + 1] - outer[b] != 1 || row_count[b] != 1) continue;
+
+                IntTp p = inner[outer[b]];
+                if(p == b || row_col[b] != p || vals[outer[b]] == ScalarTp(0) || _map[p] == -1 || _map[b] == -1) continue;
+
+                /* Index of A(b, p) in column p */
+                IntTp bp = -1;
+                for(IntTp k = outer[p]; k < outer[p + 1]; k++) if(inner[k] == b) bp = k;
+
+                _map[p] = _map[b] = -1;
+                pair[p] = _node.size();
+                _node.push_back(p);
+                _branch.push_back(b);
+                _node_val.push_back(outer[b]);
+                _branch_val.push_back(bp);
+            }
+
+            if(_node.empty()) return;
+
+            /* Numbering of the remaining unknowns */
+            IntTp red_dim = 0;
+            for(IntTp k = 0; k < dim; k++) if(_map[k] != -1) _map[k] = red_dim++;
+
+            /* Reduced matrix, column by column (the rows stay sorted), and the couplings of the known nodes */
+            std::vector<IntTp> red_outer(red_dim + 1, 0), red_inner;
+            std::vector<std::vector<IntTp>> col_entries(_node.size());
+            std::vector<std::vector<std::pair<IntTp, IntTp>>> row_entries(_node.size());
+            _src.clear();
+
+            for(IntTp j = 0; j < dim; j++)
+            {
+                for(IntTp k = outer[j]; k < outer[j + 1]; k++)
+                {
+                    IntTp i = inner[k];
+
+                    if(_map[j] != -1 && _map[i] != -1)
+                    {
+                        red_inner.push_back(_map[i]);
+                        _src.push_back(k);
+                    }
+                    else if(pair[j] != -1 && _map[i] != -1) col_entries[pair[j]].push_back(k);
+
+                    if(pair[i] != -1 && j != _branch[pair[i]]) row_entries[pair[i]].push_back({j, k});
+                }
+
+                if(_map[j] != -1) red_outer[_map[j] + 1] = _src.size();
+            }
+
+            std::vector<ScalarTp> red_vals(_src.size());
+            for(size_t k = 0; k < _src.size(); k++) red_vals[k] = vals[_src[k]];
+
+            _red = Eigen::Map<const MatTp>(red_dim, red_dim, _src.size(), red_outer.data(), red_inner.data(), red_vals.data());
+            _vals.assign(vals, vals + mat.nonZeros());
+
+            /* Flattened couplings, by position in the values */
+            _col_ptr.assign(1, 0);
+            _row_ptr.assign(1, 0);
+            _col_row.clear();
+            _col_val.clear();
+            _row_col.clear();
+            _row_val.clear();
+
+            for(size_t e = 0; e < _node.size(); e++)
+            {
+                for(auto k : col_entries[e])
+                {
+                    _col_row.push_back(inner[k]);
+                    _col_val.push_back(k);
+                }
+
+                for(auto &it : row_entries[e])
+                {
+                    _row_col.push_back(it.first);
+                    _row_val.push_back(it.second);
+                }
+
+                _col_ptr.push_back(_col_row.size());
+                _row_ptr.push_back(_row_col.size());
+            }
+
+            _rh_red.resize(red_dim);
+            _sol_red.resize(red_dim);
+        }
+
+        std::unique_ptr<BaseTp> _solver;    //!< The solver of the reduced system.
+        MatTp _red;                         //!< The reduced matrix.
+        std::vector<IntTp> _src;            //!< Position in the values of the matrix, of every non-zero of the reduced matrix.
+        std::vector<ScalarTp> _vals;        //!< The values of the matrix (last factorization).
+        std::vector<IntTp> _map;            //!< Index of every unknown in the reduced system (-1 when eliminated).
+        std::vector<IntTp> _node;           //!< The eliminated nodes.
+        std::vector<IntTp> _branch;         //!< The eliminated branches, same order as the nodes.
+        std::vector<IntTp> _node_val;       //!< Position of A(node, branch) in the values.
+        std::vector<IntTp> _branch_val;     //!< Position of A(branch, node) in the values.
+        std::vector<IntTp> _col_ptr;        //!< Start of the column couplings of each node (A(i, node), i not eliminated).
+        std::vector<IntTp> _col_row;        //!< Row of each column coupling.
+        std::vector<IntTp> _col_val;        //!< Position of each column coupling in the values.
+        std::vector<IntTp> _row_ptr;        //!< Start of the row of each node (A(node, j), j not the branch).
+        std::vector<IntTp> _row_col;        //!< Column of each row entry.
+        std::vector<IntTp> _row_val;        //!< Position of each row entry in the values.
+        VecTp _rh_red;                      //!< Right hand side of the reduced system.
+        VecTp _sol_red;                     //!< Solution of the reduced system.
+        VecTp _col_rh;                      //!< Workspace of a right hand side (solveMulti).
+        VecTp _col_sol;                     //!< Workspace of a solution (solveMulti).
+};
+
+/* Factory and helpers */
+template<typename MatTp> std::unique_ptr<linear_solver<MatTp>> CreateLinearSolver(solver_t type, bool spd);
+const char *SolverName(solver_t type);
+void printSolverStats(const solver_stats_t &stats, solver_t type);
+void accumulateSolverStats(solver_stats_t &dst, const solver_stats_t &src) noexcept;
+
+#endif // __LINEAR_SOLVER_H //
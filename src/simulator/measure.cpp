@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include "measure.hpp"
+
+/*!
+    @brief      Returns the value of a part of a signal.
+    @param      val     The signal.
+    @param      part    The part (MEAS_DEFAULT is resolved when the measurement is added).
+    @return     The value.
+*/
+static double partValue(const std::complex<double> &val, meas_part_t part)
+{
+    switch(part)
+    {
+        case MEAS_IMAG: return val.imag();
+        case MEAS_MAG: return std::abs(val);
+        case MEAS_PHASE: return std::arg(val) * 180 / M_PI;
+        case MEAS_DB: return 20 * std::log10(std::abs(val));
+        default: return val.real();
+    }
+}
+
+/*!
+    @brief      Updates a crossing with the value of its signal at a point.
+    @param      cross   The crossing.
+    @param      px      The previous point.
+    @param      x       The point.
+    @param      y       The value of the signal at the point.
+    @param      first   First point (no previous one).
+*/
+static void updateCrossing(meas_cross_state_t &cross, double px, double x, double y, bool first)
+{
+    double p = cross.py, v = cross.spec.val;
+    cross.py = y;
+
+    if(first || cross.done || cross.spec.at) return;
+
+    bool rise = (p < v && y >= v), fall = (p > v && y <= v);
+    if(!(rise && cross.spec.edge >= 0) && !(fall && cross.spec.edge <= 0)) return;
+
+    double xc = px + (v - p) * (x - px) / (y - p);
+    if(xc < cross.spec.td) return;
+
+    if(++cross.seen == cross.spec.count)
+    {
+        cross.done = true;
+        cross.x = xc;
+    }
+}
+
+/*!
+    @brief      Adds a measurement.
+    @param      spec        The measurement.
+    @param      idx         The unknown of the signal (AVG/RMS/MIN/MAX/PP/INTEG).
+    @param      trig_idx    The unknown of the trigger (TRIG) or the crossing (WHEN).
+    @param      targ_idx    The unknown of the target (TARG).
+    @param      complex     Complex analysis (AC), the default part is the magnitude.
+*/
+void measure_engine::Add(const measure_spec_t &spec, IntTp idx, IntTp trig_idx, IntTp targ_idx, bool complex)
+{
+    meas_state_t meas;
+    meas_part_t part = complex ? MEAS_MAG : MEAS_REAL;
+
+    meas.spec = spec;
+    meas.idx = idx;
+    meas.trig.idx = trig_idx;
+    meas.targ.idx = targ_idx;
+
+    std::transform(spec.name.begin(), spec.name.end(), meas.spec.name.begin(), ::tolower);
+
+    for(auto sig : {&meas.spec.sig, &meas.spec.trig.sig, &meas.spec.targ.sig})
+    {
+        if(sig->part == MEAS_DEFAULT) sig->part = part;
+    }
+
+    _meas.push_back(meas);
+    Reset();
+}
+
+/*!
+    @brief      Resets the accumulators of the measurements (new run of the analysis).
+*/
+void measure_engine::Reset(void)
+{
+    for(auto &it : _meas)
+    {
+        measure_spec_t spec = it.spec;
+        IntTp idx = it.idx, trig_idx = it.trig.idx, targ_idx = it.targ.idx;
+
+        it = meas_state_t();
+        it.spec = spec;
+        it.idx = idx;
+        it.trig.spec = spec.trig;
+        it.trig.idx = trig_idx;
+        it.targ.spec = spec.targ;
+        it.targ.idx = targ_idx;
+
+        /* A fixed point (AT) is known up front */
+        for(auto cross : {&it.trig, &it.targ})
+        {
+            cross->done = cross->spec.at;
+            cross->x = cross->spec.val;
+        }
+    }
+
+    _first = true;
+    _partial = false;
+}
+
+/*!
+    @brief      Updates the measurements with the solution of a point (real analyses).
+    @param      x       The point (time/sweep value).
+    @param      vec     The solution.
+*/
+void measure_engine::Update(double x, const DensVecD &vec)
+{
+    Step(x, vec);
+}
+
+/*!
+    @brief      Updates the measurements with the solution of a point (AC).
+    @param      x       The point (frequency).
+    @param      vec     The solution.
+*/
+void measure_engine::Update(double x, const DensVecCompD &vec)
+{
+    Step(x, vec);
+}
+
+/*!
+    @brief      Updates the measurements with the solution of a point, the range accumulators
+    with the segment from the previous point (clipped to the range) and the crossings.
+    @param      x       The point.
+    @param      vec     The solution.
+*/
+template<typename VecTp>
+void measure_engine::Step(double x, const VecTp &vec)
+{
+    for(auto &it : _meas)
+    {
+        auto &spec = it.spec;
+
+        if(spec.type == MEAS_TRIG_TARG || spec.type == MEAS_WHEN)
+        {
+            for(auto cross : {&it.trig, &it.targ})
+            {
+                if(cross->idx < 0) continue;
+                updateCrossing(*cross, _px, x, partValue(vec[cross->idx], cross->spec.sig.part), _first);
+            }
+
+            continue;
+        }
+
+        double y = partValue(vec[it.idx], spec.sig.part);
+        auto extrema = [&](double val, double at)
+        {
+            if(!it.extrema || val < it.min) { it.min = val; it.min_at = at; }
+            if(!it.extrema || val > it.max) { it.max = val; it.max_at = at; }
+            it.extrema = true;
+        };
+
+        if(_first)
+        {
+            if(x >= spec.from && x <= spec.to) extrema(y, x);
+        }
+        else
+        {
+            /* The segment in increasing order (descending sweeps), clipped to the range */
+            double a = _px, b = x, ya = it.py, yb = y;
+            if(b < a) { std::swap(a, b); std::swap(ya, yb); }
+
+            double s = std::max(a, spec.from), e = std::min(b, spec.to);
+
+            if(e > s)
+            {
+                double ys = ya + (yb - ya) * (s - a) / (b - a);
+                double ye = ya + (yb - ya) * (e - a) / (b - a);
+                double dx = e - s;
+
+                it.integ += 0.5 * (ys + ye) * dx;
+                it.integ_sq += (ys * ys + ys * ye + ye * ye) / 3 * dx;
+                it.span += dx;
+                extrema(ys, s);
+                extrema(ye, e);
+            }
+        }
+
+        it.py = y;
+    }
+
+    _px = x;
+    _first = false;
+}
+
+/*!
+    @brief      Computes the results of the measurements, after the last point.
+*/
+void measure_engine::Finish(void)
+{
+    for(auto &it : _meas)
+    {
+        switch(it.spec.type)
+        {
+            case MEAS_TRIG_TARG: it.valid = it.trig.done && it.targ.done; it.value = it.targ.x - it.trig.x; break;
+            case MEAS_WHEN: it.valid = it.trig.done; it.value = it.trig.x; break;
+            case MEAS_AVG: it.valid = it.span > 0; it.value = it.valid ? it.integ / it.span : 0; break;
+            case MEAS_RMS: it.valid = it.span > 0; it.value = it.valid ? std::sqrt(it.integ_sq / it.span) : 0; break;
+            case MEAS_MIN: it.valid = it.extrema; it.value = it.min; it.at = it.min_at; break;
+            case MEAS_MAX: it.valid = it.extrema; it.value = it.max; it.at = it.max_at; break;
+            case MEAS_PP: it.valid = it.extrema; it.value = it.max - it.min; break;
+            case MEAS_INTEG: it.valid = it.extrema; it.value = it.integ; break;
+        }
+
+        it.valid = it.valid && std::isfinite(it.value) && !_partial;
+    }
+}
+
+/*!
+    @brief      Saves the accumulators of the measurements, for a checkpoint.
+    @param      state       The accumulators (flat).
+*/
+void measure_engine::Save(std::vector<double> &state) const
+{
+    state.clear();
+    state.push_back(_meas.size());
+    state.push_back(_first);
+    state.push_back(_px);
+
+    for(auto &it : _meas)
+    {
+        for(auto cross : {&it.trig, &it.targ}) state.insert(state.end(), {cross->py, (double) cross->seen, (double) cross->done, cross->x});
+
+        state.insert(state.end(), {it.py, it.integ, it.integ_sq, it.span, (double) it.extrema, it.min, it.min_at, it.max, it.max_at});
+    }
+}
+
+/*!
+    @brief      Restores the accumulators of the measurements, saved by Save().
+    @param      state       The accumulators (flat).
+    @return     True in case of success, otherwise false (other measurements, nothing is restored).
+*/
+bool measure_engine::Restore(const std::vector<double> &state)
+{
+    constexpr size_t per_meas = 2 * 4 + 9;
+
+    if(state.size() != 3 + _meas.size() * per_meas || state[0] != _meas.size()) return false;
+
+    auto it_in = state.begin() + 1;
+
+    _first = *it_in++ != 0;
+    _px = *it_in++;
+
+    for(auto &it : _meas)
+    {
+        for(auto cross : {&it.trig, &it.targ})
+        {
+            cross->py = *it_in++;
+            cross->seen = static_cast<int>(*it_in++);
+            cross->done = *it_in++ != 0;
+            cross->x = *it_in++;
+        }
+
+        it.py = *it_in++;
+        it.integ = *it_in++;
+        it.integ_sq = *it_in++;
+        it.span = *it_in++;
+        it.extrema = *it_in++ != 0;
+        it.min = *it_in++;
+        it.min_at = *it_in++;
+        it.max = *it_in++;
+        it.max_at = *it_in++;
+    }
+
+    return true;
+}
+
+/*!
+    @brief      Prints the results of the measurements.
+*/
+void measure_engine::Print(void) const
+{
+    for(auto &it : _meas)
+    {
+        std::cout << it.spec.name << " = ";
+
+        if(!it.valid) std::cout << "failed";
+        else std::cout << it.value;
+
+        if(it.valid && (it.spec.type == MEAS_MIN || it.spec.type == MEAS_MAX)) std::cout << " at " << it.at;
+
+        std::cout << "\n";
+    }
+}
+
+/*!
+    @brief      Writes the results of the measurements to a JSON file.
+    @param      file        The file.
+    @param      title       The title of the simulation (netlist).
+    @param      analysis    The analysis (TRAN/AC/DC).
+    @return     True in case of success, otherwise false.
+*/
+bool measure_engine::WriteJSON(const std::string &file, const std::string &title, const std::string &analysis) const
+{
+    static const char *types[] = {"TRIG_TARG", "WHEN", "AVG", "RMS", "MIN", "MAX", "PP", "INTEG"};
+    std::ofstream out(file, std::ios::trunc);
+
+    auto str = [](const std::string &val)
+    {
+        std::string esc = "\"";
+
+        for(char c : val)
+        {
+            if(c == '"' || c == '\\') esc += '\\';
+            esc += c;
+        }
+
+        return esc + "\"";
+    };
+
+    out << std::setprecision(std::numeric_limits<double>::max_digits10);
+    out << "{\n  \"title\": " << str(title) << ",\n  \"analysis\": " << str(analysis) << ",\n  \"measurements\": [";
+
+    for(size_t k = 0; k < _meas.size(); k++)
+    {
+        auto &it = _meas[k];
+
+        out << (k ? ",\n" : "\n") << "    {\"name\": " << str(it.spec.name) << ", \"type\": \"" << types[it.spec.type] << "\"";
+        out << ", \"valid\": " << (it.valid ? "true" : "false") << ", \"value\": ";
+
+        if(it.valid) out << it.value;
+        else out << "null";
+
+        if(it.valid && (it.spec.type == MEAS_MIN || it.spec.type == MEAS_MAX)) out << ", \"at\": " << it.at;
+
+        out << "}";
+    }
+
+    out << "\n  ]\n}\n";
+    out.close();
+
+    return static_cast<bool>(out);
+}
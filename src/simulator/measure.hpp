@@ -0,0 +1,84 @@
+#ifndef __MEASURE_H
+#define __MEASURE_H
+
+#include <complex>
+#include "matrix_types.hpp"
+#include "simulator_types.hpp"
+
+/** State of a crossing of a measurement (TRIG/TARG/WHEN). */
+typedef struct measure_crossing_state
+{
+    meas_cross_t spec;              //!< The crossing.
+    IntTp idx = -1;                 //!< The unknown of the signal.
+    double py = 0;                  //!< The value of the signal at the previous point.
+    int seen = 0;                   //!< Crossings counted.
+    bool done = false;              //!< The crossing was found.
+    double x = 0;                   //!< The point of the crossing.
+} meas_cross_state_t;
+
+/** State of a measurement, the accumulators are updated at every point. */
+typedef struct measure_state
+{
+    measure_spec_t spec;            //!< The measurement.
+    IntTp idx = -1;                 //!< The unknown of the signal (AVG/RMS/MIN/MAX/PP/INTEG).
+    meas_cross_state_t trig;        //!< The trigger (TRIG) or the crossing (WHEN).
+    meas_cross_state_t targ;        //!< The target (TARG).
+
+    /* Accumulators of the range, the signal is linear between the points */
+    double py = 0;                  //!< The value of the signal at the previous point.
+    double integ = 0;               //!< Integral of the signal.
+    double integ_sq = 0;            //!< Integral of the square of the signal.
+    double span = 0;                //!< Length of the range covered.
+    bool extrema = false;           //!< The minimum/maximum are set.
+    double min = 0, min_at = 0;     //!< The minimum and its point.
+    double max = 0, max_at = 0;     //!< The maximum and its point.
+
+    /* The result */
+    bool valid = false;             //!< The measurement succeeded.
+    double value = 0;               //!< The value.
+    double at = 0;                  //!< The point of the value (MIN/MAX).
+} meas_state_t;
+
+//! Online evaluation of the measurements (MEASURE cards) of an analysis.
+/*!
+  The measurements are updated with the solution of every point, in order, and keep only the
+  accumulators (previous point, integrals, extrema, crossings counted), so no waveform is stored
+  and the memory is constant regardless of the number of points. Between two points the signals
+  are linear, the crossings and the ends of the ranges are interpolated.
+*/
+class measure_engine
+{
+    public:
+        void Add(const measure_spec_t &spec, IntTp idx, IntTp trig_idx, IntTp targ_idx, bool complex);
+        void Reset(void);
+        void Update(double x, const DensVecD &vec);
+        void Update(double x, const DensVecCompD &vec);
+        void Finish(void);
+        void Print(void) const;
+        bool WriteJSON(const std::string &file, const std::string &title, const std::string &analysis) const;
+
+        /* Checkpoints, the accumulators are saved and restored */
+        void Save(std::vector<double> &state) const;
+        bool Restore(const std::vector<double> &state);
+
+        /*!
+            @brief      Marks the points before a restart as missing (not restored), the results are invalid.
+        */
+        void Partial(void) noexcept { _partial = true; }
+
+        /*!
+            @brief      Returns whether there are no measurements.
+            @return     True for none, otherwise false.
+        */
+        bool Empty(void) const noexcept { return _meas.empty(); }
+
+    private:
+        template<typename VecTp> void Step(double x, const VecTp &vec);
+
+        std::vector<meas_state_t> _meas;    //!< The measurements.
+        bool _first = true;                 //!< No point yet.
+        double _px = 0;                     //!< The previous point.
+        bool _partial = false;              //!< Points are missing, the results are invalid.
+};
+
+#endif // __MEASURE_H //
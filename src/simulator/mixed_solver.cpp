@@ -0,0 +1,210 @@
+#include <limits>
+#include "mixed_solver.hpp"
+
+/*!
+    @brief      Performs the symbolic analysis of the reduced precision matrix.
+    @param      mat     The matrix.
+    @return     True in case of success, otherwise false.
+*/
+template<typename MatTp>
+bool mixed_linear_solver<MatTp>::analyze(const MatTp &mat)
+{
+    auto begin = std::chrono::high_resolution_clock::now();
+    bool ret = true;
+
+    _mat = mat;
+    _mat.makeCompressed();
+
+    if(_full)
+    {
+        ret = _full->analyze(_mat);
+    }
+    else
+    {
+        _low_mat = _mat.template cast<LowScalarTp>();
+        _low_solver = std::make_unique<LowSolverTp>();
+        _low_solver->analyzePattern(_low_mat);
+    }
+
+    this->_stats.analyze_count++;
+    this->_stats.analyze_time += this->elapsed(begin);
+
+    return ret;
+}
+
+/*!
+    @brief      Performs the reduced precision numeric factorization, same pattern as analyzed.
+    @param      mat     The matrix.
+    @return     True in case of success, otherwise false.
+*/
+template<typename MatTp>
+bool mixed_linear_solver<MatTp>::refactor(const MatTp &mat)
+{
+    auto begin = std::chrono::high_resolution_clock::now();
+    bool ret = true;
+
+    _mat = mat;
+    _mat.makeCompressed();
+
+    if(_full)
+    {
+        ret = _full->refactor(_mat);
+    }
+    else
+    {
+        /* Same pattern, only the values are rounded */
+        const ScalarTp *vals = _mat.valuePtr();
+        LowScalarTp *low_vals = _low_mat.valuePtr();
+        IntTp nnz = _mat.nonZeros();
+
+        for(IntTp idx = 0; idx < nnz; idx++) low_vals[idx] = static_cast<LowScalarTp>(vals[idx]);
+
+        _low_solver->factorize(_low_mat);
+
+        /* 1-norm, max absolute column sum */
+        _mat_norm = 0;
+        for(IntTp col = 0; col < _mat.outerSize(); col++) _mat_norm = std::max(_mat_norm, (double)_mat.col(col).cwiseAbs().sum());
+
+        if(_low_solver->info() == Eigen::Success)
+        {
+            /* The factors shrink, but both matrices are kept: full precision (residuals) and reduced (factorization) */
+            double nnz_lu = _low_solver->nnzL() + _low_solver->nnzU();
+            double nnz = _mat.nonZeros();
+            double index_sz = (nnz + _mat.outerSize() + 1) * sizeof(IntTp);
+            double copies_sz = nnz * (sizeof(ScalarTp) + sizeof(LowScalarTp)) + 2 * index_sz;
+
+            this->_stats.factor_memory = nnz_lu * (sizeof(LowScalarTp) + sizeof(IntTp)) + copies_sz;
+            this->_stats.memory_saved = nnz_lu * (sizeof(ScalarTp) - sizeof(LowScalarTp)) - copies_sz;
+        }
+        else
+        {
+            ret = SwitchToFull();
+        }
+    }
+
+    this->_stats.factor_count++;
+    this->_stats.factor_time += this->elapsed(begin);
+
+    return ret;
+}
+
+/*!
+    @brief      Solves the system for one right hand side, with iterative refinement.
+    @param      rh      The right hand side.
+    @param      sol     The solution.
+    @return     True in case of success, otherwise false.
+*/
+template<typename MatTp>
+bool mixed_linear_solver<MatTp>::solve(const VecTp &rh, VecTp &sol)
+{
+    auto begin = std::chrono::high_resolution_clock::now();
+    bool ret = _full ? _full->solve(rh, sol) : Refine(rh, sol);
+
+    this->_stats.solve_count++;
+    this->_stats.solve_time += this->elapsed(begin);
+
+    return ret;
+}
+
+/*!
+    @brief      Solves the system for many right hand sides, each one refined separately.
+    @param      rh      The right hand sides (columns).
+    @param      sol     The solutions (columns).
+    @return     True in case of success, otherwise false.
+*/
+template<typename MatTp>
+bool mixed_linear_solver<MatTp>::solveMulti(const MultiVecTp &rh, MultiVecTp &sol)
+{
+    auto begin = std::chrono::high_resolution_clock::now();
+    bool ret = true;
+
+    if(_full)
+    {
+        ret = _full->solveMulti(rh, sol);
+    }
+    else
+    {
+        VecTp col_rh, col_sol;
+        sol.resize(rh.rows(), rh.cols());
+
+        for(Eigen::Index col = 0; col < rh.cols() && ret; col++)
+        {
+            col_rh = rh.col(col);
+
+            /* A stalled refinement switches the solver, the rest of the columns go there */
+            ret = _full ? _full->solve(col_rh, col_sol) : Refine(col_rh, col_sol);
+            sol.col(col) = col_sol;
+        }
+    }
+
+    this->_stats.solve_count += rh.cols();
+    this->_stats.solve_time += this->elapsed(begin);
+
+    return ret;
+}
+
+/*!
+    @brief      Solves with the reduced precision factors and refines the solution, until the
+    normwise backward error ||b - A*x|| / (||A||*||x|| + ||b||) reaches the full precision level.
+    In case the refinement stalls, the solver switches to full precision and solves again.
+    @param      rh      The right hand side.
+    @param      sol     The solution.
+    @return     True in case of success, otherwise false.
+*/
+template<typename MatTp>
+bool mixed_linear_solver<MatTp>::Refine(const VecTp &rh, VecTp &sol)
+{
+    const double tol = 64 * std::numeric_limits<FpTp>::epsilon();
+    double rh_norm = rh.template lpNorm<1>();
+    double res_prev = std::numeric_limits<double>::infinity();
+
+    LowVecTp low_rh = rh.template cast<LowScalarTp>();
+    sol = _low_solver->solve(low_rh).template cast<ScalarTp>();
+    if(_low_solver->info() != Eigen::Success) return false;
+
+    for(IntTp iter = 0; iter <= _max_iters; iter++)
+    {
+        VecTp res = rh - _mat * sol;
+        double res_norm = res.template lpNorm<1>();
+
+        if(!std::isfinite(res_norm)) break;
+        if(res_norm <= tol * (_mat_norm * sol.template lpNorm<1>() + rh_norm)) return true;
+        if(res_norm > _stall_ratio * res_prev || iter == _max_iters) break;
+
+        /* Correction in reduced precision */
+        low_rh = res.template cast<LowScalarTp>();
+        sol += _low_solver->solve(low_rh).template cast<ScalarTp>();
+
+        res_prev = res_norm;
+        this->_stats.iterations++;
+    }
+
+    /* Stalled, continue in full precision */
+    if(!SwitchToFull()) return false;
+
+    return _full->solve(rh, sol);
+}
+
+/*!
+    @brief      Switches permanently to the default full precision LU solver, for the current matrix.
+    The reduced precision factors are released.
+    @return     True in case of success, otherwise false.
+*/
+template<typename MatTp>
+bool mixed_linear_solver<MatTp>::SwitchToFull(void)
+{
+    _full = CreateLinearSolver<MatTp>(SOLVER_AUTO, false);
+
+    _low_solver.reset();
+    _low_mat = LowMatTp();
+
+    this->_stats.memory_saved = 0;
+    this->_stats.factor_memory = 0;
+    this->_stats.precision_fallback = true;
+
+    return _full->factor(_mat);
+}
+
+/* Explicit instantiations - Real and complex systems */
+template class mixed_linear_solver<SparMatD>;
+template class mixed_linear_solver<SparMatCompD>;
@@ -0,0 +1,59 @@
+#ifndef __MIXED_SOLVER_H
+#define __MIXED_SOLVER_H
+
+#include "linear_solver.hpp"
+
+//! Mixed precision linear solver, reduced precision LU with iterative refinement.
+/*!
+  The matrix is factorized in reduced precision (FpLowTp), which halves the memory of the
+  factors, and every solve is refined against the full precision matrix:\n
+  r = b - A * x, A_low * dx = r, x = x + dx\n
+  until the normwise backward error reaches the full precision level. When the refinement
+  stalls (badly conditioned systems) or the reduced precision factorization fails, the solver
+  switches permanently to the default full precision LU.\n
+  The matrix is kept in both precisions (residuals and factorization), so the net saving against
+  a full precision LU is the factor saving minus the two copies, a loss for factors with little fill.
+*/
+template<typename MatTp>
+class mixed_linear_solver : public linear_solver<MatTp>
+{
+    public:
+        typedef linear_solver<MatTp> BaseTp;                //!< The interface.
+        typedef typename BaseTp::ScalarTp ScalarTp;         //!< Scalar of the system.
+        typedef typename BaseTp::VecTp VecTp;               //!< Dense vector type.
+        typedef typename BaseTp::MultiVecTp MultiVecTp;     //!< Dense multi-vector type.
+
+        /** Reduced precision scalar, real or complex as the system. */
+        typedef typename std::conditional<std::is_same<ScalarTp, FpTp>::value, FpLowTp, std::complex<FpLowTp>>::type LowScalarTp;
+
+        typedef Eigen::SparseMatrix<LowScalarTp, Eigen::ColMajor, IntTp> LowMatTp;             //!< Reduced precision matrix.
+        typedef Eigen::Matrix<LowScalarTp, Eigen::Dynamic, 1> LowVecTp;                         //!< Reduced precision vector.
+        typedef Eigen::SparseLU<LowMatTp, Eigen::COLAMDOrdering<IntTp>> LowSolverTp;            //!< Reduced precision LU.
+
+        /*!
+            @brief      Constructor.
+            @param      type    The type of the implementation.
+        */
+        mixed_linear_solver(solver_t type) noexcept : BaseTp(type) {}
+
+        /* Solver phases */
+        bool analyze(const MatTp &mat) override;
+        bool refactor(const MatTp &mat) override;
+        bool solve(const VecTp &rh, VecTp &sol) override;
+        bool solveMulti(const MultiVecTp &rh, MultiVecTp &sol) override;
+
+    private:
+        bool Refine(const VecTp &rh, VecTp &sol);
+        bool SwitchToFull(void);
+
+        static constexpr IntTp _max_iters = 10;         //!< Maximum refinement iterations per solve.
+        static constexpr double _stall_ratio = 0.5;     //!< Minimum residual reduction per iteration.
+
+        MatTp _mat;                                     //!< The full precision matrix (residuals).
+        LowMatTp _low_mat;                              //!< The reduced precision matrix.
+        std::unique_ptr<LowSolverTp> _low_solver;       //!< The reduced precision factorization.
+        double _mat_norm = 0;                           //!< 1-norm of the matrix (backward error).
+        std::unique_ptr<linear_solver<MatTp>> _full;    //!< Full precision solver, after a fallback.
+};
+
+#endif // __MIXED_SOLVER_H //
@@ -12,6 +12,7 @@ MNA::MNA() noexcept
     _vcvs_offset = 0;
     _ccvs_offset = 0;
     _sweep_source_idx = 0;
+    _spd = false;
     _sim_step = 0;
     _analysis_type = OP;
     _scale = DEC_SCALE;
@@ -54,6 +55,14 @@ as_scale_t MNA::AnalysisScale(void) noexcept { return _scale; }
 */
 IntTp MNA::SystemDim(void) noexcept { return _system_dim; }
 
+/*!
+    @brief      Returns whether the real MNA matrices (OP/DC/TRAN) are symmetric positive
+    definite once the grounded voltage sources are eliminated, so that a Cholesky factorization
+    can be used instead of LU.
+    @return     True in case of an SPD system, otherwise false.
+*/
+bool MNA::SPDSystem(void) noexcept { return _spd; }
+
 /*!
     @brief      Returns the simulation step.
     @return     The simulation step.
@@ -79,6 +88,18 @@ const std::vector<IntTp> &MNA::NodesIdx(void) noexcept { return _nodes_idx; }
 */
 const std::vector<IntTp> &MNA::SourceIdx(void) noexcept { return _sources_idx; }
 
+/*!
+    @brief      Returns the indices of the nodes with an initial voltage (IC card).
+    @return     The indices vector.
+*/
+const std::vector<IntTp> &MNA::ICIdx(void) noexcept { return _ic_idx; }
+
+/*!
+    @brief      Returns the initial voltages of the nodes, according to ICIdx() order.
+    @return     The voltages vector.
+*/
+const std::vector<double> &MNA::ICValues(void) noexcept { return _ic_vals; }
+
 
 
 /*!
@@ -734,6 +755,120 @@ void MNA::UpdateTRANVec(DensVecD &rh, double time)
 	}
 }
 
+/*!
+	@brief      Fills the breakpoint queue with the corners of every transient source,
+	and prepares it for the simulation time range.
+	@param		queue		The breakpoint queue.
+*/
+void MNA::CreateTRANBreakpoints(breakpoint_queue &queue)
+{
+	for(auto &it : this->_ivs) queue.AddSource(it.Type(), it.TranTimes(), it.TranVals());
+	for(auto &it : this->_ics) queue.AddSource(it.Type(), it.TranTimes(), it.TranVals());
+
+	queue.Build(this->_sim_vals.front(), this->_sim_vals.back(), (this->_sim_vals.back() - this->_sim_vals.front()) * 1e-12);
+}
+
+/*!
+	@brief      Returns the rows of the right hand side vector that the transient sources
+	update (see UpdateTRANVec).
+	@param		rows		The rows, without repetitions.
+*/
+void MNA::CreateTRANSourceRows(std::vector<IntTp> &rows)
+{
+	std::vector<bool> found(this->_system_dim, false);
+	auto add = [&](IntTp row)
+	{
+		if(row == -1 || found[row]) return;
+		found[row] = true;
+		rows.push_back(row);
+	};
+
+	rows.clear();
+	for(size_t k = 0; k < this->_ivs.size(); k++) add(this->_ivs_offset + k);
+
+	for(auto &it : this->_ics)
+	{
+		add(it.PosNodeID());
+		add(it.NegNodeID());
+	}
+}
+
+/*!
+	@brief      Splits the unknowns of the transient system in the groups that are strongly
+	coupled, the connected components of the packed element graph without the weak couplings:
+	- Resistors, coils and voltage sources (including the outputs of the controlled ones) join their
+	nodes and branch currents.
+	- Floating capacitors (both nodes not ground) and the controlling side of the controlled sources
+	are the weak couplings and are not followed.\n
+	The components are numbered from 0, in order of their first unknown.
+	@param		comp		The component of every unknown.
+	@return		The number of components.
+*/
+IntTp MNA::CreateTRANPartitions(std::vector<IntTp> &comp)
+{
+	std::vector<IntTp> parent(this->_system_dim);
+	for(IntTp k = 0; k < this->_system_dim; k++) parent[k] = k;
+
+	/* Union-find, with path halving */
+	auto find = [&](IntTp k)
+	{
+		while(parent[k] != k) k = parent[k] = parent[parent[k]];
+		return k;
+	};
+
+	auto join = [&](IntTp a, IntTp b)
+	{
+		if(a == -1 || b == -1) return;
+		a = find(a);
+		b = find(b);
+		if(a != b) parent[std::max(a, b)] = std::min(a, b);
+	};
+
+	IntTp offset;
+
+	for(auto &it : this->_res) join(it.PosNodeID(), it.NegNodeID());
+
+	offset = this->_coil_offset;
+	for(auto &it : this->_coils)
+	{
+		join(it.PosNodeID(), offset);
+		join(it.NegNodeID(), offset++);
+	}
+
+	offset = this->_ivs_offset;
+	for(auto &it : this->_ivs)
+	{
+		join(it.PosNodeID(), offset);
+		join(it.NegNodeID(), offset++);
+	}
+
+	offset = this->_vcvs_offset;
+	for(auto &it : this->_vcvs)
+	{
+		join(it.PosNodeID(), offset);
+		join(it.NegNodeID(), offset++);
+	}
+
+	offset = this->_ccvs_offset;
+	for(auto &it : this->_ccvs)
+	{
+		join(it.PosNodeID(), offset);
+		join(it.NegNodeID(), offset++);
+	}
+
+	/* Number the components, the root is the first unknown of its component */
+	IntTp count = 0;
+	comp.resize(this->_system_dim);
+
+	for(IntTp k = 0; k < this->_system_dim; k++)
+	{
+		IntTp root = find(k);
+		comp[k] = (root == k) ? count++ : comp[root];
+	}
+
+	return count;
+}
+
 
 
 /*!
@@ -941,7 +1076,7 @@ void MNA::CreateMNASystemAC(DensVecCompD &rh)
 
 
 /*!
-    @brief      Create the plot nodes/sources indices.
+    @brief      Create the plot nodes/sources indices and the initial conditions indices.
     @param      circuit_manager     The circuit.
 */
 void MNA::CreatePlotIdx(circuit &circuit_manager)
@@ -971,6 +1106,70 @@ void MNA::CreatePlotIdx(circuit &circuit_manager)
         /* For voltage sources, (IVSoffset + <idx in the IVS vector>) */
         this->_sources_idx.push_back(tmp->second + this->_ivs_offset);
     }
+
+    /* Initial conditions, the nodes always exist */
+    for(auto &it : circuit_manager.ICNodes()) this->_ic_idx.push_back(nodesmap.find(it)->second);
+    this->_ic_vals = circuit_manager.ICValues();
+}
+
+/*!
+    @brief      Returns the names of all the unknowns of the MNA system, in the order of the system.
+    The node voltages first (node names), then the currents of the voltage-source-like elements
+    (element names).
+    @param      circuit_manager     The circuit.
+    @return     The names.
+*/
+std::vector<std::string> MNA::UnknownNames(circuit &circuit_manager)
+{
+    std::vector<std::string> names(this->_system_dim);
+
+    for(auto &it : circuit_manager.Nodes()) names[it.second] = it.first;
+
+    for(auto &it : circuit_manager.ElementNames())
+    {
+        IntTp offset = BranchOffset(it.first[0]);
+        if(offset >= 0) names[offset + it.second] = it.first;
+    }
+
+    return names;
+}
+
+/*!
+    @brief      Returns the index of an unknown of the MNA system, the voltage of a node or the
+    current of a voltage-source-like element.
+    @param      circuit_manager     The circuit.
+    @param      name                The node or the element.
+    @param      current             Current of the element, otherwise voltage of the node.
+    @return     The index, -1 when there is no such unknown.
+*/
+IntTp MNA::UnknownIdx(circuit &circuit_manager, const std::string &name, bool current)
+{
+    auto &map = current ? circuit_manager.ElementNames() : circuit_manager.Nodes();
+    auto it = map.find(name);
+
+    if(it == map.end()) return -1;
+    if(!current) return it->second;
+
+    IntTp offset = BranchOffset(name[0]);
+
+    return (offset >= 0) ? offset + it->second : -1;
+}
+
+/*!
+    @brief      Returns the offset of the current unknowns of a type of element.
+    @param      type    The type of element (first letter of the name).
+    @return     The offset, -1 for the elements without a current unknown.
+*/
+IntTp MNA::BranchOffset(char type) noexcept
+{
+    switch(type)
+    {
+        case 'V': return this->_ivs_offset;
+        case 'L': return this->_coil_offset;
+        case 'E': return this->_vcvs_offset;
+        case 'H': return this->_ccvs_offset;
+        default: return -1;
+    }
 }
 
 /*!
@@ -1053,6 +1252,9 @@ void MNA::SetMNAParams(circuit &circuit_manager)
     _system_dim = _ccvs_offset + _ccvs.size();
     // SOS!
 
+    /* Structure of the system, decides the factorization used */
+    _spd = CheckSPDStructure();
+
     _analysis_type = circuit_manager.AnalysisType();
     _scale = circuit_manager.AnalysisScale();
 
@@ -1093,6 +1295,45 @@ void MNA::SetMNAParams(circuit &circuit_manager)
     }
 }
 
+/*!
+    @brief      Checks the packed element lists, for a structure that results in a symmetric
+    positive (semi)definite MNA system, once the grounded voltage sources are eliminated. This holds
+    when the circuit consists only of resistors, capacitors (positive values), current sources and
+    voltage sources with one terminal to ground, each on a node of its own. Such a source fixes the
+    voltage of its node, the solver moves it to the right hand side and drops the node and branch
+    unknowns (see reduced_linear_solver), so no branch equations (zero diagonal) or unsymmetric stamps
+    (controlled sources) remain. Definiteness also needs a DC path to ground (or to a source) for each
+    node, which is verified later by the factorization itself.
+    @return     True in case of an SPD structure, otherwise false.
+*/
+bool MNA::CheckSPDStructure(void)
+{
+    /* Voltage-like elements introduce branch equations with zero diagonal */
+    if(!this->_coils.empty() || !this->_vcvs.empty() || !this->_ccvs.empty()) return false;
+
+    /* Controlled current sources create unsymmetric stamps */
+    if(!this->_vccs.empty() || !this->_cccs.empty()) return false;
+
+    /* Voltage sources only when eliminated, one terminal to ground and one source per node */
+    std::vector<bool> fixed(this->_ivs_offset, false);
+
+    for(auto &it : this->_ivs)
+    {
+        auto pos = it.PosNodeID(), neg = it.NegNodeID();
+        if((pos == -1) == (neg == -1)) return false;
+
+        auto node = (pos == -1) ? neg : pos;
+        if(fixed[node]) return false;
+        fixed[node] = true;
+    }
+
+    /* Negative conductances/capacitances break definiteness */
+    for(auto &it : this->_res) if(it.Val() <= 0) return false;
+    for(auto &it : this->_caps) if(it.Val() < 0) return false;
+
+    return this->_system_dim > 0;
+}
+
 /*!
     @brief      Prints the triplet matrix given. Used only for debugging.
     @param      mat     The triplet matrix to be printed.
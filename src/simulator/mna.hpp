@@ -4,6 +4,7 @@
 #include "circuit.hpp"
 #include "matrix_types.hpp"
 #include "math_util.hpp"
+#include "breakpoints.hpp"
 
 
 
@@ -30,10 +31,15 @@ class MNA
         analysis_t AnalysisType(void) noexcept;
         as_scale_t AnalysisScale(void) noexcept;
 		IntTp SystemDim(void) noexcept;
+		bool SPDSystem(void) noexcept;
         double SimStep(void) noexcept;
 		const std::vector<double> &SimVals(void) noexcept;
 		const std::vector<IntTp> &NodesIdx(void) noexcept;
 		const std::vector<IntTp> &SourceIdx(void) noexcept;
+		const std::vector<IntTp> &ICIdx(void) noexcept;
+		const std::vector<double> &ICValues(void) noexcept;
+		std::vector<std::string> UnknownNames(circuit &circuit_manager);
+		IntTp UnknownIdx(circuit &circuit_manager, const std::string &name, bool current);
 
         /* MNA and systems formation */
         void CreateMNASystemOP(SparMatD &mat, DensVecD &rh);
@@ -41,10 +47,15 @@ class MNA
 		void UpdateMNASystemDCVec(DensVecD &rh, double sweep_val);
 		void CreateMNASystemTRAN(SparMatD &mat);
 		void UpdateTRANVec(DensVecD &rh, double time);
+		void CreateTRANBreakpoints(breakpoint_queue &queue);
+		void CreateTRANSourceRows(std::vector<IntTp> &rows);
+		IntTp CreateTRANPartitions(std::vector<IntTp> &comp);
         void CreateMNASystemAC(SparMatCompD &mat, double freq);
         void CreateMNASystemAC(DensVecCompD &rh);
 
 	private:
+		IntTp BranchOffset(char type) noexcept;
+
 		/* MNA stampers */
 		void ResMNAStamp(tripletList_d &mat, resistor_packed &res);
 		void CoilMNAStamp(tripletList_d &mat, IntTp offset, coil_packed &coil, const analysis_t type);
@@ -78,6 +89,7 @@ class MNA
         void CreatePlotIdx(circuit &circuit_manager);
         void CreatePackedVecs(circuit &circuit_manager);
         void SetMNAParams(circuit &circuit_manager);
+        bool CheckSPDStructure(void);
 
 		/* Debug functionalities */
 		void debug_triplet_mat(tripletList_d &mat);
@@ -88,6 +100,7 @@ class MNA
 		IntTp _coil_offset;                     //!< The offset of the coils in the MNA array/vectors.
         IntTp _vcvs_offset;                     //!< The offset of the VCVS in the MNA array/vectors.
         IntTp _ccvs_offset;                     //!< The offset of the CCVS in the MNA array/vectors.
+        bool _spd;                              //!< Whether the MNA matrices are symmetric positive definite.
 
 		/* Elements */
         std::vector<resistor_packed> _res;      //!< Packed representation of resistors in the circuit.
@@ -109,6 +122,10 @@ class MNA
         std::vector<IntTp> _nodes_idx;          //!< The indices of the nodes, for plotting.
         IntTp _sweep_source_idx;                //!< The index of the source, in case of DC analysis.
 
+        /* Initial conditions (transient) */
+        std::vector<IntTp> _ic_idx;             //!< The indices of the nodes with an initial voltage.
+        std::vector<double> _ic_vals;           //!< The initial voltages, in the order of _ic_idx.
+
         /* Simulation info */
 		analysis_t _analysis_type;              //!< The type of analysis performed.
 		as_scale_t _scale;                      //!< Scale of the analysis.
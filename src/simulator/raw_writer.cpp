@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include "raw_writer.hpp"
+
+/*!
+    @brief      Constructor, writes the header and starts the I/O thread.
+    @param      file        The rawfile.
+    @param      title       The title of the simulation.
+    @param      plotname    The name of the plot (e.g. Transient Analysis).
+    @param      vars        The variables, the scale (time/frequency/sweep) first.
+    @param      complex     Complex plot (AC), otherwise real.
+*/
+raw_writer::raw_writer(const std::string &file, const std::string &title, const std::string &plotname,
+                       const std::vector<raw_var_t> &vars, bool complex)
+                       : _out(file, std::ios::binary | std::ios::trunc)
+{
+    std::time_t now = std::time(nullptr);
+    char date[64];
+
+    std::strftime(date, sizeof(date), "%a %b %d %H:%M:%S %Y", std::localtime(&now));
+
+    _out << "Title: " << title << "\n";
+    _out << "Date: " << date << "\n";
+    _out << "Plotname: " << plotname << "\n";
+    _out << "Flags: " << (complex ? "complex" : "real") << "\n";
+    _out << "No. Variables: " << vars.size() << "\n";
+    _out << "No. Points: ";
+    _points_pos = _out.tellp();
+    _out << std::setw(_points_width) << std::left << 0 << "\n";
+    _out << "Variables:\n";
+
+    for(size_t i = 0; i < vars.size(); i++) _out << "\t" << i << "\t" << vars[i].name << "\t" << vars[i].type << "\n";
+
+    _out << "Binary:\n";
+
+    _failed = !_out;
+    _point_sz = vars.size() * (complex ? 2 : 1);
+    _ring.resize(std::max<size_t>(_point_sz, 1) * _buffer_points);
+
+    _thread = std::thread(&raw_writer::Drain, this);
+}
+
+/*!
+    @brief      Destructor, finishes the file in case it was not finished.
+*/
+raw_writer::~raw_writer()
+{
+    Finish();
+}
+
+/*!
+    @brief      Pushes a point in the ring buffer, waits while the buffer is full.
+    @param      point       The point (PointSize() doubles).
+*/
+void raw_writer::Push(const double *point)
+{
+    size_t cap = _ring.size();
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    _not_full.wait(lock, [&]() { return cap - (_head - _tail) >= _point_sz; });
+    size_t pos = _head % cap;
+    lock.unlock();
+
+    /* Only this thread writes the free part of the buffer */
+    size_t first = std::min(_point_sz, cap - pos);
+    std::memcpy(_ring.data() + pos, point, first * sizeof(double));
+    std::memcpy(_ring.data(), point + first, (_point_sz - first) * sizeof(double));
+
+    lock.lock();
+    _head += _point_sz;
+    _points++;
+    lock.unlock();
+
+    _not_empty.notify_one();
+}
+
+/*!
+    @brief      Waits for the buffer to be written, patches the number of points and closes the file.
+    @return     True in case of success, otherwise false (I/O failure).
+*/
+bool raw_writer::Finish(void)
+{
+    if(_finished) return !_failed;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _done = true;
+    }
+
+    _not_empty.notify_one();
+    _thread.join();
+
+    _out.seekp(_points_pos);
+    _out << std::setw(_points_width) << std::left << _points;
+    _out.close();
+
+    _failed = _failed || !_out;
+    _finished = true;
+
+    return !_failed;
+}
+
+/*!
+    @brief      The I/O thread, writes the contiguous parts of the buffer until it is done.
+*/
+void raw_writer::Drain(void)
+{
+    size_t cap = _ring.size();
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while(true)
+    {
+        _not_empty.wait(lock, [&]() { return _head != _tail || _done; });
+        if(_head == _tail) break;
+
+        /* Up to the end of the buffer, the rest in the next iteration */
+        size_t pos = _tail % cap;
+        size_t count = std::min(_head - _tail, cap - pos);
+        lock.unlock();
+
+        _out.write(reinterpret_cast<const char *>(_ring.data() + pos), count * sizeof(double));
+
+        lock.lock();
+        _failed = _failed || !_out;
+        _tail += count;
+        _not_full.notify_one();
+    }
+}
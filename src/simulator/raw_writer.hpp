@@ -0,0 +1,74 @@
+#ifndef __RAW_WRITER_H
+#define __RAW_WRITER_H
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** A variable of a SPICE rawfile. */
+typedef struct raw_variable
+{
+    std::string name;               //!< The name (e.g. v(1), i(v1)).
+    std::string type;               //!< The type (time, frequency, voltage, current).
+} raw_var_t;
+
+//! Streaming writer of the binary SPICE rawfile format (as written by SPICE3/ngspice).
+/*!
+  The file consists of a text header (title, plot name, flags, variables) followed by the points
+  in binary, every point is all the variables in double precision (real and imaginary part for a
+  complex plot).\n
+  The simulation pushes the points in a bounded ring buffer, which is drained to the file by a
+  background thread, therefore the memory is constant regardless of the number of points. When
+  the buffer is full the simulation waits for the writes. The number of points is patched in the
+  header when the writer is finished.
+*/
+class raw_writer
+{
+    public:
+        raw_writer(const std::string &file, const std::string &title, const std::string &plotname,
+                   const std::vector<raw_var_t> &vars, bool complex);
+        ~raw_writer();
+
+        void Push(const double *point);
+        bool Finish(void);
+
+        /*!
+            @brief      Returns whether the file was opened and all the writes succeeded so far.
+            @return     True in case of success, otherwise false.
+        */
+        bool Valid(void) const noexcept { return !_failed; }
+
+        /*!
+            @brief      Returns the number of doubles of a point (variables, twice for complex).
+            @return     The size of a point.
+        */
+        size_t PointSize(void) const noexcept { return _point_sz; }
+
+    private:
+        void Drain(void);
+
+        static constexpr size_t _buffer_points = 4096;      //!< Capacity of the ring buffer (points).
+        static constexpr int _points_width = 20;            //!< Width of the number of points in the header.
+
+        std::ofstream _out;                 //!< The rawfile.
+        std::streampos _points_pos;         //!< Position of the number of points in the header.
+        size_t _point_sz;                   //!< Doubles per point.
+        size_t _points = 0;                 //!< Points pushed.
+        bool _failed = false;               //!< Open or write failure.
+        bool _finished = false;             //!< The writer is finished (file closed).
+
+        /* Ring buffer, the positions are counters of doubles (modulo the capacity) */
+        std::vector<double> _ring;          //!< The ring buffer.
+        size_t _head = 0;                   //!< Doubles pushed by the simulation.
+        size_t _tail = 0;                   //!< Doubles written to the file.
+        bool _done = false;                 //!< No more points, the thread exits when the buffer is empty.
+        std::mutex _mutex;                  //!< Protects the positions and the flags.
+        std::condition_variable _not_full;  //!< Signals the simulation, space in the buffer.
+        std::condition_variable _not_empty; //!< Signals the thread, points in the buffer (or done).
+        std::thread _thread;                //!< The background I/O thread.
+};
+
+#endif // __RAW_WRITER_H //
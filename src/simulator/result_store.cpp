@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include "result_store.hpp"
+
+/*!
+    @brief      Empties the store.
+    @param      cols        The number of columns (plotted unknowns).
+    @param      format      The format of the sealed samples.
+*/
+template<typename T>
+void result_store<T>::Reset(size_t cols, store_format_t format)
+{
+    _cols = cols;
+    _rows = 0;
+    _sealed = 0;
+    _dropped = 0;
+    _format = format;
+    _chunks.clear();
+    _max_error.assign(_cols, 0);
+    _peak.assign(_cols, 0);
+}
+
+/*!
+    @brief      Sets the number of rows. The chunks of the new rows are allocated (open), the last one
+    for the rows requested, at least twice its previous rows (up to a full chunk). Only the samples
+    of a growing last chunk are moved. A sealed chunk that is not full (see Finish) is opened again.
+    Shrinking to dropped rows (see Drop) empties the store first.
+    @param      rows        The number of rows.
+*/
+template<typename T>
+void result_store<T>::Resize(size_t rows)
+{
+    size_t chunks = (rows + _chunk_rows - 1) / _chunk_rows;
+    size_t last = _rows / _chunk_rows;
+
+    if(rows < _dropped * _chunk_rows)
+    {
+        _chunks.clear();
+        _sealed = _dropped = last = 0;
+    }
+
+    /* The last chunk sealed before it was full */
+    if(rows > _rows && _sealed > _dropped && _chunks[_sealed - 1 - _dropped].rows < _chunk_rows)
+    {
+        auto &chunk = _chunks[--_sealed - _dropped];
+        store_chunk_t open;
+
+        open.lead = chunk.rows;
+        open.full.resize(_cols * open.lead);
+
+        for(size_t col = 0; col < _cols; col++)
+        {
+            for(size_t r = 0; r < chunk.rows; r++) open.full[col * open.lead + r] = Get(_sealed * _chunk_rows + r, col);
+        }
+
+        chunk = std::move(open);
+    }
+
+    _chunks.resize(std::min(chunks - _dropped, _chunks.size()));
+    _sealed = std::min(_sealed, chunks);
+
+    while(_chunks.size() + _dropped < chunks) _chunks.emplace_back();
+
+    /* The chunks before the previous last one are full already */
+    for(size_t k = std::max({last, _sealed, _dropped}); k < chunks; k++)
+    {
+        auto &chunk = _chunks[k - _dropped];
+        size_t need = std::min(_chunk_rows, rows - k * _chunk_rows);
+
+        if(chunk.lead < need) GrowChunk(chunk, (k + 1 < chunks) ? _chunk_rows : std::min(_chunk_rows, std::max(need, 2 * chunk.lead)));
+    }
+
+    if(!rows)
+    {
+        _max_error.assign(_cols, 0);
+        _peak.assign(_cols, 0);
+    }
+
+    _rows = rows;
+}
+
+/*!
+    @brief      Copies the plotted unknowns of a solution to a row, which must be allocated and open.
+    @param      vec     The solution vector.
+    @param      idx     The index of every column in the solution.
+    @param      row     The row.
+*/
+template<typename T>
+void result_store<T>::Gather(const VecTp &vec, const std::vector<IntTp> &idx, size_t row) noexcept
+{
+    const T *in = vec.data();
+    const IntTp *pos = idx.data();
+    auto &chunk = _chunks[row / _chunk_rows - _dropped];
+    T *out = chunk.full.data() + row % _chunk_rows;
+    size_t stride = chunk.lead, cols = _cols;
+
+    /* Indexed load, strided store */
+    #pragma omp simd
+    for(size_t k = 0; k < cols; k++) out[k * stride] = in[pos[k]];
+}
+
+/*!
+    @brief      Seals the full chunks of the rows that are final, with a reduced format (see
+    store_format_t). Nothing is done in double precision.
+    @param      rows        The rows that are final (the first ones).
+*/
+template<typename T>
+void result_store<T>::Seal(size_t rows)
+{
+    if(_format == STORE_DOUBLE) return;
+
+    rows = std::min(rows, _rows);
+
+    for(; (_sealed + 1) * _chunk_rows <= rows; _sealed++) SealChunk(_chunks[_sealed - _dropped], _chunk_rows);
+}
+
+/*!
+    @brief      Seals every chunk (the last one may not be full), after the last row is final.
+*/
+template<typename T>
+void result_store<T>::Finish(void)
+{
+    if(_format == STORE_DOUBLE) return;
+
+    Seal(_rows);
+
+    for(; _sealed < _chunks.size() + _dropped; _sealed++) SealChunk(_chunks[_sealed - _dropped], _rows - _sealed * _chunk_rows);
+}
+
+/*!
+    @brief      Releases the full chunks of the rows that are not needed any more (streamed out, for
+    example). The rows are still counted, but their samples must not be read or written again.
+    @param      rows        The rows not needed (the first ones).
+*/
+template<typename T>
+void result_store<T>::Drop(size_t rows)
+{
+    size_t chunks = std::min(rows, _rows) / _chunk_rows;
+    if(chunks <= _dropped) return;
+
+    _chunks.erase(_chunks.begin(), _chunks.begin() + (chunks - _dropped));
+    _dropped = chunks;
+    _sealed = std::max(_sealed, _dropped);
+}
+
+/*!
+    @brief      Returns a sample (decoded when its chunk is sealed), not dropped.
+    @param      row     The row (simulation point).
+    @param      col     The column (plotted unknown).
+    @return     The sample.
+*/
+template<typename T>
+T result_store<T>::Get(size_t row, size_t col) const noexcept
+{
+    auto &chunk = _chunks[row / _chunk_rows - _dropped];
+    size_t r = row % _chunk_rows;
+
+    if(!chunk.sealed) return chunk.full[col * chunk.lead + r];
+
+    T val;
+    double *parts = reinterpret_cast<double *>(&val);
+
+    for(size_t p = 0; p < _parts; p++) parts[p] = Decode(chunk, col, (col * chunk.rows + r) * _parts + p);
+
+    return val;
+}
+
+/*!
+    @brief      Copies the samples of a column (decoded when their chunks are sealed), not dropped.
+    @param      col     The column (plotted unknown).
+    @param      first   The first row.
+    @param      count   The number of rows.
+    @param      out     The samples.
+*/
+template<typename T>
+void result_store<T>::Read(size_t col, size_t first, size_t count, T *out) const noexcept
+{
+    while(count)
+    {
+        auto &chunk = _chunks[first / _chunk_rows - _dropped];
+        size_t r = first % _chunk_rows;
+        size_t n = std::min(count, _chunk_rows - r);
+
+        if(!chunk.sealed)
+        {
+            const T *in = chunk.full.data() + col * chunk.lead + r;
+            std::copy(in, in + n, out);
+        }
+        else
+        {
+            size_t pos = (col * chunk.rows + r) * _parts;
+            double *parts = reinterpret_cast<double *>(out);
+
+            for(size_t i = 0; i < n * _parts; i++) parts[i] = Decode(chunk, col, pos + i);
+        }
+
+        first += n;
+        count -= n;
+        out += n;
+    }
+}
+
+/*!
+    @brief      Returns the memory held by the samples.
+    @return     The memory (bytes).
+*/
+template<typename T>
+size_t result_store<T>::Bytes(void) const noexcept
+{
+    size_t bytes = 0;
+
+    for(auto &it : _chunks)
+    {
+        bytes += it.full.capacity() * sizeof(T) + it.single.capacity() * sizeof(float) + it.fixed.capacity() * sizeof(int16_t);
+        bytes += (it.center.capacity() + it.step.capacity()) * sizeof(double);
+    }
+
+    return bytes;
+}
+
+/*!
+    @brief      Allocates more rows for an open chunk, the samples are moved.
+    @param      chunk       The chunk (open).
+    @param      lead        The rows to allocate.
+*/
+template<typename T>
+void result_store<T>::GrowChunk(store_chunk_t &chunk, size_t lead)
+{
+    std::vector<T> full(_cols * lead, T(0));
+
+    for(size_t col = 0; col < _cols; col++)
+    {
+        auto in = chunk.full.begin() + col * chunk.lead;
+        std::copy(in, in + chunk.lead, full.begin() + col * lead);
+    }
+
+    chunk.full.swap(full);
+    chunk.lead = lead;
+}
+
+/*!
+    @brief      Converts the samples of a chunk to the reduced format and releases the double
+    precision ones. The error of every sample is accumulated to the maximum error of its column.
+    @param      chunk       The chunk.
+    @param      rows        The rows of the chunk (the rest are not used).
+*/
+template<typename T>
+void result_store<T>::SealChunk(store_chunk_t &chunk, size_t rows)
+{
+    const double *in = reinterpret_cast<const double *>(chunk.full.data());
+    size_t count = _cols * rows * _parts;
+    auto at = [&](size_t col, size_t r, size_t p) { return (col * chunk.lead + r) * _parts + p; };
+
+    chunk.rows = rows;
+
+    if(_format == STORE_FLOAT)
+    {
+        chunk.single.resize(count);
+
+        for(size_t col = 0; col < _cols; col++)
+        {
+            for(size_t i = 0; i < rows * _parts; i++) chunk.single[col * rows * _parts + i] = static_cast<float>(in[at(col, 0, i)]);
+        }
+    }
+    else
+    {
+        chunk.fixed.resize(count);
+        chunk.center.assign(_cols * _parts, 0);
+        chunk.step.assign(_cols * _parts, 0);
+
+        for(size_t col = 0; col < _cols; col++)
+        {
+            for(size_t p = 0; p < _parts; p++)
+            {
+                double lo = INFINITY, hi = -INFINITY;
+
+                for(size_t r = 0; r < rows; r++)
+                {
+                    double v = in[at(col, r, p)];
+                    if(std::isfinite(v)) { lo = std::min(lo, v); hi = std::max(hi, v); }
+                }
+
+                /* The range maps to [-INT16_MAX, INT16_MAX], INT16_MIN is left for the non-finite samples */
+                double center = (lo <= hi) ? lo / 2 + hi / 2 : 0;
+                double step = (lo < hi) ? (hi / 2 - lo / 2) / INT16_MAX : 0;
+
+                chunk.center[col * _parts + p] = center;
+                chunk.step[col * _parts + p] = step;
+
+                for(size_t r = 0; r < rows; r++)
+                {
+                    double v = in[at(col, r, p)];
+                    int16_t &q = chunk.fixed[(col * rows + r) * _parts + p];
+
+                    if(!std::isfinite(v)) q = _not_finite;
+                    else if(step == 0) q = 0;
+                    else q = static_cast<int16_t>(std::clamp<long>(std::lround((v - center) / step), -INT16_MAX, INT16_MAX));
+                }
+            }
+        }
+    }
+
+    chunk.sealed = true;
+
+    /* Error of the sealed samples (magnitude of the error of complex samples) */
+    for(size_t col = 0; col < _cols; col++)
+    {
+        for(size_t r = 0; r < rows; r++)
+        {
+            double err = 0, mag = 0;
+
+            for(size_t p = 0; p < _parts; p++)
+            {
+                double v = in[at(col, r, p)];
+                if(!std::isfinite(v)) continue;
+
+                double d = Decode(chunk, col, (col * rows + r) * _parts + p) - v;
+                err += d * d;
+                mag += v * v;
+            }
+
+            _max_error[col] = std::max(_max_error[col], std::sqrt(err));
+            _peak[col] = std::max(_peak[col], std::sqrt(mag));
+        }
+    }
+
+    std::vector<T>().swap(chunk.full);
+}
+
+/*!
+    @brief      Decodes a part of a sealed sample.
+    @param      chunk       The chunk (sealed).
+    @param      col         The column of the sample.
+    @param      pos         The position of the part in the chunk ((col * rows + row) * parts + part).
+    @return     The value.
+*/
+template<typename T>
+double result_store<T>::Decode(const store_chunk_t &chunk, size_t col, size_t pos) const noexcept
+{
+    if(_format == STORE_FLOAT) return chunk.single[pos];
+
+    int16_t q = chunk.fixed[pos];
+    if(q == _not_finite) return std::numeric_limits<double>::quiet_NaN();
+
+    size_t k = col * _parts + pos % _parts;
+    return chunk.center[k] + chunk.step[k] * q;
+}
+
+/* Explicit instantiations - Real and complex results */
+template class result_store<double>;
+template class result_store<std::complex<double>>;
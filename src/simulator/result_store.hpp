@@ -0,0 +1,118 @@
+#ifndef __RESULT_STORE_H
+#define __RESULT_STORE_H
+
+#include <cstdint>
+#include "matrix_types.hpp"
+#include "simulator_types.hpp"
+
+//! Column-major store of the results of a simulation (one column per plotted unknown), in chunks of rows.
+/*!
+  The rows are split in chunks of a fixed number of rows, the samples of a column in a chunk are
+  contiguous (see Read). The last chunk is allocated for the rows requested and grows geometrically
+  up to the full chunk (see Resize), so a short simulation holds only its rows and appending rows
+  one by one moves only the samples of the last chunk, a bounded number of times.\n
+  A row (simulation point) is gathered from the solution vector through the plot indices (see Gather),
+  different rows can be gathered in parallel as long as they are allocated (see Resize).\n
+  The samples are kept in double precision while a chunk is open. With a reduced format (see
+  store_format_t) the chunks whose rows are final are sealed (see Seal): the samples are converted
+  to single precision, or to 16-bit integers scaled to the range of every column of the chunk (the
+  real and imaginary parts of complex samples on their own), and the double precision samples are
+  released. The maximum error of every column is kept, relative to the peak of the column.
+  Non-finite samples are kept as they are in single precision and as NaN in 16-bit integers.\n
+  The chunks of the rows that are not needed any more can be dropped (see Drop), so a store that
+  is streamed out as it is filled holds only the last chunks, whatever the number of rows.
+*/
+template<typename T>
+class result_store
+{
+    public:
+        typedef Eigen::Matrix<T, Eigen::Dynamic, 1> VecTp;     //!< The solution vector type.
+
+        void Reset(size_t cols, store_format_t format = STORE_DOUBLE);
+        void Resize(size_t rows);
+        void Gather(const VecTp &vec, const std::vector<IntTp> &idx, size_t row) noexcept;
+        void Seal(size_t rows);
+        void Finish(void);
+        void Drop(size_t rows);
+
+        T Get(size_t row, size_t col) const noexcept;
+        void Read(size_t col, size_t first, size_t count, T *out) const noexcept;
+        size_t Bytes(void) const noexcept;
+
+        /*!
+            @brief      Returns the number of rows (simulation points).
+            @return     The rows.
+        */
+        size_t Rows(void) const noexcept { return _rows; }
+
+        /*!
+            @brief      Returns the number of columns (plotted unknowns).
+            @return     The columns.
+        */
+        size_t Cols(void) const noexcept { return _cols; }
+
+        /*!
+            @brief      Returns the format of the sealed samples.
+            @return     The format.
+        */
+        store_format_t Format(void) const noexcept { return _format; }
+
+        /*!
+            @brief      Returns the maximum error of the sealed samples of a column.
+            @param      col     The column (plotted unknown).
+            @return     The error (magnitude for complex samples).
+        */
+        double MaxError(size_t col) const noexcept { return _max_error[col]; }
+
+        /*!
+            @brief      Returns the peak of the sealed samples of a column.
+            @param      col     The column (plotted unknown).
+            @return     The peak (magnitude for complex samples).
+        */
+        double Peak(size_t col) const noexcept { return _peak[col]; }
+
+        /*!
+            @brief      Returns a sample, for writing. The chunk of the row must be open (not sealed nor dropped).
+            @param      row     The row (simulation point).
+            @param      col     The column (plotted unknown).
+            @return     The sample.
+        */
+        T &operator()(size_t row, size_t col) noexcept
+        {
+            auto &chunk = _chunks[row / _chunk_rows - _dropped];
+            return chunk.full[col * chunk.lead + row % _chunk_rows];
+        }
+
+    private:
+        /** A chunk of rows, open (double precision) or sealed (reduced format). */
+        typedef struct store_chunk
+        {
+            std::vector<T> full;                //!< The samples while open, column-major with a leading dimension of lead.
+            size_t lead = 0;                    //!< The rows allocated while open (up to _chunk_rows).
+            std::vector<float> single;          //!< The samples sealed in single precision (parts of complex samples interleaved).
+            std::vector<int16_t> fixed;         //!< The samples sealed in 16-bit integers (parts of complex samples interleaved).
+            std::vector<double> center;         //!< The center of the range of every part of every column (16-bit integers).
+            std::vector<double> step;           //!< The quantization step of every part of every column (16-bit integers).
+            size_t rows = 0;                    //!< The rows sealed (the leading dimension of the sealed samples).
+            bool sealed = false;                //!< The chunk is sealed.
+        } store_chunk_t;
+
+        void GrowChunk(store_chunk_t &chunk, size_t lead);
+        void SealChunk(store_chunk_t &chunk, size_t rows);
+        double Decode(const store_chunk_t &chunk, size_t col, size_t pos) const noexcept;
+
+        static constexpr size_t _chunk_rows = 4096;                     //!< Rows of a chunk.
+        static constexpr size_t _parts = sizeof(T) / sizeof(double);    //!< Parts of a sample (2 for complex samples).
+        static constexpr int16_t _not_finite = INT16_MIN;               //!< Code of the non-finite samples (16-bit integers).
+
+        std::vector<store_chunk_t> _chunks;     //!< The chunks of rows, after the dropped ones.
+        std::vector<double> _max_error;         //!< Maximum error of the sealed samples, per column.
+        std::vector<double> _peak;              //!< Peak of the sealed samples, per column.
+        store_format_t _format = STORE_DOUBLE;  //!< Format of the sealed samples.
+        size_t _cols = 0;                       //!< Number of columns.
+        size_t _rows = 0;                       //!< Number of rows.
+        size_t _sealed = 0;                     //!< Number of chunks sealed (the first ones).
+        size_t _dropped = 0;                    //!< Number of chunks dropped (the first ones).
+};
+
+#endif // __RESULT_STORE_H //
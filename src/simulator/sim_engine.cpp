@@ -1,25 +1,8 @@
 #include <chrono>       /* For time */
+#include <algorithm>
+#include <omp.h>
 #include "sim_engine.hpp"
 
-/* For solver engines */
-#ifdef BSPICE_EIGEN_USE_KLU
-    #include "KLUSupport"
-
-    /** KLU direct solvers - Supports both int/long*/
-    typedef Eigen::KLU<SparMatD> direct_solver;
-
-    /** Complex KLU direct solver - Supports both int/long */
-    typedef Eigen::KLU<SparMatCompD> direct_solver_c;
-#else
-    /** Eigen direct solver - Supports both int/long */
-    typedef Eigen::SparseLU<SparMatD, Eigen::COLAMDOrdering<IntTp>> direct_solver;
-
-    /** Complex Eigen direct solver - Supports both int/long */
-    typedef Eigen::SparseLU<SparMatCompD, Eigen::COLAMDOrdering<IntTp>> direct_solver_c;
-#endif
-
-
-
 /*!
     @brief  Returns whether the simulator is in a valid state or not.
     @return True, in case of active results, otherwise false.
@@ -30,31 +13,41 @@ bool simulator::valid(void) noexcept { return _run; }
     @brief  Returns the simulation vector used for the analysis.
     @return The simulation vector.
 */
-const std::vector<double> &simulator::SimulationVec(void) noexcept { return _mna_engine.SimVals();  }
+const std::vector<double> &simulator::SimulationVec(void) noexcept
+{
+    /* The exponential integrator produces its own timepoints */
+    return _adaptive.sim_time.empty() ? _mna_engine.SimVals() : _adaptive.sim_time;
+}
 
 /*!
     @brief  Returns the results for the plot nodes.
     @return The results.
 */
-const std::vector<std::vector<double>> &simulator::NodesResults(void) noexcept { return _res_nodes; }
+const result_store<double> &simulator::NodesResults(void) noexcept { return _res_nodes; }
 
 /*!
     @brief  Returns the results for the plot source.
     @return The results.
 */
-const std::vector<std::vector<double>> &simulator::SourceResults(void) noexcept { return _res_sources; }
+const result_store<double> &simulator::SourceResults(void) noexcept { return _res_sources; }
 
 /*!
     @brief  Returns the results for the plot nodes (AC analysis).
     @return The results.
 */
-const std::vector<std::vector<std::complex<double>>> &simulator::NodesResultsCd(void) noexcept { return _res_nodes_cd; }
+const result_store<std::complex<double>> &simulator::NodesResultsCd(void) noexcept { return _res_nodes_cd; }
 
 /*!
     @brief  Returns the results for the plot source (AC analysis).
     @return The results.
 */
-const std::vector<std::vector<std::complex<double>>> &simulator::SourceResultsCd(void) noexcept { return _res_sources_cd; }
+const result_store<std::complex<double>> &simulator::SourceResultsCd(void) noexcept { return _res_sources_cd; }
+
+/*!
+    @brief  Returns the statistics of the waveform relaxation (TRAN analysis).
+    @return The statistics.
+*/
+const relaxation_state_t &simulator::RelaxationStats(void) noexcept { return _wr; }
 
 
 
@@ -62,12 +55,99 @@ const std::vector<std::vector<std::complex<double>>> &simulator::SourceResultsCd
     @brief      Initializes the simulator engine with the parameters
     defined by the circuit input.
     @param      circuit_manager     The circuit.
+    @param      args                The command line arguments of the simulation (restart, initial state files).
 */
-simulator::simulator(circuit &circuit_manager)
+simulator::simulator(circuit &circuit_manager, const sim_args_t &args)
 {
     this->_mna_engine = MNA(circuit_manager);
+    auto &opts = circuit_manager.Options();
+
     _run = false;
-    _ode_method = circuit_manager.ODEMethod();
+    _ode_method = opts.ode_method;
+    _solver_type = opts.solver;
+    _lu_stats = opts.lu_stats;
+    _solver_used = _solver_type;
+    _res_rows = 0;
+
+    /* The state of every feature is default initialized, the options are copied in */
+    _adaptive.enabled = opts.adaptive;
+    _adaptive.reltol = opts.reltol;
+    _adaptive.abstol = opts.abstol;
+    _adaptive.max_step = opts.max_step;
+    _adaptive.max_order = opts.max_order;
+    _adaptive.cache_mem = opts.cache_mem * 1024 * 1024;
+    _wr.enabled = opts.relaxation;
+    _wr.partitions = opts.partitions;
+    _ckpt.restart = args.restart;
+    _ckpt.interval = opts.ckpt_interval;
+    _ckpt.file = circuit_manager.CheckpointFile();
+    _ic.uic = opts.uic;
+    _ic.load_x0 = args.load_x0;
+    _ic.save_x0 = args.save_x0;
+    _stream.raw_file = args.raw;
+    _stream.wave_file = args.wave;
+    _stream.save_all = circuit_manager.SaveAll();
+    _meas.file = args.meas.empty() ? circuit_manager.InputFile() + ".meas.json" : args.meas;
+
+    if(_stream.save_all && _stream.wave_file.empty()) _stream.wave_file = circuit_manager.InputFile() + ".wave";
+
+    /* Headless, the results are not plotted so they go to a rawfile at least */
+    bool outputs = !(args.raw.empty() && args.wave.empty() && args.csv.empty() && args.tsv.empty());
+    if(args.headless && !outputs) _stream.raw_file = circuit_manager.InputFile() + ".raw";
+    _stream.title = circuit_manager.InputFile();
+
+    /* Nothing reads the results after the run (headless, no export, no checkpoints), they are dropped once streamed */
+    _keep_results = !args.headless || !args.csv.empty() || !args.tsv.empty() || _ckpt.interval > 0 ||
+                    this->_mna_engine.AnalysisType() == OP;
+
+    /* Results, one row per simulation point (allocated in chunks of rows) */
+    size_t nodes_sz = this->_mna_engine.NodesIdx().size();
+    size_t sources_sz = this->_mna_engine.SourceIdx().size();
+    auto format = opts.store_format;
+
+    _res_nodes.Reset(nodes_sz, format);
+    _res_sources.Reset(sources_sz, format);
+    _res_nodes_cd.Reset(nodes_sz, format);
+    _res_sources_cd.Reset(sources_sz, format);
+
+    /* Variables of the output files, the scale (except for OP) and the plotted nodes/sources */
+    auto lower = [](std::string name) { std::transform(name.begin(), name.end(), name.begin(), ::tolower); return name; };
+    auto &sweep = circuit_manager.DCSource();
+
+    switch(this->_mna_engine.AnalysisType())
+    {
+        case TRAN: _stream.raw_vars.push_back({"time", "time"}); break;
+        case AC: _stream.raw_vars.push_back({"frequency", "frequency"}); break;
+        case DC: _stream.raw_vars.push_back({lower(sweep), (sweep[0] == 'I') ? "current" : "voltage"}); break;
+        default: break;
+    }
+
+    for(auto &it : circuit_manager.PlotNodes()) _stream.raw_vars.push_back({"v(" + lower(it) + ")", "voltage"});
+    for(auto &it : circuit_manager.PlotSources()) _stream.raw_vars.push_back({"i(" + lower(it) + ")", "current"});
+
+    /* SAVE ALL, the scale and every unknown of the system (node voltages, then branch currents) */
+    if(_stream.save_all)
+    {
+        auto names = this->_mna_engine.UnknownNames(circuit_manager);
+        size_t nodes = circuit_manager.Nodes().size();
+
+        if(this->_mna_engine.AnalysisType() != OP) _stream.save_vars.push_back(_stream.raw_vars[0]);
+
+        for(size_t k = 0; k < names.size(); k++)
+        {
+            if(k < nodes) _stream.save_vars.push_back({"v(" + lower(names[k]) + ")", "voltage"});
+            else _stream.save_vars.push_back({"i(" + lower(names[k]) + ")", "current"});
+        }
+    }
+
+    /* The measurements of this analysis, on the unknowns of their signals */
+    for(auto &it : circuit_manager.Measures())
+    {
+        if(it.analysis != this->_mna_engine.AnalysisType()) continue;
+
+        auto idx = [&](const meas_signal_t &sig) { return sig.name.empty() ? -1 : this->_mna_engine.UnknownIdx(circuit_manager, sig.name, sig.current); };
+        _meas.engine.Add(it, idx(it.sig), idx(it.trig.sig), idx(it.targ.sig), this->_mna_engine.AnalysisType() == AC);
+    }
 
     //TODO - Clear circuit to save memory
     circuit_manager.clear();
@@ -87,6 +167,26 @@ return_codes_e simulator::run(void)
 
 	std::cout << "\n[INFO]: Starting simulation...\n";
 
+	/* The waveform file holds every solution from the start, the rows before a checkpoint are not saved */
+	if(this->_stream.save_all && this->_ckpt.restart && analys_type == TRAN)
+	{
+	    std::cout << "[INFO]: SAVE ALL can't be resumed from a checkpoint, run the transient without --restart\n";
+	    return FAIL_SIMULATOR_RESTART;
+	}
+
+	if(this->_stream.save_all) std::cout << "[INFO]: Saving all the unknowns to " << this->_stream.wave_file << "\n";
+	if(!this->_stream.raw_file.empty()) std::cout << "[INFO]: Writing the results to " << this->_stream.raw_file << "\n";
+
+	/* The parallel methods do not produce the solutions in order */
+	if((this->_stream.save_all || !this->_meas.engine.Empty()) && analys_type == TRAN && this->_wr.enabled)
+	{
+	    std::cout << "[INFO]: Waveform relaxation disabled, SAVE ALL/MEASURE need every solution in order\n";
+	    this->_wr.enabled = false;
+	}
+
+	ResetRunState();
+	if(!OpenOutputFiles()) return FAIL_SIMULATOR_OUTPUT;
+
 	/* Depending on analysis, call the appropriate sub-simulator */
 	switch(analys_type)
 	{
@@ -97,6 +197,29 @@ return_codes_e simulator::run(void)
 		default: ret = OP_analysis(); break;
 	}
 
+	/* The rows not streamed during the analysis (parallel methods) */
+	if(ret == RETURN_SUCCESS)
+	{
+	    StreamRows(analys_type == AC ? this->_res_nodes_cd.Rows() : this->_res_rows);
+
+	    /* Every row is final, the last chunks of results are sealed as well */
+	    this->_res_nodes.Finish();
+	    this->_res_sources.Finish();
+	    this->_res_nodes_cd.Finish();
+	    this->_res_sources_cd.Finish();
+
+	    if(this->_stream.raw && !this->_stream.raw->Finish()) ret = FAIL_SIMULATOR_OUTPUT;
+	    if(this->_stream.wave && !this->_stream.wave->Finish()) ret = FAIL_SIMULATOR_OUTPUT;
+	}
+
+	if(ret == RETURN_SUCCESS && !this->_meas.engine.Empty())
+	{
+	    const char *names[] = {"OP", "DC", "TRAN", "AC"};
+
+	    this->_meas.engine.Finish();
+	    if(!this->_meas.engine.WriteJSON(this->_meas.file, this->_stream.title, names[analys_type])) ret = FAIL_SIMULATOR_OUTPUT;
+	}
+
 	/* Statistics */
 	auto end = std::chrono::high_resolution_clock::now();
 
@@ -107,8 +230,59 @@ return_codes_e simulator::run(void)
 	    std::cout << "************************************\n";
 	    std::cout << "Total simulation time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end-begin).count() << "ms\n";
 	    std::cout << "System size: " << this->_mna_engine.SystemDim() << "\n";
+	    printSolverStats(this->_solver_stats, this->_solver_used);
+
+	    if(analys_type == TRAN && this->_adaptive.cache)
+	    {
+	        auto &cache = this->_adaptive.cache->Stats();
+
+	        std::cout << "Timesteps: " << this->_adaptive.accepted << " accepted, " << this->_adaptive.rejected << " rejected, " << this->_adaptive.breakpoints << " breakpoints\n";
+	        std::cout << "Factorization cache: " << cache.hits << " hits, " << cache.misses << " misses, " << cache.evictions << " evictions";
+	        std::cout << " (peak: " << cache.entries << " entries, " << cache.memory / 1024 << "KB)\n";
+
+	        if(this->_ode_method == EXPINT && this->_adaptive.accepted)
+	            std::cout << "Krylov subspace: " << (double)this->_adaptive.krylov_dims / this->_adaptive.accepted << " average dimension\n";
+	    }
+
+	    if(analys_type == TRAN && this->_ckpt.writer && (this->_ckpt.writer->Written() || this->_ckpt.resumed))
+	    {
+	        std::cout << "Checkpoints: " << this->_ckpt.writer->Written() << " written";
+	        if(this->_ckpt.resumed) std::cout << " (resumed at t = " << this->_ckpt.state.hist_t.back() << ")";
+	        std::cout << "\n";
+	    }
+
+	    if(analys_type == TRAN && this->_wr.iters)
+	    {
+	        std::cout << "Waveform relaxation: " << this->_wr.partitions << " partitions (largest: " << this->_wr.largest;
+	        std::cout << ", boundary: " << this->_wr.boundary << "), " << this->_wr.iters << " iterations";
+	        if(this->_wr.fallback) std::cout << ", not converged (solved sequentially)";
+	        std::cout << "\n";
+	    }
+
+	    if(this->_stream.wave)
+	    {
+	        auto &wave = this->_stream.wave->Stats();
+	        double rate = wave.write_time > 0 ? wave.bytes_in / wave.write_time / 1e9 : 0;
+
+	        std::cout << "Waveform file: " << wave.bytes_out / 1048576.0 << "MB (" << wave.bytes_in / 1048576.0 << "MB uncompressed), ";
+	        std::cout << rate << " GB/s, simulation stalled " << wave.stall_time * 1000 << "ms\n";
+	    }
+
+	    if(analys_type == AC) printStoreStats(this->_res_nodes_cd, this->_res_sources_cd);
+	    else printStoreStats(this->_res_nodes, this->_res_sources);
+
 	    std::cout << "************************************\n\n";
 
+	    if(!this->_meas.engine.Empty())
+	    {
+	        std::cout << "************************************\n";
+	        std::cout << "************MEASUREMENTS************\n";
+	        std::cout << "************************************\n";
+	        this->_meas.engine.Print();
+	        std::cout << "Results written to " << this->_meas.file << "\n";
+	        std::cout << "************************************\n\n";
+	    }
+
 	    this->_run = true;
 	}
 
@@ -121,30 +295,7 @@ return_codes_e simulator::run(void)
 */
 return_codes_e simulator::OP_analysis(void)
 {
-	/* Solver and matrices */
-	direct_solver solver;
-	SparMatD mat;
-	DensVecD rh;
-
-	/* 1) MNA formation */
-	this->_mna_engine.CreateMNASystemOP(mat, rh);
-
-	/* 2) Factorization/Symbolic analysis*/
-	solver.compute(mat);
-
-	/* Checks */
-	if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_FACTORIZATION;
-
-	/* 3) Solve */
-	DensVecD res = solver.solve(rh);
-
-	/* Checks */
-	if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_SOLVE;
-
-	/* Set results */
-	setPlotResults(res);
-
-	return RETURN_SUCCESS;
+    return SolveWithFallback(&simulator::OPSolve);
 }
 
 /*!
@@ -153,36 +304,7 @@ return_codes_e simulator::OP_analysis(void)
 */
 return_codes_e simulator::DC_analysis(void)
 {
-	direct_solver solver;
-	SparMatD mat;
-    DensVecD rh, sol;
-
-    /* The matrix has to be created once */
-    this->_mna_engine.CreateMNASystemOP(mat, rh);
-
-    /* 2) Factorization/Symbolic analysis*/
-    solver.compute(mat);
-
-    /* Checks */
-    if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_FACTORIZATION;
-
-    auto &sim_vec = this->_mna_engine.SimVals();
-
-    /* Solve */
-    for(auto it : sim_vec)
-    {
-        /* Update the vector */
-        this->_mna_engine.UpdateMNASystemDCVec(rh, it);
-
-        /* Solve */
-        sol = solver.solve(rh);
-        setPlotResults(sol);
-
-        /* Checks */
-        if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_SOLVE;
-    }
-
-	return RETURN_SUCCESS;
+    return SolveWithFallback(&simulator::DCSolve);
 }
 
 /*!
@@ -191,13 +313,12 @@ return_codes_e simulator::DC_analysis(void)
 */
 return_codes_e simulator::TRAN_analysis(void)
 {
-    switch(this->_ode_method)
-    {
-        case BACKWARDS_EULER: return EulerODESolve();
-        case TRAPEZOIDAL: return TrapODESolve();
-        case GEAR2: return FAIL_SIMULATOR_FALLTHROUTH_ODE_OPTION; //TODO
-        default: return FAIL_SIMULATOR_FALLTHROUTH_ODE_OPTION; /* Will never reach */
-    }
+    return_codes_e ret = SolveWithFallback(&simulator::TRANSolve);
+
+    /* Complete run, the checkpoints are not needed anymore */
+    if(ret == RETURN_SUCCESS && this->_ckpt.writer) this->_ckpt.writer->Finish();
+
+    return ret;
 }
 
 /*!
@@ -206,9 +327,18 @@ return_codes_e simulator::TRAN_analysis(void)
 */
 return_codes_e simulator::AC_analysis(void)
 {
-    direct_solver_c solver;
+    return SolveWithFallback(&simulator::ACSolve);
+}
+
+/*!
+	@brief      The body of the alternating current (AC) simulation, one solve per frequency.
+	@param      solver      The solver to be used.
+	@return		Error code in case of error, otherwise RETURN_SUCCESS.
+*/
+return_codes_e simulator::ACSolve(linear_solver<SparMatCompD> &solver)
+{
     SparMatCompD mat;
-    DensVecCompD rh;
+    DensVecCompD rh, sol;
 
     /* Set up the right hand side */
     this->_mna_engine.CreateMNASystemAC(rh);
@@ -221,72 +351,327 @@ return_codes_e simulator::AC_analysis(void)
         /* Create the array for this frequency */
         this->_mna_engine.CreateMNASystemAC(mat, sim_vector[i]);
 
-        /* Solver */
-        solver.compute(mat);
+        /* Solver - Symbolic analysis only once, the pattern does not change with frequency */
+        bool ok = (i == 0) ? solver.factor(mat) : solver.refactor(mat);
 
         /* Checks */
-        if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_FACTORIZATION;
+        if(!ok) return FAIL_SIMULATOR_FACTORIZATION;
 
         /* Return the result */
-        DensVecCompD tmp = solver.solve(rh);
-        setPlotResultsCd(tmp);
+        if(!solver.solve(rh, sol)) return FAIL_SIMULATOR_SOLVE;
+        setPlotResultsCd(sol);
+    }
+
+	return RETURN_SUCCESS;
+}
+
+
+
+/*!
+    @brief      Runs an analysis body with the solver picked for the system (real or complex). In case the
+    solver is not applicable after all, for example Cholesky on a system that is not definite (floating nodes)
+    or an iterative solver that does not converge, the analysis is repeated with the default LU solver.
+    @param      analysis    The analysis body.
+    @return     Error code in case of error, otherwise RETURN_SUCCESS.
+*/
+template<typename MatTp>
+return_codes_e simulator::SolveWithFallback(return_codes_e (simulator::*analysis)(linear_solver<MatTp> &))
+{
+    bool spd = std::is_same<MatTp, SparMatD>::value && this->_mna_engine.SPDSystem();
+    auto solver = CreateLinearSolver<MatTp>(this->_solver_type, spd);
+    solver->MeasureLU(this->_lu_stats);
+
+    return_codes_e ret = (this->*analysis)(*solver);
+    setSolverStats(*solver);
+
+    /* Direct LU solvers have no fallback */
+    auto type = solver->Type();
+    bool lu = (type == SOLVER_KLU || type == SOLVER_SPARSELU);
+
+    if(lu || (ret != FAIL_SIMULATOR_FACTORIZATION && ret != FAIL_SIMULATOR_SOLVE)) return ret;
+
+    std::cout << "[INFO]: " << SolverName(type) << " solver failed, falling back to LU\n";
+
+    /* Drop any partial results and retry */
+    ResetRunState();
+    if(!OpenOutputFiles()) return FAIL_SIMULATOR_OUTPUT;
+
+    solver = CreateLinearSolver<MatTp>(SOLVER_AUTO, false);
+    ret = (this->*analysis)(*solver);
+    setSolverStats(*solver);
+
+    return ret;
+}
+
+/*!
+    @brief      Clears the state of a run (results, statistics, streamed rows), before the analysis
+    and before it is repeated with another solver.
+*/
+void simulator::ResetRunState(void)
+{
+    this->_res_nodes.Resize(0);
+    this->_res_sources.Resize(0);
+    this->_res_nodes_cd.Resize(0);
+    this->_res_sources_cd.Resize(0);
+    this->_res_rows = 0;
+    this->_adaptive.sim_time.clear();
+    this->_solver_stats = solver_stats_t();
+    this->_worker_stats = solver_stats_t();
+    this->_adaptive.accepted = 0;
+    this->_adaptive.rejected = 0;
+    this->_adaptive.breakpoints = 0;
+    this->_adaptive.krylov_dims = 0;
+    this->_adaptive.cache.reset();
+    this->_wr.iters = 0;
+    this->_wr.largest = 0;
+    this->_wr.boundary = 0;
+    this->_wr.fallback = false;
+    this->_ckpt.resumed = false;
+    this->_ckpt.rows = 0;
+    this->_stream.raw_rows = 0;
+    this->_stream.solution_rows = 0;
+    this->_meas.engine.Reset();
+}
+
+/*!
+    @brief      Keeps the statistics of the solver used for the analysis.
+    @param      solver      The solver.
+*/
+template<typename MatTp>
+void simulator::setSolverStats(linear_solver<MatTp> &solver)
+{
+    this->_solver_used = solver.Type();
+    this->_solver_stats = solver.Stats();
+
+    /* Adaptive transient, most of the work is done by the cached factorizations */
+    if(this->_adaptive.cache) accumulateSolverStats(this->_solver_stats, this->_adaptive.cache->SolverStats());
+
+    /* Solvers of the parallel workers */
+    accumulateSolverStats(this->_solver_stats, this->_worker_stats);
+}
+
+/*!
+    @brief      Performs the operating point (OP) simulation body.
+    @param      solver      The solver to be used.
+    @return     Error code in case of error, otherwise RETURN_SUCCESS.
+*/
+return_codes_e simulator::OPSolve(linear_solver<SparMatD> &solver)
+{
+    /* Matrices */
+    SparMatD mat;
+    DensVecD rh, res;
+
+    /* 1) MNA formation */
+    this->_mna_engine.CreateMNASystemOP(mat, rh);
+
+    /* 2) Factorization/Symbolic analysis*/
+    if(!solver.factor(mat)) return FAIL_SIMULATOR_FACTORIZATION;
+
+    /* 3) Solve */
+    if(!solver.solve(rh, res)) return FAIL_SIMULATOR_SOLVE;
+
+    /* Initial state of a following transient */
+    if(!this->_ic.save_x0.empty() && !writeStateFile(this->_ic.save_x0, res)) return FAIL_SIMULATOR_INITIAL_STATE;
+
+    /* Set results */
+    setPlotResults(res);
+
+    return RETURN_SUCCESS;
+}
+
+/*!
+    @brief      Performs the direct current (DC) simulation body. The sweep points
+    are solved in blocks of right hand sides.
+    @param      solver      The solver to be used.
+    @return     Error code in case of error, otherwise RETURN_SUCCESS.
+*/
+return_codes_e simulator::DCSolve(linear_solver<SparMatD> &solver)
+{
+    const IntTp block_sz = 32;
+    SparMatD mat;
+    DensVecD rh, sol;
+    DenseMatD rhs, sols;
+
+    /* The matrix has to be created once */
+    this->_mna_engine.CreateMNASystemOP(mat, rh);
+
+    /* 2) Factorization/Symbolic analysis*/
+    if(!solver.factor(mat)) return FAIL_SIMULATOR_FACTORIZATION;
+
+    auto &sim_vec = this->_mna_engine.SimVals();
+    IntTp sim_sz = sim_vec.size();
+
+    /* Solve */
+    for(IntTp start = 0; start < sim_sz; start += block_sz)
+    {
+        IntTp cols = std::min(block_sz, sim_sz - start);
+        rhs.resize(rh.size(), cols);
+
+        /* Update the vectors */
+        for(IntTp k = 0; k < cols; k++)
+        {
+            this->_mna_engine.UpdateMNASystemDCVec(rh, sim_vec[start + k]);
+            rhs.col(k) = rh;
+        }
+
+        /* Solve */
+        if(!solver.solveMulti(rhs, sols)) return FAIL_SIMULATOR_SOLVE;
 
-        if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_SOLVE;
+        for(IntTp k = 0; k < cols; k++)
+        {
+            sol = sols.col(k);
+            setPlotResults(sol);
+        }
     }
 
+    return RETURN_SUCCESS;
+}
 
-	return RETURN_SUCCESS;
+/*!
+    @brief      Performs the transient (TRAN) simulation body, for the ODE method set.
+    @param      solver      The solver to be used.
+    @return     Error code in case of error, otherwise RETURN_SUCCESS.
+*/
+return_codes_e simulator::TRANSolve(linear_solver<SparMatD> &solver)
+{
+    /* The exponential integrator steps from breakpoint to breakpoint */
+    if(this->_ode_method == EXPINT) return ExpIntODESolve(solver);
+
+    /* BDF is always adaptive, Gear2 with adaptive timestep is the BDF up to order 2 */
+    if(this->_ode_method == BDF || (this->_adaptive.enabled && this->_ode_method == GEAR2)) return BDFODESolve(solver);
+
+    /* Adaptive timestep for the one-step methods */
+    if(this->_adaptive.enabled) return AdaptiveODESolve(solver);
+
+    /* Parallel over circuit partitions, for the fixed timestep one-step methods */
+    if(this->_wr.enabled && (this->_ode_method == BACKWARDS_EULER || this->_ode_method == TRAPEZOIDAL)) return RelaxationODESolve(solver);
+
+    switch(this->_ode_method)
+    {
+        case BACKWARDS_EULER: return EulerODESolve(solver);
+        case TRAPEZOIDAL: return TrapODESolve(solver);
+        case GEAR2: return Gear2ODESolve(solver);
+        default: return FAIL_SIMULATOR_FALLTHROUTH_ODE_OPTION; /* Will never reach */
+    }
 }
 
 
 
 /*!
     @brief      Performs the common pre-ODE (for all methods) steps for TRAN analysis.
+    The symbolic analysis is performed on the union pattern of the OP and transient matrices,
+    therefore every following factorization of (G + a*C) only needs a numeric step.
+    @param      solver      The solver, which is left with the symbolic analysis performed.
     @param      tran_mat    The transient MNA contribution matrix to be calculated.
-    @param      op_mat      The OP MNA contribution matrix to be calculated.
+    @param      op_mat      The OP MNA contribution matrix to be calculated (union pattern).
     @param      op_res      The OP result vector (x(t)=0 for TRAN).
+    @param      resumable   The method supports checkpoints. The checkpoints are started, and in case of
+    a restart the OP is not computed, the solution of the last checkpoint is returned instead (only the
+    symbolic analysis is performed).\n
+    The initial state is otherwise:
+    - UIC or a loaded state file: x(0) is the loaded state (or zero) with the IC node voltages, the OP
+    is not computed (only the symbolic analysis is performed).
+    - IC card: The OP with the IC nodes held at their voltages by a large conductance.
+    - Otherwise the OP, the solver is left with G factorized.
     @return     Error code in case of error, otherwise RETURN_SUCCESS.
 */
-return_codes_e simulator::TRANpresolve(SparMatD &tran_mat, SparMatD &op_mat, DensVecD &op_res)
+return_codes_e simulator::TRANpresolve(linear_solver<SparMatD> &solver, SparMatD &tran_mat, SparMatD &op_mat, DensVecD &op_res,
+                                       bool resumable)
 {
-    /* Solver */
-    direct_solver solver;
+    DensVecD rh;
 
     /* Copy the initial vector to the matrix */
-    this->_mna_engine.CreateMNASystemOP(op_mat, op_res);
+    this->_mna_engine.CreateMNASystemOP(op_mat, rh);
+
+    /* Create the transient matrix */
+    this->_mna_engine.CreateMNASystemTRAN(tran_mat);
+
+    /* Explicit zeros, in order for G to have the same pattern as G + a*C (and the IC conductances) */
+    auto &ic_idx = this->_mna_engine.ICIdx();
+    auto &ic_vals = this->_mna_engine.ICValues();
+    tripletList_d ic_trip;
+    SparMatD ic_mat(op_mat.rows(), op_mat.cols());
+
+    for(auto idx : ic_idx) ic_trip.push_back(triplet_eig_d(idx, idx, 1));
+    ic_mat.setFromTriplets(ic_trip.begin(), ic_trip.end());
+
+    op_mat = op_mat + 0 * tran_mat + 0 * ic_mat;
+    this->_ic.seeded = false;
+
+    /* Checkpoints, a row of results is the time, the nodes and the sources */
+    if(resumable && (this->_ckpt.interval > 0 || this->_ckpt.restart))
+    {
+        size_t row_sz = 1 + this->_mna_engine.NodesIdx().size() + this->_mna_engine.SourceIdx().size();
+        this->_ckpt.writer = std::make_unique<checkpoint>(this->_ckpt.file, this->_ckpt.interval, row_sz);
+
+        /* Resume, only the symbolic analysis is needed */
+        if(this->_ckpt.restart)
+        {
+            if(!solver.analyze(op_mat)) return FAIL_SIMULATOR_FACTORIZATION;
+            return RestoreCheckpoint(op_res);
+        }
+
+        this->_ckpt.writer->Reset();
+    }
+    else if(this->_ckpt.restart)
+    {
+        std::cout << "[INFO]: The transient method does not support checkpoints, starting from the OP\n";
+    }
 
     /****** 1st step find the op vector (t = 0) ******/
 
-    /* Factorization/Symbolic analysis */
-    solver.compute(op_mat);
+    if(this->_ic.uic || !this->_ic.load_x0.empty())
+    {
+        /* Known initial state, only the symbolic analysis is needed */
+        if(!solver.analyze(op_mat)) return FAIL_SIMULATOR_FACTORIZATION;
 
-    /* Checks */
-    if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_FACTORIZATION;
+        op_res.setZero(rh.size());
+        if(!this->_ic.load_x0.empty() && !readStateFile(this->_ic.load_x0, rh.size(), op_res)) return FAIL_SIMULATOR_INITIAL_STATE;
 
-    /* t = 0 */
-    op_res = solver.solve(op_res);
+        for(size_t k = 0; k < ic_idx.size(); k++) op_res[ic_idx[k]] = ic_vals[k];
 
-    /* Checks */
-    if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_SOLVE;
+        std::cout << "[INFO]: Initial state from " << (this->_ic.load_x0.empty() ? "the IC card (UIC)" : this->_ic.load_x0) << ", OP skipped\n";
+        this->_ic.seeded = true;
 
-    /* Create the transient matrix */
-    this->_mna_engine.CreateMNASystemTRAN(tran_mat);
+        return RETURN_SUCCESS;
+    }
+
+    if(!ic_idx.empty())
+    {
+        /* IC nodes held by a conductance well above the ones of the circuit (same pattern as G) */
+        double cond = this->_ic.conductance * std::max(1.0, op_mat.diagonal().cwiseAbs().maxCoeff());
+        for(size_t k = 0; k < ic_idx.size(); k++) rh[ic_idx[k]] += cond * ic_vals[k];
+
+        if(!solver.factor(SparMatD(op_mat + cond * ic_mat))) return FAIL_SIMULATOR_FACTORIZATION;
+        this->_ic.seeded = true;
+    }
+    else
+    {
+        /* Factorization/Symbolic analysis */
+        if(!solver.factor(op_mat)) return FAIL_SIMULATOR_FACTORIZATION;
+    }
+
+    /* t = 0 */
+    if(!solver.solve(rh, op_res)) return FAIL_SIMULATOR_SOLVE;
+
+    /* Initial state of a following transient */
+    if(!this->_ic.save_x0.empty() && !writeStateFile(this->_ic.save_x0, op_res)) return FAIL_SIMULATOR_INITIAL_STATE;
 
     return RETURN_SUCCESS;
 }
 
 /*!
     @brief      Performs a transient (TRAN) simulation using the Euler method.
+    @param      solver      The solver to be used.
     @return     Error code in case of error, otherwise RETURN_SUCCESS.
 */
-return_codes_e simulator::EulerODESolve(void)
+return_codes_e simulator::EulerODESolve(linear_solver<SparMatD> &solver)
 {
-    direct_solver solver;
     SparMatD tran_mat, op_mat;
     DensVecD cur;
 
     /* Perform the common transient pre-step */
-    return_codes_e err_tmp = TRANpresolve(tran_mat, op_mat, cur);
+    return_codes_e err_tmp = TRANpresolve(solver, tran_mat, op_mat, cur, true);
     if(err_tmp != RETURN_SUCCESS) return err_tmp;
 
     /****** 2nd step compute the final transient array ******/
@@ -296,48 +681,39 @@ return_codes_e simulator::EulerODESolve(void)
     tran_mat = inverse_timestep * tran_mat;
     op_mat = op_mat + tran_mat; // A = G + 1/h * C
 
-    /* Factorization/Symbolic analysis*/
-    solver.compute(op_mat);
-
-    /* Checks */
-    if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_FACTORIZATION;
+    /* Factorization (symbolic analysis reused) */
+    if(!solver.refactor(op_mat)) return FAIL_SIMULATOR_FACTORIZATION;
 
     /****** 3rd step Run for each simulation timepoint ******/
 
-    /* Set initial t=0 */
+    /* Work vectors and results allocated once, the sweep does not allocate */
     DensVecD old = cur;
-    setPlotResults(old);
-
-    /* Solve A*x = C*e(t) + x(t0)*/
-    for(size_t i = 1; i < sim_vector.size(); i++) /* Skip t=0 timepoint (already computed from OP) */
-    {
-        /* Create the right hand side */
-        cur = tran_mat * old;   // C/h*x(tk-1) + e(tk)
-        this->_mna_engine.UpdateTRANVec(cur, sim_vector[i]);
+    DensVecD rh(old.size());
+    ReserveResults(sim_vector.size());
 
-        /* Save results */
-        old = solver.solve(cur);
-        setPlotResults(old);
+    /* Set initial t=0, or the timepoint of the checkpoint */
+    size_t first = this->_ckpt.resumed ? this->_ckpt.state.rows - 1 : 0;
+    setPlotRow(old, first);
 
-        /* Checks */
-        if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_SOLVE;
-    }
+    /* Solve A*x = C/h*x(tk-1) + e(tk) */
+    err_tmp = FixedStepSweep(solver, tran_mat, false, first, sim_vector.size() - 1, old, rh);
+    this->_res_rows = sim_vector.size();
 
-    return RETURN_SUCCESS;
+    return err_tmp;
 }
 
 /*!
     @brief      Performs a transient (TRAN) simulation using the Trapezoidal method.
+    @param      solver      The solver to be used.
     @return     Error code in case of error, otherwise RETURN_SUCCESS.
 */
-return_codes_e simulator::TrapODESolve(void)
+return_codes_e simulator::TrapODESolve(linear_solver<SparMatD> &solver)
 {
-    direct_solver solver;
     SparMatD tran_mat, op_mat;
     DensVecD cur;
 
     /* Perform the common transient pre-step */
-    return_codes_e err_tmp = TRANpresolve(tran_mat, op_mat, cur);
+    return_codes_e err_tmp = TRANpresolve(solver, tran_mat, op_mat, cur, true);
     if(err_tmp != RETURN_SUCCESS) return err_tmp;
 
     /****** 2nd step compute the final transient array ******/
@@ -345,6 +721,28 @@ return_codes_e simulator::TrapODESolve(void)
     auto &sim_vector = this->_mna_engine.SimVals();
     double inverse_timestep = 1/this->_mna_engine.SimStep();
 
+    /* Work vectors and results allocated once, the sweep does not allocate */
+    DensVecD old = cur;
+    DensVecD rh(old.size());
+    ReserveResults(sim_vector.size());
+
+    /* Set initial t=0, or the timepoint of the checkpoint */
+    size_t first = this->_ckpt.resumed ? this->_ckpt.state.rows - 1 : 0;
+    setPlotRow(old, first);
+
+    /* Given initial state (UIC/loaded), the algebraic unknowns may be inconsistent and the
+       trapezoidal method would keep them oscillating, the first step is Euler */
+    if(!this->_ckpt.resumed && (this->_ic.uic || !this->_ic.load_x0.empty()) && sim_vector.size() > 1)
+    {
+        SparMatD euler_mat = inverse_timestep * tran_mat;
+        if(!solver.refactor(SparMatD(op_mat + euler_mat))) return FAIL_SIMULATOR_FACTORIZATION;
+
+        /* Solve (G + C/h)*x = C/h*x(0) + e(t1) */
+        err_tmp = FixedStepSweep(solver, euler_mat, false, first, first + 1, old, rh);
+        if(err_tmp != RETURN_SUCCESS) return err_tmp;
+        first++;
+    }
+
     /****** 2nd step compute the final transient array ******/
     SparMatD tmp = op_mat;
     tran_mat = 2*inverse_timestep * tran_mat;
@@ -355,128 +753,1102 @@ return_codes_e simulator::TrapODESolve(void)
     /* Right hand matrix => Gnew1 = 2*C/h - G */
     tran_mat = tran_mat - tmp;
 
-    /* Factorization/Symbolic analysis*/
-    solver.compute(op_mat);
-
-    /* Checks */
-    if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_FACTORIZATION;
+    /* Factorization (symbolic analysis reused) */
+    if(!solver.refactor(op_mat)) return FAIL_SIMULATOR_FACTORIZATION;
 
     /****** 3rd step Run for each simulation timepoint ******/
 
-    /* Set initial t=0 */
-    DensVecD old = cur;
-    setPlotResults(old);
-
-    /* Solve A*x = C*e(t) + x(t0)*/
-    for(size_t i = 1; i < sim_vector.size(); i++) /* Skip t=0 timepoint (already computed from OP) */
-    {
-        cur = tran_mat * old;
-        this->_mna_engine.UpdateTRANVec(cur, sim_vector[i]);
-        this->_mna_engine.UpdateTRANVec(cur, sim_vector[i - 1]);
-
-        /* Checks */
-        if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_SOLVE;
-
-        old = solver.solve(cur);
-        setPlotResults(old);
-    }
+    /* Solve A*x = Gnew1*x(tk-1) + e(tk) + e(tk-1) */
+    err_tmp = FixedStepSweep(solver, tran_mat, true, first, sim_vector.size() - 1, old, rh);
+    this->_res_rows = sim_vector.size();
 
-    return RETURN_SUCCESS;
+    return err_tmp;
 }
 
-//TODO - Page 147 of SPECTRE design and stuff paper, does not work seems unstable
-return_codes_e simulator::Gear2ODESolve(void)
+/*!
+    @brief      Performs a transient (TRAN) simulation with adaptive timestep, using the Euler
+    or the Trapezoidal method. The local truncation error (LTE) of every step is estimated from
+    the divided differences (DD) of the solution, of order k+1 for a method of order k:\n
+    Euler: LTE = h^2 * x''/2 = h^2 * DD2, Trapezoidal: LTE = h^3 * x'''/12 = h^3 * DD3 / 2\n
+    A step is accepted when max|LTE| <= RELTOL * max(|x(t+h)|, |x(t)|) + ABSTOL, otherwise it is
+    repeated with a smaller timestep. The steps land exactly on the source breakpoints, where
+    the history restarts with a small step since the derivatives are discontinuous.\n
+    The timesteps are restricted to power-of-two fractions of the maximum timestep, so that the
+    factorizations of G + a*C are reused from the factorization cache when the timestep returns
+    to a previous value. The maximum timestep is the TMAX option, by default 1/50 of the span. The
+    TRAN step is the output grid only, the results are interpolated on it from the accepted
+    timepoints (see setGridResults), so the steps are not limited by the density of the output.
+    @param      solver      The solver to be used.
+    @return     Error code in case of error, otherwise RETURN_SUCCESS.
+*/
+return_codes_e simulator::AdaptiveODESolve(linear_solver<SparMatD> &solver)
 {
-    direct_solver solver;
-    SparMatD tran_mat, op_mat, tmp_op_mat;
-    DensVecD cur, nxt, old;
+    SparMatD tran_mat, op_mat, sys_mat;
+    DensVecD cur, rh, lte;
 
     /* Perform the common transient pre-step */
-    return_codes_e err_tmp = TRANpresolve(tran_mat, op_mat, cur);
+    return_codes_e err_tmp = TRANpresolve(solver, tran_mat, op_mat, cur, true);
     if(err_tmp != RETURN_SUCCESS) return err_tmp;
 
-    /****** 2nd step compute the final transient array ******/
+    bool trap = (this->_ode_method == TRAPEZOIDAL);
+    size_t order = trap ? 2 : 1;
 
-    /* Simulation needed parameters */
+    /* Timestep limits, TMAX or 1/50 of the span, the first steps are taken without an estimate so start small */
     auto &sim_vector = this->_mna_engine.SimVals();
-    double inverse_timestep = 1/this->_mna_engine.SimStep();
+    double tstart = sim_vector.front(), tstop = sim_vector.back();
+    double hmax = (this->_adaptive.max_step > 0) ? std::min(this->_adaptive.max_step, tstop - tstart) : (tstop - tstart) / 50;
+    double hmin = (tstop - tstart) * 1e-12;
+    double a_fact = 0;
 
-    /* Perform 1 step of Euler to get the next needed timepoint and then start GEAR2 */
-    tran_mat = inverse_timestep * tran_mat;
-    tmp_op_mat = op_mat + tran_mat;
-
-    /* Factorization/Symbolic analysis*/
-    solver.compute(tmp_op_mat);
-
-    /* Checks */
-    if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_FACTORIZATION;
-
-    old = cur;
-    setPlotResults(old);
-
-    /* Create the right hand side */
-    cur = tran_mat * old;   // C/h*x(tk-1) + e(tk)
-    this->_mna_engine.UpdateTRANVec(cur, sim_vector[1]);
+    /* Round down to the closest timestep hmax / 2^k */
+    auto quantize = [hmax](double step) { return hmax * std::exp2(-std::ceil(std::log2(hmax / step) - 1e-9)); };
+    double h = quantize(std::min(this->_mna_engine.SimStep(), hmax) / 10);
 
-    /* Save results */
-    cur = solver.solve(cur);
-    setPlotResults(cur);
-
-    /* Checks */
-    if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_SOLVE;
-
-    /* Common steps - Set up matrices for every side */
-    op_mat = op_mat + 3/2*tran_mat;
-    tmp_op_mat = -1 * tran_mat;
-    tran_mat = 2 * tran_mat;
+    linear_solver<SparMatD> *step_solver = nullptr;
+    this->_adaptive.cache = std::make_unique<factor_cache<SparMatD>>(solver.Type(), this->_mna_engine.SPDSystem(), this->_adaptive.cache_mem);
 
-    /* Factorization/Symbolic analysis*/
-    solver.compute(op_mat);
+    /* Source corners */
+    breakpoint_queue breakpoints;
+    this->_mna_engine.CreateTRANBreakpoints(breakpoints);
 
-    /* Checks */
-    if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_FACTORIZATION;
+    /* History of the accepted timepoints, the last (order + 1) are needed for the estimate */
+    std::vector<double> hist_t = {tstart};
+    std::vector<DensVecD> hist_x = {cur};
+    double t = tstart;
 
-    /****** 3rd step Run for each simulation timepoint ******/
+    /* Given initial state (UIC/loaded), the algebraic unknowns may be inconsistent, the first step is Euler */
+    bool euler_start = trap && (this->_ic.uic || !this->_ic.load_x0.empty());
 
-    for(size_t i = 2; i < sim_vector.size(); i++) /* Skip t=0 timepoint (already computed from OP) */
+    if(this->_ckpt.resumed)
     {
-        nxt = tmp_op_mat * old + tran_mat * cur;
-        this->_mna_engine.UpdateTRANVec(nxt, sim_vector[i]);
-
-        /* Checks */
-        if(solver.info() != Eigen::Success) return FAIL_SIMULATOR_SOLVE;
-
-        nxt = solver.solve(nxt);
-        setPlotResults(nxt);
+        /* Continue from the checkpoint */
+        hist_t = this->_ckpt.state.hist_t;
+        hist_x = this->_ckpt.state.hist_x;
+        h = this->_ckpt.state.h;
+        t = hist_t.back();
+        euler_start = false;
+    }
+    else
+    {
+        ReserveResults(sim_vector.size());
+        setPlotResults(cur);
+    }
 
-        /* Copy vectors for next iteration */
-        old = cur;
-        cur = nxt;
+    while(tstop - t > hmin)
+    {
+        if(this->_ckpt.writer && this->_ckpt.writer->Due()) SaveCheckpoint(this->_res_rows, h, hist_t, hist_x);
+
+        /* Stop at the next breakpoint (or the end), the step rounded to hmin so that it repeats with the source period */
+        double next_bp = breakpoints.Next(t);
+        if(next_bp - t < h) h = std::max(hmin, std::round((next_bp - t) / hmin) * hmin);
+
+        bool step_trap = trap && !euler_start;
+        double a = step_trap ? 2 / h : 1 / h;
+
+        /* Left hand matrix => G + a*C, from the cache or factorized when the timestep changes */
+        if(a != a_fact)
+        {
+            step_solver = this->_adaptive.cache->Find(a);
+
+            if(!step_solver)
+            {
+                sys_mat = op_mat + a * tran_mat;
+                step_solver = this->_adaptive.cache->Insert(a, sys_mat);
+                if(!step_solver) return FAIL_SIMULATOR_FACTORIZATION;
+            }
+
+            a_fact = a;
+        }
+
+        /* Right hand side => Euler: a*C*x + e(t+h), Trapezoidal: (a*C - G)*x + e(t) + e(t+h) */
+        auto &old = hist_x.back();
+        rh.noalias() = tran_mat * old;
+        rh *= a;
+
+        if(step_trap)
+        {
+            rh.noalias() -= op_mat * old;
+            this->_mna_engine.UpdateTRANVec(rh, t);
+        }
+
+        this->_mna_engine.UpdateTRANVec(rh, t + h);
+
+        if(!step_solver->solve(rh, cur)) return FAIL_SIMULATOR_SOLVE;
+
+        /* Error estimate, divided difference over the history and the new timepoint */
+        double grow = 2;
+        if(hist_t.size() > order)
+        {
+            DividedDifference(hist_t, hist_x, t + h, cur, order + 1, lte);
+
+            double lte_scale = trap ? h * h * h / 2 : h * h;
+            double ratio = lte_scale * ErrorRatio(lte, cur, old);
+            double factor = (ratio > 0) ? 0.9 * std::pow(ratio, -1.0 / (order + 1)) : 2;
+
+            /* Reject, repeat with a smaller timestep */
+            if(ratio > 1)
+            {
+                if(h <= hmin) return FAIL_SIMULATOR_TIMESTEP_TOO_SMALL;
+
+                h = std::max(hmin, quantize(h * std::max(0.25, factor)));
+                this->_adaptive.rejected++;
+                continue;
+            }
+
+            grow = factor;
+        }
+
+        /* Accept, exactly on the breakpoint when reached */
+        bool at_bp = (next_bp - (t + h) <= hmin);
+        t = at_bp ? next_bp : t + h;
+        this->_adaptive.accepted++;
+
+        /* The TRAN timepoints up to t, interpolated with the order of the step */
+        hist_t.push_back(t);
+        hist_x.push_back(cur);
+        setGridResults(hist_t, hist_x, std::min((step_trap ? order : 1) + 1, hist_t.size()));
+
+        /* Breakpoint, the history before it is not smooth */
+        if(at_bp && t < tstop)
+        {
+            hist_t.assign(1, t);
+            hist_x.assign(1, cur);
+            h = std::max(hmin, quantize(h / 10));
+            this->_adaptive.breakpoints++;
+            euler_start = false;
+            continue;
+        }
+
+        /* Euler start, the trapezoidal history starts after it */
+        if(euler_start)
+        {
+            hist_t.assign(1, t);
+            hist_x.assign(1, cur);
+            euler_start = false;
+            continue;
+        }
+
+        if(hist_t.size() > order + 1)
+        {
+            hist_t.erase(hist_t.begin());
+            hist_x.erase(hist_x.begin());
+        }
+
+        /* Grow only with a clear margin, in order to avoid refactoring on every step */
+        if(grow >= 1.2) h = quantize(std::min(hmax, h * std::min(grow, 2.0)));
     }
 
     return RETURN_SUCCESS;
 }
 
-
-
 /*!
-    @brief      Sets the results of the simulation for any non-AC analysis.
-    @param      vec   Vector containing the results of the current simulation point.
+    @brief      Performs a transient (TRAN) simulation using the variable order (1 to MAXORD) BDF
+    method, with adaptive timestep. The fixed leading coefficient form is used, the history is
+    interpolated on the uniform grid t(n+1) - j*h, so the coefficients are the uniform step ones
+    and the matrix depends only on the order and the timestep (factorization cache hits):\n
+    (G + a0*C) * x(n+1) = e(t(n+1)) - C * sum(aj * x(t(n+1) - j*h)), j = 1..k\n
+    The local truncation error of order q is estimated as q! * h^(q+1) * DD(q+1). After k + 1
+    steps at the same order, the order among k - 1, k, k + 1 that allows the largest next step
+    is picked. The orders above 2 are not A-stable, but they are stiffly stable which allows much
+    larger steps than the Trapezoidal method on stiff circuits. Breakpoints, the factorization
+    cache, the maximum timestep (TMAX, by default 1/50 of the span) and the results on the TRAN
+    grid are handled as in the adaptive one-step methods.
+    @param      solver      The solver to be used.
+    @return     Error code in case of error, otherwise RETURN_SUCCESS.
 */
-void simulator::setPlotResults(DensVecD &vec)
+return_codes_e simulator::BDFODESolve(linear_solver<SparMatD> &solver)
 {
-    /* Get the indices from the MNA engine */
-    auto &nodes_idx = this->_mna_engine.NodesIdx();
-    auto &sources_idx = this->_mna_engine.SourceIdx();
-    std::vector<double> tmp_vec, tmp_vec2;
-
-    /* Create the vectors - nodes/sources */
-    for(auto it : nodes_idx) tmp_vec.push_back(vec[it]);
-    for(auto it : sources_idx) tmp_vec2.push_back(vec[it]);
+    SparMatD tran_mat, op_mat, sys_mat;
+    DensVecD cur, rh, hist_sum, lte;
 
-    /* Out */
-    this->_res_nodes.push_back(tmp_vec);
-    this->_res_sources.push_back(tmp_vec2);
+    /* Perform the common transient pre-step */
+    return_codes_e err_tmp = TRANpresolve(solver, tran_mat, op_mat, cur, true);
+    if(err_tmp != RETURN_SUCCESS) return err_tmp;
+
+    /* Gear2 with adaptive timestep is the BDF up to order 2 */
+    size_t max_order = (this->_ode_method == GEAR2) ? 2 : this->_adaptive.max_order;
+
+    /* Timestep limits, TMAX or 1/50 of the span, the first steps are taken without an estimate so start small */
+    auto &sim_vector = this->_mna_engine.SimVals();
+    double tstart = sim_vector.front(), tstop = sim_vector.back();
+    double hmax = (this->_adaptive.max_step > 0) ? std::min(this->_adaptive.max_step, tstop - tstart) : (tstop - tstart) / 50;
+    double hmin = (tstop - tstart) * 1e-12;
+    double a_fact = 0;
+
+    /* Round down to the closest timestep hmax / 2^k */
+    auto quantize = [hmax](double step) { return hmax * std::exp2(-std::ceil(std::log2(hmax / step) - 1e-9)); };
+    double h = quantize(std::min(this->_mna_engine.SimStep(), hmax) / 10);
+
+    linear_solver<SparMatD> *step_solver = nullptr;
+    this->_adaptive.cache = std::make_unique<factor_cache<SparMatD>>(solver.Type(), this->_mna_engine.SPDSystem(), this->_adaptive.cache_mem);
+
+    /* Source corners */
+    breakpoint_queue breakpoints;
+    this->_mna_engine.CreateTRANBreakpoints(breakpoints);
+
+    /* History of the accepted timepoints, up to (max_order + 1) for the estimate of the next order */
+    std::vector<double> hist_t = {tstart}, weights;
+    std::vector<DensVecD> hist_x = {cur};
+    size_t order = 1, order_steps = 0;
+    double t = tstart;
+
+    if(this->_ckpt.resumed)
+    {
+        /* Continue from the checkpoint */
+        hist_t = this->_ckpt.state.hist_t;
+        hist_x = this->_ckpt.state.hist_x;
+        h = this->_ckpt.state.h;
+        order = this->_ckpt.state.order;
+        order_steps = this->_ckpt.state.order_steps;
+        t = hist_t.back();
+    }
+    else
+    {
+        ReserveResults(sim_vector.size());
+        setPlotResults(cur);
+    }
+
+    while(tstop - t > hmin)
+    {
+        if(this->_ckpt.writer && this->_ckpt.writer->Due()) SaveCheckpoint(this->_res_rows, h, hist_t, hist_x, order, order_steps);
+
+        /* Stop at the next breakpoint (or the end), the step rounded to hmin so that it repeats with the source period */
+        double next_bp = breakpoints.Next(t);
+        if(next_bp - t < h) h = std::max(hmin, std::round((next_bp - t) / hmin) * hmin);
+
+        double t_new = t + h;
+        size_t n = hist_t.size();
+        size_t k = std::min(order, n);
+
+        /* Interpolating polynomial of the last points of the history (Lagrange basis) */
+        size_t pts = std::min(k + 1, n), first = n - pts;
+        weights.assign(pts, 0);
+
+        /* Fixed leading coefficient, the history is taken on the uniform grid t(n+1) - j*h */
+        double a = 0;
+
+        for(size_t j = 1; j <= k; j++)
+        {
+            /* aj = L'j(t(n+1)), for the uniform grid (Lagrange basis) */
+            double coeff = -1.0 / (j * h);
+
+            for(size_t m = 1; m <= k; m++)
+            {
+                if(m != j) coeff *= (double)m / ((double)m - j);
+            }
+
+            a += 1 / (j * h);
+
+            /* x(t(n+1) - j*h) is a combination of the history points, only the weights are summed */
+            double tj = t_new - j * h;
+
+            for(size_t i = 0; i < pts; i++)
+            {
+                double basis = coeff;
+
+                for(size_t m = 0; m < pts; m++)
+                {
+                    if(m != i) basis *= (tj - hist_t[first + m]) / (hist_t[first + i] - hist_t[first + m]);
+                }
+
+                weights[i] += basis;
+            }
+        }
+
+        hist_sum = weights[0] * hist_x[first];
+        for(size_t i = 1; i < pts; i++) hist_sum.noalias() += weights[i] * hist_x[first + i];
+
+        /* Left hand matrix => G + a0*C, from the cache or factorized when the coefficient changes */
+        if(a != a_fact)
+        {
+            step_solver = this->_adaptive.cache->Find(a);
+
+            if(!step_solver)
+            {
+                sys_mat = op_mat + a * tran_mat;
+                step_solver = this->_adaptive.cache->Insert(a, sys_mat);
+                if(!step_solver) return FAIL_SIMULATOR_FACTORIZATION;
+            }
+
+            a_fact = a;
+        }
+
+        /* Right hand side => e(t(n+1)) - C * sum(aj * x(n+1-j)) */
+        rh.noalias() = tran_mat * hist_sum;
+        rh *= -1;
+        this->_mna_engine.UpdateTRANVec(rh, t_new);
+
+        if(!step_solver->solve(rh, cur)) return FAIL_SIMULATOR_SOLVE;
+
+        /* Error estimates of order q, from the divided difference of order (q + 1) over the history and the new timepoint */
+        auto &old = hist_x.back();
+        auto ratio = [&](size_t q)
+        {
+            DividedDifference(hist_t, hist_x, t_new, cur, q + 1, lte);
+            return std::tgamma(q + 1.0) * std::pow(h, q + 1) * ErrorRatio(lte, cur, old);
+        };
+        auto factor = [](size_t q, double r) { return (r > 0) ? 0.9 * std::pow(r, -1.0 / (q + 1)) : 2; };
+
+        double grow = 2;
+        if(k < n)
+        {
+            double ratio_k = ratio(k);
+            grow = factor(k, ratio_k);
+
+            /* Reject, repeat with a smaller timestep and a lower order when it allows a larger one */
+            if(ratio_k > 1)
+            {
+                if(h <= hmin) return FAIL_SIMULATOR_TIMESTEP_TOO_SMALL;
+
+                if(k > 1 && factor(k - 1, ratio(k - 1)) > grow)
+                {
+                    grow = factor(k - 1, ratio(k - 1));
+                    order = k - 1;
+                    order_steps = 0;
+                }
+
+                h = std::max(hmin, quantize(h * std::max(0.25, grow)));
+                this->_adaptive.rejected++;
+                continue;
+            }
+
+            /* Order selection, a higher order only with a clear margin */
+            if(order_steps >= k + 1)
+            {
+                size_t best = k;
+                double best_grow = grow;
+
+                if(k > 1 && factor(k - 1, ratio(k - 1)) > best_grow)
+                {
+                    best = k - 1;
+                    best_grow = factor(k - 1, ratio(k - 1));
+                }
+
+                if(k < max_order && k + 1 < n && factor(k + 1, ratio(k + 1)) > 1.1 * best_grow)
+                {
+                    best = k + 1;
+                    best_grow = factor(k + 1, ratio(k + 1));
+                }
+
+                if(best != k)
+                {
+                    order = best;
+                    order_steps = 0;
+                    grow = best_grow;
+                }
+            }
+        }
+
+        /* Accept, exactly on the breakpoint when reached */
+        bool at_bp = (next_bp - t_new <= hmin);
+        t = at_bp ? next_bp : t_new;
+        this->_adaptive.accepted++;
+
+        /* The oldest point is overwritten once the history is full */
+        if(hist_t.size() < max_order + 1)
+        {
+            hist_t.push_back(t);
+            hist_x.push_back(cur);
+        }
+        else
+        {
+            std::rotate(hist_t.begin(), hist_t.begin() + 1, hist_t.end());
+            std::rotate(hist_x.begin(), hist_x.begin() + 1, hist_x.end());
+            hist_t.back() = t;
+            hist_x.back() = cur;
+        }
+
+        /* The TRAN timepoints up to t, interpolated with the order of the step */
+        setGridResults(hist_t, hist_x, std::min(k + 1, hist_t.size()));
+
+        /* Breakpoint, the history before it is not smooth (restart from first order) */
+        if(at_bp && t < tstop)
+        {
+            hist_t.assign(1, t);
+            hist_x.assign(1, cur);
+            order = 1;
+            order_steps = 0;
+            h = std::max(hmin, quantize(h / 10));
+            this->_adaptive.breakpoints++;
+            continue;
+        }
+
+        order_steps++;
+
+        /* Grow only with a clear margin, in order to avoid refactoring on every step */
+        if(grow >= 1.2) h = quantize(std::min(hmax, h * std::min(grow, 2.0)));
+    }
+
+    return RETURN_SUCCESS;
+}
+
+/*!
+    @brief      Advances a fixed timestep (Euler/Trapezoidal) solution over the TRAN timepoints
+    (first, last], with the left hand matrix already factorized. The results are saved in the
+    rows of the timepoints, which have to be reserved beforehand (see ReserveResults).
+    @param      solver      The solver, with the left hand matrix factorized.
+    @param      rh_mat      The right hand matrix (C/h for Euler, 2*C/h - G for Trapezoidal).
+    @param      trap        Trapezoidal method (sources at both ends of the step), otherwise Euler.
+    @param      first       Index of the first timepoint.
+    @param      last        Index of the last timepoint.
+    @param      x           The solution at the first timepoint, on return at the last one.
+    @param      rh          Work vector for the right hand side.
+    @return     Error code in case of error, otherwise RETURN_SUCCESS.
+*/
+return_codes_e simulator::FixedStepSweep(linear_solver<SparMatD> &solver, const SparMatD &rh_mat, bool trap,
+                                         size_t first, size_t last, DensVecD &x, DensVecD &rh)
+{
+    auto &sim_vector = this->_mna_engine.SimVals();
+
+    for(size_t i = first + 1; i <= last; i++)
+    {
+        /* Create the right hand side in place */
+        rh.noalias() = rh_mat * x;
+        this->_mna_engine.UpdateTRANVec(rh, sim_vector[i]);
+        if(trap) this->_mna_engine.UpdateTRANVec(rh, sim_vector[i - 1]);
+
+        if(!solver.solve(rh, x)) return FAIL_SIMULATOR_SOLVE;
+        setPlotRow(x, i);
+        StreamRows(i + 1);
+
+        /* The one-step methods need only the current solution */
+        if(this->_ckpt.writer && this->_ckpt.writer->Due()) SaveCheckpoint(i + 1, this->_mna_engine.SimStep(), {sim_vector[i]}, {x});
+    }
+
+    return RETURN_SUCCESS;
+}
+
+/*!
+    @brief      Restores the state of the last checkpoint, the rows of results and the statistics
+    up to it. The checkpoint has to be of the same system and transient options.
+    @param      x           The solution at the checkpoint.
+    @return     Error code in case of error, otherwise RETURN_SUCCESS.
+*/
+return_codes_e simulator::RestoreCheckpoint(DensVecD &x)
+{
+    auto &state = this->_ckpt.state;
+    auto &sim_vector = this->_mna_engine.SimVals();
+    auto nodes_sz = this->_mna_engine.NodesIdx().size();
+    auto sources_sz = this->_mna_engine.SourceIdx().size();
+    std::vector<double> rows;
+
+    if(!this->_ckpt.writer->Load(state, rows)) return FAIL_SIMULATOR_RESTART;
+
+    /* Same netlist (system and results) and method */
+    bool adaptive = this->_adaptive.enabled || this->_ode_method == BDF;
+    bool valid = state.method == this->_ode_method && state.adaptive == adaptive && state.dim == this->_mna_engine.SystemDim();
+    valid = valid && state.tstop == sim_vector.back() && state.step == this->_mna_engine.SimStep();
+    valid = valid && (size_t)state.nodes == nodes_sz && (size_t)state.sources == sources_sz;
+    valid = valid && (size_t)state.rows <= sim_vector.size();
+
+    if(!valid) return FAIL_SIMULATOR_RESTART;
+
+    /* Rows of results, of the TRAN timepoints (the times are not kept) */
+    auto it = rows.begin();
+
+    this->_res_nodes.Resize(state.rows);
+    this->_res_sources.Resize(state.rows);
+
+    for(IntTp row = 0; row < state.rows; row++)
+    {
+        /* Skip the time */
+        it++;
+
+        for(size_t k = 0; k < nodes_sz; k++) this->_res_nodes(row, k) = *it++;
+        for(size_t k = 0; k < sources_sz; k++) this->_res_sources(row, k) = *it++;
+    }
+
+    this->_res_rows = state.rows;
+    this->_ckpt.rows = state.rows;
+    this->_adaptive.accepted = state.accepted;
+    this->_adaptive.rejected = state.rejected;
+    this->_adaptive.breakpoints = state.breakpoints;
+    this->_ckpt.resumed = true;
+
+    /* The measurements continue from the checkpoint, the rows up to it are already accounted */
+    this->_stream.solution_rows = state.rows;
+
+    if(!this->_meas.engine.Empty() && !this->_meas.engine.Restore(state.measures))
+    {
+        std::cout << "[INFO]: Warning, the checkpoint does not match the measurements, they are marked invalid\n";
+        this->_meas.engine.Partial();
+    }
+
+    x = state.hist_x.back();
+
+    std::cout << "[INFO]: Resuming the transient at t = " << state.hist_t.back() << " (" << state.rows << " timepoints)\n";
+
+    return RETURN_SUCCESS;
+}
+
+/*!
+    @brief      Saves a checkpoint of the transient, with the rows of results after the previous
+    checkpoint. The files are written in the background (see checkpoint).
+    @param      rows        Rows of results up to the current timepoint.
+    @param      h           The next timestep.
+    @param      hist_t      Times of the solution history, the current time last.
+    @param      hist_x      The solution history needed by the method, the current solution last.
+    @param      order       The order of the next step (variable order BDF only).
+    @param      order_steps Steps taken at the current order (variable order BDF only).
+*/
+void simulator::SaveCheckpoint(size_t rows, double h, const std::vector<double> &hist_t, const std::vector<DensVecD> &hist_x,
+                               size_t order, size_t order_steps)
+{
+    auto &times = SimulationVec();
+    auto &sim_vector = this->_mna_engine.SimVals();
+    ckpt_state_t state;
+    std::vector<double> new_rows;
+
+    state.method = this->_ode_method;
+    state.adaptive = this->_adaptive.enabled || this->_ode_method == BDF;
+    state.dim = this->_mna_engine.SystemDim();
+    state.tstop = sim_vector.back();
+    state.step = this->_mna_engine.SimStep();
+    state.nodes = this->_mna_engine.NodesIdx().size();
+    state.sources = this->_mna_engine.SourceIdx().size();
+    state.rows = rows;
+    state.h = h;
+    state.order = order;
+    state.order_steps = order_steps;
+    state.accepted = this->_adaptive.accepted;
+    state.rejected = this->_adaptive.rejected;
+    state.breakpoints = this->_adaptive.breakpoints;
+    state.hist_t = hist_t;
+    state.hist_x = hist_x;
+    this->_meas.engine.Save(state.measures);
+
+    /* Only the rows after the previous checkpoint */
+    for(size_t row = this->_ckpt.rows; row < rows; row++)
+    {
+        new_rows.push_back(times[row]);
+        for(size_t k = 0; k < this->_res_nodes.Cols(); k++) new_rows.push_back(this->_res_nodes.Get(row, k));
+        for(size_t k = 0; k < this->_res_sources.Cols(); k++) new_rows.push_back(this->_res_sources.Get(row, k));
+    }
+
+    this->_ckpt.rows = rows;
+    this->_ckpt.writer->Save(std::move(state), std::move(new_rows));
+}
+
+/*!
+    @brief      Performs a transient (TRAN) simulation with waveform relaxation, for the fixed timestep
+    Euler and Trapezoidal methods. The circuit is split along its weak couplings (floating capacitors and
+    the controlling side of the controlled sources, see MNA::CreateTRANPartitions) and the strongly
+    coupled components are grouped in partitions of balanced size, one per thread by default. Then:
+    - Every partition solves its whole transient in parallel, with its own factorization, from the
+    waveforms of its boundary unknowns of the previous iteration (Gauss-Jacobi, see wr_partition).
+    - The partitions exchange the waveforms of the boundary unknowns, and the two steps are repeated
+    until the change of the waveforms is within the tolerances (RELTOL/ABSTOL).\n
+    The iterations converge to the solution of the sequential method. In case they do not (the
+    coupling is not weak after all), the whole circuit is solved with the sequential method.
+    @param      solver      The solver to be used.
+    @return     Error code in case of error, otherwise RETURN_SUCCESS.
+*/
+return_codes_e simulator::RelaxationODESolve(linear_solver<SparMatD> &solver)
+{
+    SparMatD tran_mat, op_mat;
+    DensVecD cur;
+    bool trap = (this->_ode_method == TRAPEZOIDAL);
+
+    /* Given initial state (UIC/loaded), the trapezoidal method needs an Euler first step (sequential) */
+    if(trap && (this->_ic.uic || !this->_ic.load_x0.empty()))
+    {
+        std::cout << "[INFO]: Waveform relaxation does not support a given initial state with TRAP, solving the whole circuit\n";
+        return TrapODESolve(solver);
+    }
+
+    /* Perform the common transient pre-step */
+    return_codes_e err_tmp = TRANpresolve(solver, tran_mat, op_mat, cur);
+    if(err_tmp != RETURN_SUCCESS) return err_tmp;
+
+    auto &sim_vector = this->_mna_engine.SimVals();
+    IntTp dim = cur.size();
+    double a = (trap ? 2 : 1) / this->_mna_engine.SimStep();
+
+    /* Same matrices as the sequential methods, row major for the rows of the partitions */
+    SparMatRowD lhs_mat = SparMatD(op_mat + a * tran_mat);
+    SparMatRowD rh_mat = trap ? SparMatD(a * tran_mat - op_mat) : SparMatD(a * tran_mat);
+
+    /* Strongly coupled components */
+    std::vector<IntTp> comp;
+    IntTp comps = this->_mna_engine.CreateTRANPartitions(comp);
+    std::vector<IntTp> comp_sz(comps, 0), comp_part(comps), order(comps);
+
+    for(auto it : comp) comp_sz[it]++;
+
+    IntTp threads = omp_get_max_threads();
+    IntTp parts = (this->_wr.partitions > 0) ? this->_wr.partitions : threads;
+    parts = std::max<IntTp>(1, std::min(parts, comps));
+    threads = std::min(threads, parts);
+    this->_wr.partitions = parts;
+
+    /* Largest components first, each one to the smallest partition so far */
+    std::vector<IntTp> part_sz(parts, 0);
+    for(IntTp k = 0; k < comps; k++) order[k] = k;
+    std::stable_sort(order.begin(), order.end(), [&](IntTp x, IntTp y) { return comp_sz[x] > comp_sz[y]; });
+
+    for(auto it : order)
+    {
+        auto min_it = std::min_element(part_sz.begin(), part_sz.end());
+        comp_part[it] = min_it - part_sz.begin();
+        *min_it += comp_sz[it];
+    }
+
+    this->_wr.largest = *std::max_element(part_sz.begin(), part_sz.end());
+
+    /* Partition and local index of every unknown */
+    std::vector<IntTp> part(dim), local(dim), bnd(dim, -1);
+    std::vector<std::vector<IntTp>> vars(parts);
+
+    for(IntTp k = 0; k < dim; k++)
+    {
+        part[k] = comp_part[comp[k]];
+        local[k] = vars[part[k]].size();
+        vars[part[k]].push_back(k);
+    }
+
+    /* Boundary unknowns, the ones that appear in the rows of other partitions */
+    IntTp bnd_dim = 0;
+    for(IntTp row = 0; row < dim; row++)
+    {
+        for(SparMatRowD::InnerIterator it(lhs_mat, row); it; ++it)
+        {
+            if(part[it.col()] != part[row] && bnd[it.col()] == -1) bnd[it.col()] = bnd_dim++;
+        }
+    }
+
+    this->_wr.boundary = bnd_dim;
+
+    /* Matrices and factorizations of the partitions */
+    std::vector<wr_partition> partitions;
+    partitions.reserve(parts);
+    for(auto &it : vars) partitions.emplace_back(std::move(it));
+
+    bool spd = this->_mna_engine.SPDSystem();
+    bool ret = true;
+
+    #pragma omp parallel for num_threads(threads) schedule(dynamic) reduction(&&:ret)
+    for(IntTp p = 0; p < parts; p++)
+    {
+        ret = partitions[p].Build(lhs_mat, rh_mat, part, local, bnd, this->_mna_engine, cur, solver.Type(), spd) && ret;
+    }
+
+    if(!ret) return FAIL_SIMULATOR_FACTORIZATION;
+
+    /* Initial waveforms, constant at the OP */
+    DenseMatD wave_old(bnd_dim, sim_vector.size()), wave_new;
+    for(IntTp k = 0; k < dim; k++)
+    {
+        if(bnd[k] != -1) wave_old.row(bnd[k]).setConstant(cur[k]);
+    }
+
+    wave_new = wave_old;
+
+    ReserveResults(sim_vector.size());
+    setPlotRow(cur, 0);
+
+    double change = 0;
+    while(this->_wr.iters < this->_wr.max_iters)
+    {
+        #pragma omp parallel for num_threads(threads) schedule(dynamic) reduction(&&:ret)
+        for(IntTp p = 0; p < parts; p++)
+        {
+            ret = partitions[p].Sweep(this->_mna_engine, trap, wave_old, wave_new, this->_res_nodes, this->_res_sources) && ret;
+        }
+
+        if(!ret) return FAIL_SIMULATOR_SOLVE;
+        this->_wr.iters++;
+
+        /* Change of the boundary waveforms */
+        change = 0;
+        for(IntTp i = 1; bnd_dim && i < wave_new.cols(); i++)
+        {
+            change = std::max(change, ErrorRatio(wave_new.col(i) - wave_old.col(i), wave_new.col(i), wave_old.col(i)));
+        }
+
+        wave_old.swap(wave_new);
+
+        /* Converged, or diverging */
+        if(change <= 1 || !std::isfinite(change)) break;
+    }
+
+    /* Statistics of the solvers of the partitions */
+    for(auto &it : partitions) accumulateSolverStats(this->_worker_stats, it.Stats());
+
+    if(change <= 1)
+    {
+        this->_res_rows = sim_vector.size();
+        return RETURN_SUCCESS;
+    }
+
+    /* The sequential method fills the results again from the first row */
+    std::cout << "[INFO]: Waveform relaxation did not converge after " << this->_wr.iters << " iterations, solving the whole circuit\n";
+    this->_wr.fallback = true;
+
+    return trap ? TrapODESolve(solver) : EulerODESolve(solver);
+}
+
+/*!
+    @brief      Performs a transient (TRAN) simulation using the exponential integrator, for
+    linear circuits. Between two source breakpoints the inputs are linear, e(t) = e0 + s*(t - t0), and the
+    exact solution is:\n
+    x(t0 + tau) = p + q*tau + exp(tau*A)*(x(t0) - p), with G*q = s, G*p = e0 - C*q and A = -C^-1 * G.\n
+    The exponential is approximated in a shift-and-invert Krylov subspace (see krylov_expm), therefore
+    the steps are limited only by the breakpoints. Sources that are not piecewise linear (EXP, SIN)
+    are linearized on the timepoints of the TRAN card. In case the subspace does not converge,
+    the step is halved.
+    @param      solver      The solver to be used.
+    @return     Error code in case of error, otherwise RETURN_SUCCESS.
+*/
+return_codes_e simulator::ExpIntODESolve(linear_solver<SparMatD> &solver)
+{
+    SparMatD tran_mat, op_mat, sys_mat;
+    DensVecD cur;
+
+    /* Perform the common transient pre-step, the solver is left with G factorized */
+    return_codes_e err_tmp = TRANpresolve(solver, tran_mat, op_mat, cur);
+    if(err_tmp != RETURN_SUCCESS) return err_tmp;
+
+    /* Initial conditions, G was not factorized (or with the IC conductances) */
+    if(this->_ic.seeded && !solver.refactor(op_mat)) return FAIL_SIMULATOR_FACTORIZATION;
+
+    auto &sim_vector = this->_mna_engine.SimVals();
+    double tstart = sim_vector.front(), tstop = sim_vector.back();
+    double hmin = (tstop - tstart) * 1e-12;
+    double h_limit = tstop - tstart;
+
+    /* Shift-and-invert factorizations, the shift is a power of 2 so a few are reused */
+    this->_adaptive.cache = std::make_unique<factor_cache<SparMatD>>(solver.Type(), this->_mna_engine.SPDSystem(), this->_adaptive.cache_mem);
+
+    /* Source corners, the TRAN timepoints are added for the sources that are not piecewise linear */
+    breakpoint_queue breakpoints;
+    this->_mna_engine.CreateTRANBreakpoints(breakpoints);
+    bool linear = breakpoints.PiecewiseLinear();
+
+    krylov_expm krylov(this->_adaptive.krylov_dim);
+    DensVecD e0(cur.size()), e1(cur.size()), slope, ramp, part, rh, out;
+
+    this->_adaptive.sim_time.push_back(tstart);
+    setPlotResults(cur);
+
+    double t = tstart;
+    size_t grid = 1;
+    while(tstop - t > hmin)
+    {
+        /* Next TRAN timepoint to output */
+        while(grid < sim_vector.size() && sim_vector[grid] <= t + hmin) grid++;
+
+        double next_bp = breakpoints.Next(t);
+        double t1 = next_bp;
+
+        if(!linear && grid < sim_vector.size()) t1 = std::min(t1, sim_vector[grid]);
+        t1 = std::min(t1, t + h_limit);
+
+        double h = t1 - t;
+
+        /* Linear inputs => particular solution p + q*tau */
+        e0.setZero();
+        e1.setZero();
+        this->_mna_engine.UpdateTRANVec(e0, t);
+        this->_mna_engine.UpdateTRANVec(e1, t1);
+
+        slope = (e1 - e0) / h;
+        if(!solver.solve(slope, ramp)) return FAIL_SIMULATOR_SOLVE;
+
+        rh.noalias() = tran_mat * ramp;
+        rh = e0 - rh;
+        if(!solver.solve(rh, part)) return FAIL_SIMULATOR_SOLVE;
+
+        /* Left hand matrix => G + C/g, with the shift g a power of 2 close to h/10 */
+        double gamma = std::exp2(std::round(std::log2(h / 10)));
+        linear_solver<SparMatD> *shift_solver = this->_adaptive.cache->Find(1 / gamma);
+
+        if(!shift_solver)
+        {
+            sys_mat = op_mat + (1 / gamma) * tran_mat;
+            shift_solver = this->_adaptive.cache->Insert(1 / gamma, sys_mat);
+            if(!shift_solver) return FAIL_SIMULATOR_FACTORIZATION;
+        }
+
+        /* Homogeneous part, from the deviation of the particular solution */
+        bool converged;
+        double tol = this->_adaptive.reltol * cur.cwiseAbs().maxCoeff() + this->_adaptive.abstol;
+
+        rh = cur - part;
+        if(!krylov.Build(*shift_solver, tran_mat, gamma, rh, h, tol, converged)) return FAIL_SIMULATOR_SOLVE;
+
+        if(!converged)
+        {
+            if(h <= hmin) return FAIL_SIMULATOR_TIMESTEP_TOO_SMALL;
+
+            h_limit = h / 2;
+            this->_adaptive.rejected++;
+            continue;
+        }
+
+        this->_adaptive.krylov_dims += krylov.Dim();
+
+        /* TRAN timepoints inside the step, from the same subspace */
+        for(; grid < sim_vector.size() && sim_vector[grid] < t1 - hmin; grid++)
+        {
+            double tau = sim_vector[grid] - t;
+
+            out = part + tau * ramp;
+            krylov.Apply(tau, out);
+
+            this->_adaptive.sim_time.push_back(sim_vector[grid]);
+            setPlotResults(out);
+        }
+
+        cur = part + h * ramp;
+        krylov.Apply(h, cur);
+
+        if(t1 == next_bp && t1 < tstop) this->_adaptive.breakpoints++;
+
+        t = t1;
+        this->_adaptive.sim_time.push_back(t);
+        setPlotResults(cur);
+        this->_adaptive.accepted++;
+
+        /* Recover from a halved step */
+        h_limit *= 2;
+    }
+
+    return RETURN_SUCCESS;
+}
+
+/*!
+    @brief      Computes the divided difference of a given order over the last points of the history
+    and a new point, directly as a combination of the values (no table):
+
+    DD = sum(x(i) / prod(t(i) - t(j), j != i))
+    @param      hist_t      The timepoints of the history (increasing).
+    @param      hist_x      The values at the timepoints of the history.
+    @param      t           The new timepoint (after the history).
+    @param      x           The value at the new timepoint.
+    @param      order       The order, the last (order) points of the history are used, up to its size.
+    @param      dd          The divided difference.
+*/
+void simulator::DividedDifference(const std::vector<double> &hist_t, const std::vector<DensVecD> &hist_x, double t, const DensVecD &x,
+                                  size_t order, DensVecD &dd)
+{
+    size_t n = hist_t.size(), first = n - order;
+    double den = 1;
+
+    for(size_t j = first; j < n; j++) den *= t - hist_t[j];
+    dd = x / den;
+
+    for(size_t i = first; i < n; i++)
+    {
+        den = hist_t[i] - t;
+
+        for(size_t j = first; j < n; j++)
+        {
+            if(j != i) den *= hist_t[i] - hist_t[j];
+        }
+
+        dd.noalias() += hist_x[i] / den;
+    }
+}
+
+/*!
+    @brief      Returns the ratio of the local truncation error against the tolerance, for the
+    worst unknown: max(|lte| / (RELTOL * max(|x(n+1)|, |x(n)|) + ABSTOL)).
+    @param      lte     The local truncation error (or the part of it that is a vector).
+    @param      cur     The new solution.
+    @param      old     The previous solution.
+    @return     The ratio, the step is acceptable when it is up to 1.
+*/
+double simulator::ErrorRatio(const DensVecD &lte, const DensVecD &cur, const DensVecD &old)
+{
+    /* Evaluated in one pass, without a temporary */
+    auto tol = (this->_adaptive.reltol * cur.cwiseAbs().cwiseMax(old.cwiseAbs())).array() + this->_adaptive.abstol;
+    return (lte.cwiseAbs().array() / tol).maxCoeff();
+}
+
+/*!
+    @brief      Performs a transient (TRAN) simulation using the Gear2 (BDF2) method, with fixed
+    timestep. The first step is taken with Euler:\n
+    (G + 3/2*C/h) * x(n+1) = C/h * (2*x(n) - 1/2*x(n-1)) + e(t(n+1))
+    @param      solver      The solver to be used.
+    @return     Error code in case of error, otherwise RETURN_SUCCESS.
+*/
+return_codes_e simulator::Gear2ODESolve(linear_solver<SparMatD> &solver)
+{
+    SparMatD tran_mat, op_mat, tmp_op_mat;
+    DensVecD cur, nxt, old;
+
+    /* Perform the common transient pre-step */
+    return_codes_e err_tmp = TRANpresolve(solver, tran_mat, op_mat, cur, true);
+    if(err_tmp != RETURN_SUCCESS) return err_tmp;
+
+    /****** 2nd step compute the final transient array ******/
+
+    /* Simulation needed parameters */
+    auto &sim_vector = this->_mna_engine.SimVals();
+    double inverse_timestep = 1/this->_mna_engine.SimStep();
+
+    /* Perform 1 step of Euler to get the next needed timepoint and then start GEAR2 */
+    tran_mat = inverse_timestep * tran_mat;
+    tmp_op_mat = op_mat + tran_mat;
+
+    /* Factorization (symbolic analysis reused) */
+    if(!solver.refactor(tmp_op_mat)) return FAIL_SIMULATOR_FACTORIZATION;
+
+    /* Work vectors and results allocated once, the loop below does not allocate */
+    DensVecD rh(cur.size());
+    old = cur;
+    ReserveResults(sim_vector.size());
+
+    /* The first Gear2 timepoint, after t=0 and the Euler one (or after the checkpoint) */
+    size_t first = 2;
+
+    if(this->_ckpt.resumed)
+    {
+        /* The last two timepoints of the checkpoint */
+        old = this->_ckpt.state.hist_x.front();
+        cur = this->_ckpt.state.hist_x.back();
+        first = this->_ckpt.state.rows;
+    }
+    else
+    {
+        setPlotResults(old);
+
+        /* Only t=0, there is no step to take */
+        if(sim_vector.size() < 2) return RETURN_SUCCESS;
+
+        /* Create the right hand side */
+        nxt = tran_mat * old;   // C/h*x(tk-1) + e(tk)
+        this->_mna_engine.UpdateTRANVec(nxt, sim_vector[1]);
+
+        /* Save results */
+        if(!solver.solve(nxt, cur)) return FAIL_SIMULATOR_SOLVE;
+        setPlotResults(cur);
+    }
+
+    /* Common steps - Set up matrices for every side */
+    op_mat = op_mat + 1.5 * tran_mat;
+    tmp_op_mat = -0.5 * tran_mat;
+    tran_mat = 2 * tran_mat;
+
+    /* Factorization (symbolic analysis reused) */
+    if(!solver.refactor(op_mat)) return FAIL_SIMULATOR_FACTORIZATION;
+
+    /****** 3rd step Run for each simulation timepoint ******/
+
+    for(size_t i = first; i < sim_vector.size(); i++)
+    {
+        rh.noalias() = tmp_op_mat * old;
+        rh.noalias() += tran_mat * cur;
+        this->_mna_engine.UpdateTRANVec(rh, sim_vector[i]);
+
+        if(!solver.solve(rh, nxt)) return FAIL_SIMULATOR_SOLVE;
+        setPlotResults(nxt);
+
+        /* Rotate the vectors for the next iteration (no copies) */
+        old.swap(cur);
+        cur.swap(nxt);
+
+        if(this->_ckpt.writer && this->_ckpt.writer->Due())
+            SaveCheckpoint(i + 1, this->_mna_engine.SimStep(), {sim_vector[i - 1], sim_vector[i]}, {old, cur});
+    }
+
+    return RETURN_SUCCESS;
+}
+
+
+
+/*!
+    @brief      Sets the results of the simulation for any non-AC analysis.
+    @param      vec   Vector containing the results of the current simulation point.
+*/
+void simulator::setPlotResults(DensVecD &vec)
+{
+    /* New row, unless reserved beforehand */
+    if(this->_res_rows == this->_res_nodes.Rows())
+    {
+        this->_res_nodes.Resize(this->_res_rows + 1);
+        this->_res_sources.Resize(this->_res_rows + 1);
+    }
+
+    setPlotRow(vec, this->_res_rows++);
+    StreamRows(this->_res_rows);
+}
+
+/*!
+    @brief      Sets the results of a simulation point in a row. Different rows can be set in parallel
+    when they are already allocated (see ReserveResults), except with SAVE ALL or measurements (the
+    solutions are streamed in order). Otherwise the rows are allocated as they are set.
+    @param      vec     Vector containing the results of the simulation point.
+    @param      row     The row.
+*/
+void simulator::setPlotRow(const DensVecD &vec, size_t row)
+{
+    auto &nodes_idx = this->_mna_engine.NodesIdx();
+    auto &sources_idx = this->_mna_engine.SourceIdx();
+
+    if(row >= this->_res_nodes.Rows())
+    {
+        this->_res_nodes.Resize(row + 1);
+        this->_res_sources.Resize(row + 1);
+    }
+
+    /* Out - nodes/sources */
+    this->_res_nodes.Gather(vec, nodes_idx, row);
+    this->_res_sources.Gather(vec, sources_idx, row);
+
+    if(this->_stream.save_all || !this->_meas.engine.Empty()) StreamSolution(vec, row);
+}
+
+/*!
+    @brief      Sets the results of the TRAN timepoints up to the last accepted timepoint (adaptive
+    timestep), interpolated by the polynomial through the last accepted timepoints (Lagrange form).
+    With (order + 1) timepoints the interpolation error is of the order of the LTE of the method.
+    @param      times   The accepted timepoints, the last one is the newest.
+    @param      vals    The solutions of the accepted timepoints.
+    @param      pts     The number of the newest timepoints to interpolate with.
+*/
+void simulator::setGridResults(const std::vector<double> &times, const std::vector<DensVecD> &vals, size_t pts)
+{
+    auto &sim_vector = this->_mna_engine.SimVals();
+    double hmin = (sim_vector.back() - sim_vector.front()) * 1e-12;
+    size_t first = times.size() - pts;
+
+    while(this->_res_rows < sim_vector.size() && sim_vector[this->_res_rows] <= times.back() + hmin)
+    {
+        double tg = sim_vector[this->_res_rows];
+        this->_adaptive.grid_vec.setZero(vals.back().size());
+
+        for(size_t j = first; j < times.size(); j++)
+        {
+            double coeff = 1;
+
+            for(size_t m = first; m < times.size(); m++)
+            {
+                if(m != j) coeff *= (tg - times[m]) / (times[j] - times[m]);
+            }
+
+            this->_adaptive.grid_vec.noalias() += coeff * vals[j];
+        }
+
+        setPlotResults(this->_adaptive.grid_vec);
+    }
+}
+
+/*!
+    @brief      Allocates the rows of the results up front, for analyses with a known number of
+    points. The following setPlotResults() calls copy in place, without allocations.\n
+    The reduced formats of the results (see store_format_t) are allocated as the rows are set
+    instead, so that only the open chunks of rows are held in double precision, and so are the
+    results that are dropped once streamed (see StreamRows), unless the rows are set in parallel
+    (waveform relaxation).
+    @param      rows    The total number of rows.
+*/
+void simulator::ReserveResults(size_t rows)
+{
+    if((this->_res_nodes.Format() != STORE_DOUBLE || !this->_keep_results) && !this->_wr.enabled) return;
+
+    this->_res_nodes.Resize(rows);
+    this->_res_sources.Resize(rows);
 }
 
 /*!
@@ -488,13 +1860,202 @@ void simulator::setPlotResultsCd(DensVecCompD &vec)
     /* Get the indices from the MNA engine */
     auto &nodes_idx = this->_mna_engine.NodesIdx();
     auto &sources_idx = this->_mna_engine.SourceIdx();
-    std::vector<std::complex<double>> tmp_vec, tmp_vec2;
+    size_t row = this->_res_nodes_cd.Rows();
+
+    /* Out - nodes/sources */
+    this->_res_nodes_cd.Resize(row + 1);
+    this->_res_sources_cd.Resize(row + 1);
+    this->_res_nodes_cd.Gather(vec, nodes_idx, row);
+    this->_res_sources_cd.Gather(vec, sources_idx, row);
+    StreamRows(row + 1);
+
+    if(this->_stream.save_all || !this->_meas.engine.Empty()) StreamSolution(vec, row);
+}
+
+/*!
+    @brief      Opens (or reopens, discarding any streamed rows) the rawfile and the waveform file
+    of the analysis, the ones requested. The measurements restart as well.
+    @return     True in case of success, otherwise false.
+*/
+bool simulator::OpenOutputFiles(void)
+{
+    auto type = this->_mna_engine.AnalysisType();
+    std::string plotname;
+
+    switch(type)
+    {
+        case TRAN: plotname = "Transient Analysis"; break;
+        case AC: plotname = "AC Analysis"; break;
+        case DC: plotname = "DC transfer characteristic"; break;
+        default: plotname = "Operating Point"; break;
+    }
+
+    this->_stream.raw.reset();
+    this->_stream.wave.reset();
+    this->_stream.raw_point.resize(this->_stream.raw_vars.size() * (type == AC ? 2 : 1));
+    this->_stream.save_point.resize(this->_stream.save_vars.size() * (type == AC ? 2 : 1));
+
+    if(!this->_stream.raw_file.empty())
+    {
+        this->_stream.raw = std::make_unique<raw_writer>(this->_stream.raw_file, this->_stream.title, plotname, this->_stream.raw_vars, type == AC);
+        if(!this->_stream.raw->Valid()) return false;
+    }
+
+    if(!this->_stream.wave_file.empty())
+    {
+        auto &vars = this->_stream.save_all ? this->_stream.save_vars : this->_stream.raw_vars;
+        this->_stream.wave = std::make_unique<wave_writer>(this->_stream.wave_file, this->_stream.title, vars, type == AC, type != OP,
+                                                           this->_res_nodes.Format());
+        if(!this->_stream.wave->Valid()) return false;
+    }
+
+    return true;
+}
+
+/*!
+    @brief      Streams the rows of results up to a row to the output files, the rows before have to be final.
+    The full chunks of the final rows are sealed afterwards (reduced formats, see result_store), once they are
+    saved in the checkpoints as well. When the results are not kept, the full chunks of the streamed rows are
+    dropped, so the memory of the results does not grow with the run.
+    @param      rows    The rows of results available.
+*/
+void simulator::StreamRows(size_t rows)
+{
+    auto wave = this->_stream.save_all ? nullptr : this->_stream.wave.get();
+    auto &xvals = SimulationVec();
+    bool scale = (this->_mna_engine.AnalysisType() != OP);
+    bool output = this->_stream.raw || wave;
+
+    for(; output && this->_stream.raw_rows < rows; this->_stream.raw_rows++)
+    {
+        size_t row = this->_stream.raw_rows;
+        double *out = this->_stream.raw_point.data();
+
+        if(this->_mna_engine.AnalysisType() == AC)
+        {
+            *out++ = xvals[row];
+            *out++ = 0;
+
+            for(size_t k = 0; k < this->_res_nodes_cd.Cols(); k++) { auto val = this->_res_nodes_cd.Get(row, k); *out++ = val.real(); *out++ = val.imag(); }
+            for(size_t k = 0; k < this->_res_sources_cd.Cols(); k++) { auto val = this->_res_sources_cd.Get(row, k); *out++ = val.real(); *out++ = val.imag(); }
+        }
+        else
+        {
+            if(scale) *out++ = xvals[row];
+
+            for(size_t k = 0; k < this->_res_nodes.Cols(); k++) *out++ = this->_res_nodes.Get(row, k);
+            for(size_t k = 0; k < this->_res_sources.Cols(); k++) *out++ = this->_res_sources.Get(row, k);
+        }
+
+        if(this->_stream.raw) this->_stream.raw->Push(this->_stream.raw_point.data());
+        if(wave) wave->Push(this->_stream.raw_point.data());
+    }
+
+    /* Not kept, the rows streamed (all of them without output files of rows) are not needed any more */
+    if(!this->_keep_results)
+    {
+        size_t done = output ? this->_stream.raw_rows : rows;
+
+        this->_res_nodes.Drop(done);
+        this->_res_sources.Drop(done);
+        this->_res_nodes_cd.Drop(done);
+        this->_res_sources_cd.Drop(done);
+        return;
+    }
+
+    /* The output files get the rows in double precision, so do the checkpoints */
+    if(this->_ckpt.writer) rows = std::min(rows, this->_ckpt.rows);
+
+    if(this->_mna_engine.AnalysisType() == AC)
+    {
+        this->_res_nodes_cd.Seal(rows);
+        this->_res_sources_cd.Seal(rows);
+    }
+    else
+    {
+        this->_res_nodes.Seal(rows);
+        this->_res_sources.Seal(rows);
+    }
+}
+
+/*!
+    @brief      Prints the memory of the results and the maximum error of every plotted unknown,
+    for the reduced formats (see store_format_t).
+    @param      nodes       The results of the nodes.
+    @param      sources     The results of the sources.
+*/
+template<typename T>
+void simulator::printStoreStats(const result_store<T> &nodes, const result_store<T> &sources) const
+{
+    static const char *formats[] = {"DOUBLE", "FLOAT", "INT16"};
+
+    if(nodes.Format() == STORE_DOUBLE) return;
+
+    /* The names of the plotted unknowns follow the scale */
+    size_t cols = nodes.Cols() + sources.Cols();
+    size_t first = this->_stream.raw_vars.size() - cols;
+    double bytes = nodes.Bytes() + sources.Bytes();
+    double full = static_cast<double>(nodes.Rows()) * cols * sizeof(T);
+
+    std::cout << "Results: " << formats[nodes.Format()] << ", " << bytes / 1048576.0 << "MB (";
+    std::cout << full / 1048576.0 << "MB in double precision)\n";
+
+    /* Dropped once streamed, the output files have the rows in double precision */
+    if(!this->_keep_results) return;
+
+    for(size_t k = 0; k < cols; k++)
+    {
+        auto &res = (k < nodes.Cols()) ? nodes : sources;
+        size_t col = (k < nodes.Cols()) ? k : k - nodes.Cols();
+        double peak = res.Peak(col);
+
+        std::cout << "\t" << this->_stream.raw_vars[first + k].name << ": max error " << res.MaxError(col);
+        if(peak > 0) std::cout << " (" << res.MaxError(col) / peak << " of the peak)";
+        std::cout << "\n";
+    }
+}
+
+/*!
+    @brief      Streams the solution of a simulation point to the measurements and to the waveform file (SAVE ALL). The
+    solutions have to be final and in order, the rows already streamed are skipped.
+    @param      vec     The solution.
+    @param      row     The row (simulation point).
+*/
+void simulator::StreamSolution(const DensVecD &vec, size_t row)
+{
+    if(row < this->_stream.solution_rows) return;
+
+    this->_stream.solution_rows = row + 1;
+    if(this->_mna_engine.AnalysisType() != OP) this->_meas.engine.Update(SimulationVec()[row], vec);
+    if(!this->_stream.save_all || !this->_stream.wave) return;
+
+    double *out = this->_stream.save_point.data();
+
+    if(this->_mna_engine.AnalysisType() != OP) *out++ = SimulationVec()[row];
+    std::copy(vec.data(), vec.data() + vec.size(), out);
+
+    this->_stream.wave->Push(this->_stream.save_point.data());
+}
+
+/*!
+    @brief      Streams the solution of a frequency point to the measurements and to the waveform file (SAVE ALL, AC).
+    @param      vec     The solution.
+    @param      row     The row (frequency point).
+*/
+void simulator::StreamSolution(const DensVecCompD &vec, size_t row)
+{
+    if(row < this->_stream.solution_rows) return;
+
+    this->_stream.solution_rows = row + 1;
+    this->_meas.engine.Update(SimulationVec()[row], vec);
+    if(!this->_stream.save_all || !this->_stream.wave) return;
+
+    double *out = this->_stream.save_point.data();
+
+    *out++ = SimulationVec()[row];
+    *out++ = 0;
 
-    /* Create the vectors - nodes/sources */
-    for(auto it : nodes_idx) tmp_vec.push_back(vec[it]);
-    for(auto it : sources_idx) tmp_vec2.push_back(vec[it]);
+    for(IntTp k = 0; k < vec.size(); k++) { *out++ = vec[k].real(); *out++ = vec[k].imag(); }
 
-    /* Out */
-    this->_res_nodes_cd.push_back(tmp_vec);
-    this->_res_sources_cd.push_back(tmp_vec2);
+    this->_stream.wave->Push(this->_stream.save_point.data());
 }
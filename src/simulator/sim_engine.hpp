@@ -2,13 +2,113 @@
 #define __SIM_ENGINE_H
 
 #include "mna.hpp"
+#include "linear_solver.hpp"
+#include "factor_cache.hpp"
+#include "krylov_expm.hpp"
+#include "wr_partition.hpp"
+#include "checkpoint.hpp"
+#include "result_store.hpp"
+#include "raw_writer.hpp"
+#include "wave_file.hpp"
+#include "measure.hpp"
 #include "simulator_types.hpp"
 
+/** The command line arguments of a simulation. */
+typedef struct simulator_arguments
+{
+    bool restart = false;           //!< Resume the transient from the last checkpoint.
+    std::string load_x0;            //!< File of the initial state of the transient (none when empty).
+    std::string save_x0;            //!< File to save the OP to, as an initial state (none when empty).
+    std::string raw;                //!< File to stream the results to, SPICE rawfile (none when empty).
+    std::string wave;               //!< File to stream the results to, chunked waveform file (none when empty).
+    std::string meas;               //!< File of the measurement results, JSON (netlist name with .meas.json when empty).
+    std::string csv;                //!< File to export the results to, CSV (none when empty).
+    std::string tsv;                //!< File to export the results to, TSV (none when empty).
+    bool headless = false;          //!< No plotting (no GNUPLOT process), the results go to the output files only.
+} sim_args_t;
+
+/** State of the adaptive timestep transient (and the exponential integrator). */
+typedef struct adaptive_state
+{
+    bool enabled = false;           //!< Timestep adapted to the local truncation error (otherwise fixed).
+    double reltol = 0;              //!< Relative tolerance of the local truncation error.
+    double abstol = 0;              //!< Absolute tolerance of the local truncation error.
+    double max_step = 0;            //!< Maximum timestep (TMAX, 0 for 1/50 of the span).
+    IntTp max_order = 0;            //!< Maximum order of the variable order BDF method.
+    IntTp accepted = 0;             //!< Number of accepted timesteps.
+    IntTp rejected = 0;             //!< Number of rejected timesteps.
+    IntTp breakpoints = 0;          //!< Number of source breakpoints landed on.
+    IntTp krylov_dims = 0;          //!< Total dimension of the Krylov subspaces (exponential integrator only).
+    static constexpr IntTp krylov_dim = 40;     //!< Maximum dimension of a Krylov subspace.
+    std::vector<double> sim_time;   //!< The timepoints of the results, when not the TRAN ones (exponential integrator only).
+    DensVecD grid_vec;              //!< The results interpolated on a TRAN timepoint.
+    double cache_mem = 0;           //!< Memory budget of the factorization cache (bytes).
+    std::unique_ptr<factor_cache<SparMatD>> cache;  //!< Factorizations by timestep.
+} adaptive_state_t;
+
+/** State of the waveform relaxation transient. */
+typedef struct relaxation_state
+{
+    bool enabled = false;           //!< Fixed timestep transient solved with waveform relaxation on circuit partitions.
+    IntTp partitions = 0;           //!< Number of partitions (0 for one per thread).
+    IntTp iters = 0;                //!< Number of waveform relaxation iterations.
+    IntTp largest = 0;              //!< Dimension of the largest partition.
+    IntTp boundary = 0;             //!< Number of boundary unknowns (exchanged waveforms).
+    bool fallback = false;          //!< Not converged, the whole circuit was solved with the sequential method.
+    static constexpr IntTp max_iters = 50;      //!< Maximum waveform relaxation iterations.
+} relaxation_state_t;
+
+/** State of the checkpoints of the transient, and of a restart from them. */
+typedef struct checkpoint_run_state
+{
+    bool restart = false;           //!< Resume the transient from the last checkpoint.
+    bool resumed = false;           //!< The transient was resumed, the restored state is in state.
+    double interval = 0;            //!< Wall clock interval of the checkpoints (s, 0 for none).
+    std::string file;               //!< The checkpoint file.
+    size_t rows = 0;                //!< Rows of results saved in the checkpoints.
+    ckpt_state_t state;             //!< The restored state (resumed transient only).
+    std::unique_ptr<checkpoint> writer;     //!< The checkpoints (sequential time stepping methods).
+} ckpt_run_state_t;
+
+/** Initial state of the transient. */
+typedef struct initial_state
+{
+    bool uic = false;               //!< Start from the initial conditions (UIC), without the OP.
+    bool seeded = false;            //!< x(0) is not the plain OP (initial conditions or loaded), G is not factorized.
+    std::string load_x0;            //!< File of the initial state (none when empty).
+    std::string save_x0;            //!< File to save the OP to (none when empty).
+    static constexpr double conductance = 1e9;  //!< Conductance of the IC nodes, relative to the largest of G.
+} initial_state_t;
+
+/** State of the streaming output (rawfile, waveform file). */
+typedef struct stream_state
+{
+    std::string raw_file;           //!< The rawfile (none when empty).
+    std::string wave_file;          //!< The waveform file (none when empty).
+    std::string title;              //!< The title of the output files (netlist).
+    std::vector<raw_var_t> raw_vars;                //!< The variables of the output files, the scale first.
+    std::unique_ptr<raw_writer> raw;                //!< The rawfile writer.
+    std::unique_ptr<wave_writer> wave;              //!< The waveform file writer.
+    size_t raw_rows = 0;            //!< Rows of results streamed.
+    std::vector<double> raw_point;  //!< Workspace of a point.
+    bool save_all = false;          //!< All the unknowns are streamed to the waveform file (SAVE ALL).
+    std::vector<raw_var_t> save_vars;               //!< The variables of the waveform file for SAVE ALL, the scale first.
+    size_t solution_rows = 0;       //!< Rows of solutions streamed (SAVE ALL, measurements).
+    std::vector<double> save_point; //!< Workspace of a point (SAVE ALL).
+} stream_state_t;
+
+/** The measurements of the analysis. */
+typedef struct measure_run_state
+{
+    measure_engine engine;          //!< The measurements, evaluated on the solutions.
+    std::string file;               //!< The JSON file of the measurement results.
+} meas_run_state_t;
+
 //! A simulator class. The purpose of this class is to represent the simulation engine.
 /*!
   This class has all the methods needed to perform simulation on the given SPICE circuit.
   Therefore, in this class, the following are provided:
-  - Different solvers depending on configuration.
+  - Different solvers depending on configuration (runtime, see linear_solver).
   - Simulation methods (TRAN, AC, DC, OP).
   - Different ODE methods for TRAN.
   - Access to the results of the simulation.
@@ -18,15 +118,16 @@ class simulator
 	public:
 
         /* Constructors */
-        simulator(circuit &circuit_manager);
+        simulator(circuit &circuit_manager, const sim_args_t &args = sim_args_t());
 
         /* Getters */
 		bool valid(void) noexcept;
 		const std::vector<double> &SimulationVec(void) noexcept;
-		const std::vector<std::vector<double>> &NodesResults(void) noexcept;
-		const std::vector<std::vector<double>> &SourceResults(void) noexcept;
-		const std::vector<std::vector<std::complex<double>>> &NodesResultsCd(void) noexcept;
-		const std::vector<std::vector<std::complex<double>>> &SourceResultsCd(void) noexcept;
+		const result_store<double> &NodesResults(void) noexcept;
+		const result_store<double> &SourceResults(void) noexcept;
+		const result_store<std::complex<double>> &NodesResultsCd(void) noexcept;
+		const result_store<std::complex<double>> &SourceResultsCd(void) noexcept;
+		const relaxation_state_t &RelaxationStats(void) noexcept;
 
 		/* Methods */
 		return_codes_e run(void);
@@ -37,15 +138,53 @@ class simulator
 		return_codes_e TRAN_analysis(void);
 		return_codes_e AC_analysis(void);
 
+		/* Analysis bodies */
+		return_codes_e OPSolve(linear_solver<SparMatD> &solver);
+		return_codes_e DCSolve(linear_solver<SparMatD> &solver);
+		return_codes_e TRANSolve(linear_solver<SparMatD> &solver);
+		return_codes_e ACSolve(linear_solver<SparMatCompD> &solver);
+
 		/* Integration solvers */
-		return_codes_e TRANpresolve(SparMatD &tran_mat, SparMatD &op_mat, DensVecD &op_res);
-		return_codes_e EulerODESolve(void);
-        return_codes_e TrapODESolve(void);
-        return_codes_e Gear2ODESolve(void); // TODO
+		return_codes_e TRANpresolve(linear_solver<SparMatD> &solver, SparMatD &tran_mat, SparMatD &op_mat, DensVecD &op_res,
+		                            bool resumable = false);
+		return_codes_e EulerODESolve(linear_solver<SparMatD> &solver);
+        return_codes_e TrapODESolve(linear_solver<SparMatD> &solver);
+        return_codes_e Gear2ODESolve(linear_solver<SparMatD> &solver);
+        return_codes_e AdaptiveODESolve(linear_solver<SparMatD> &solver);
+        return_codes_e BDFODESolve(linear_solver<SparMatD> &solver);
+        return_codes_e ExpIntODESolve(linear_solver<SparMatD> &solver);
+        return_codes_e RelaxationODESolve(linear_solver<SparMatD> &solver);
+        return_codes_e FixedStepSweep(linear_solver<SparMatD> &solver, const SparMatD &rh_mat, bool trap,
+                                      size_t first, size_t last, DensVecD &x, DensVecD &rh);
+
+        /* Checkpoint/restart */
+        return_codes_e RestoreCheckpoint(DensVecD &x);
+        void SaveCheckpoint(size_t rows, double h, const std::vector<double> &hist_t, const std::vector<DensVecD> &hist_x,
+                            size_t order = 0, size_t order_steps = 0);
+
+        /* Truncation error estimation */
+        void DividedDifference(const std::vector<double> &hist_t, const std::vector<DensVecD> &hist_x, double t, const DensVecD &x,
+                               size_t order, DensVecD &dd);
+        double ErrorRatio(const DensVecD &lte, const DensVecD &cur, const DensVecD &old);
+
+        /* Solver handling */
+        template<typename MatTp> return_codes_e SolveWithFallback(return_codes_e (simulator::*analysis)(linear_solver<MatTp> &));
+        template<typename MatTp> void setSolverStats(linear_solver<MatTp> &solver);
+        void ResetRunState(void);
 
         /* Handling of results */
         void setPlotResults(DensVecD &vec);
+        void setPlotRow(const DensVecD &vec, size_t row);
+        void setGridResults(const std::vector<double> &times, const std::vector<DensVecD> &vals, size_t pts);
+        void ReserveResults(size_t rows);
         void setPlotResultsCd(DensVecCompD &vec);
+        template<typename T> void printStoreStats(const result_store<T> &nodes, const result_store<T> &sources) const;
+
+        /* Streaming output */
+        bool OpenOutputFiles(void);
+        void StreamRows(size_t rows);
+        void StreamSolution(const DensVecD &vec, size_t row);
+        void StreamSolution(const DensVecCompD &vec, size_t row);
 
 		/* Simulator sub-engines */
 		MNA _mna_engine;                //!< The MNA engine, generates MNA matrices and vectors.
@@ -54,11 +193,28 @@ class simulator
         bool _run;                      //!< Flag that indicates whether the results are valid or not.
 		ODE_meth_t _ode_method;         //!< ODE method to be used for transient analysis.
 
+		/* Per feature state */
+		adaptive_state_t _adaptive;     //!< Adaptive timestep (and exponential integrator).
+		relaxation_state_t _wr;         //!< Waveform relaxation.
+		ckpt_run_state_t _ckpt;         //!< Checkpoint/restart.
+		initial_state_t _ic;            //!< Initial state of the transient.
+		stream_state_t _stream;         //!< Streaming output (rawfile, waveform file).
+		meas_run_state_t _meas;         //!< Measurements.
+
+		/* Linear solver */
+		solver_t _solver_type;          //!< Linear solver requested for the analysis.
+		solver_t _solver_used;          //!< Linear solver actually used (after automatic choice/fallback).
+		bool _lu_stats;                 //!< The LU factorization is measured once, to compare with Cholesky.
+		solver_stats_t _solver_stats;   //!< Statistics of the linear solver used.
+		solver_stats_t _worker_stats;   //!< Statistics of the solvers of the parallel workers (waveform relaxation).
+
 		/* Vectors used to save the plot/save the results */
-		std::vector<std::vector<double>> _res_nodes;                    //!< Results for nodes voltages, used in plotting.
-        std::vector<std::vector<double>> _res_sources;                  //!< Results for sources current, used in plotting.
-		std::vector<std::vector<std::complex<double>>> _res_nodes_cd;   //!< Results for sources current, used in plotting (AC only).
-		std::vector<std::vector<std::complex<double>>> _res_sources_cd; //!< Results for sources current, used in plotting (AC only).
+		result_store<double> _res_nodes;                    //!< Results for nodes voltages, used in plotting.
+        result_store<double> _res_sources;                  //!< Results for sources current, used in plotting.
+        size_t _res_rows;                                   //!< Rows of results written (rows may be reserved ahead).
+        bool _keep_results;                                 //!< The results are kept once streamed (plotting, CSV/TSV, checkpoints).
+		result_store<std::complex<double>> _res_nodes_cd;   //!< Results for nodes voltages, used in plotting (AC only).
+		result_store<std::complex<double>> _res_sources_cd; //!< Results for sources current, used in plotting (AC only).
 };
 
 #endif // __SIM_ENGINE_H //
@@ -0,0 +1,105 @@
+#ifndef __SPARSELU_ADAPTER_H
+#define __SPARSELU_ADAPTER_H
+
+#include "matrix_types.hpp"
+
+/*
+    The supernodal L solve reads the storage of the L factor (SparseLU::matrixL().m_mapL), which is not
+    a public interface of Eigen. It is enabled for the vendored Eigen 3.4.0 (src/lib/Eigen) only, other
+    versions fall back to SparseLU::solve (allocates per solve). On an upgrade, check
+    MappedSuperNodalMatrix::solveInPlace (SparseLU_SupernodalMatrix.h) and extend the version check.
+    The result is checked against SparseLU::solve in test/alloc_test.cpp.
+*/
+#if EIGEN_WORLD_VERSION == 3 && EIGEN_MAJOR_VERSION == 4 && EIGEN_MINOR_VERSION == 0
+    #define BSPICE_SPARSELU_SUPERNODAL_SOLVE
+#endif
+
+//! Allocation free solves with the factors of Eigen::SparseLU.
+/*!
+  Eigen's SparseLU::solve allocates on every call: a mask for each in place permutation and a
+  workspace for the supernodal L solve. The adapter performs the same steps with workspaces kept
+  by the caller, so the solves of a transient do not allocate once the workspaces are sized.
+*/
+template<typename SolverTp>
+class sparselu_adapter
+{
+    public:
+        typedef typename SolverTp::Scalar ScalarTp;                                     //!< Scalar of the system.
+        typedef Eigen::Matrix<ScalarTp, Eigen::Dynamic, 1> VecTp;                       //!< Dense vector type.
+        typedef Eigen::Matrix<ScalarTp, Eigen::Dynamic, Eigen::Dynamic> MultiVecTp;     //!< Dense multi-vector type.
+
+        /*!
+            @brief      Solves the factorized system for one right hand side, same result as SparseLU::solve.
+            @param      solver  The factorized solver.
+            @param      rh      The right hand side.
+            @param      sol     The solution.
+        */
+        void solve(const SolverTp &solver, const VecTp &rh, VecTp &sol)
+        {
+#ifdef BSPICE_SPARSELU_SUPERNODAL_SOLVE
+            _work.resize(rh.size());
+            _work.noalias() = solver.rowsPermutation() * rh;
+            solveL(solver, _work);
+            solver.matrixU().solveInPlace(_work);
+            sol.resize(rh.size());
+            sol.noalias() = solver.colsPermutation().inverse() * _work;
+#else
+            sol = solver.solve(rh);
+#endif
+        }
+
+    private:
+#ifdef BSPICE_SPARSELU_SUPERNODAL_SOLVE
+        /*!
+            @brief      Solves with the unit lower factor in place, supernode by supernode (as
+            MappedSuperNodalMatrix::solveInPlace), the updates of the rows below a supernode go
+            through the kept workspace.
+            @param      solver  The factorized solver.
+            @param      x       The right hand side, overwritten by the solution.
+        */
+        void solveL(const SolverTp &solver, VecTp &x)
+        {
+            typedef Eigen::Map<const MultiVecTp, 0, Eigen::OuterStride<>> BlockTp;
+
+            auto &L = solver.matrixL().m_mapL;
+            auto *vals = L.valuePtr();
+            auto *col_ptr = L.colIndexPtr();
+            auto *row_idx = L.rowIndex();
+            auto *row_ptr = L.rowIndexPtr();
+
+            _work_rows.resize(x.size());
+
+            for(Eigen::Index k = 0; k <= L.nsuper(); k++)
+            {
+                Eigen::Index fsupc = L.supToCol()[k];
+                Eigen::Index istart = row_ptr[fsupc];
+                Eigen::Index nsupr = row_ptr[fsupc + 1] - istart;
+                Eigen::Index nsupc = L.supToCol()[k + 1] - fsupc;
+                Eigen::Index nrow = nsupr - nsupc;
+                Eigen::Index luptr = col_ptr[fsupc];
+                Eigen::Index lda = col_ptr[fsupc + 1] - luptr;
+
+                /* Single column, the diagonal first */
+                if(nsupc == 1)
+                {
+                    for(Eigen::Index i = 1; i < nsupr; i++) x(row_idx[istart + i]) -= x(fsupc) * vals[luptr + i];
+                    continue;
+                }
+
+                /* Dense triangle of the supernode, then the rows below */
+                BlockTp diag(vals + luptr, nsupc, nsupc, Eigen::OuterStride<>(lda));
+                BlockTp below(vals + luptr + nsupc, nrow, nsupc, Eigen::OuterStride<>(lda));
+
+                diag.template triangularView<Eigen::UnitLower>().solveInPlace(x.segment(fsupc, nsupc));
+                _work_rows.head(nrow).noalias() = below * x.segment(fsupc, nsupc);
+
+                for(Eigen::Index i = 0; i < nrow; i++) x(row_idx[istart + nsupc + i]) -= _work_rows(i);
+            }
+        }
+
+        VecTp _work;            //!< Workspace of a solve (permuted right hand side).
+        VecTp _work_rows;       //!< Workspace of the rows below a supernode.
+#endif
+};
+
+#endif // __SPARSELU_ADAPTER_H //
@@ -0,0 +1,633 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include "wave_file.hpp"
+
+static constexpr char wave_magic[8] = {'B', 'S', 'P', 'W', 'A', 'V', 'E', '4'};
+static constexpr char index_magic[8] = {'B', 'S', 'P', 'W', 'I', 'D', 'X', '1'};
+static constexpr uint64_t wave_sized_rows = 16;     //!< Rows from which a chunk has the sizes of its columns.
+
+/*!
+    @brief      Returns the bit pattern of a sample converted to a format. The 16-bit integers map
+    the range of the column to [-INT16_MAX, INT16_MAX], INT16_MIN is a non-finite sample.
+    @param      val         The sample.
+    @param      format      The format.
+    @param      center      The center of the range of the column (16-bit integers).
+    @param      step        The quantization step of the column (16-bit integers).
+    @return     The bit pattern.
+*/
+static uint64_t sampleBits(double val, store_format_t format, double center, double step)
+{
+    uint64_t bits = 0;
+
+    if(format == STORE_FLOAT)
+    {
+        float single = static_cast<float>(val);
+        uint32_t pattern;
+
+        std::memcpy(&pattern, &single, sizeof(pattern));
+        bits = pattern;
+    }
+    else if(format == STORE_INT16)
+    {
+        long q = INT16_MIN;
+
+        if(std::isfinite(val)) q = (step == 0) ? 0 : std::clamp<long>(std::lround((val - center) / step), -INT16_MAX, INT16_MAX);
+        bits = static_cast<uint64_t>(static_cast<int64_t>(q));
+    }
+    else
+    {
+        std::memcpy(&bits, &val, sizeof(bits));
+    }
+
+    return bits;
+}
+
+/*!
+    @brief      Returns the sample of a bit pattern, written by sampleBits().
+    @param      bits        The bit pattern.
+    @param      format      The format.
+    @param      center      The center of the range of the column (16-bit integers).
+    @param      step        The quantization step of the column (16-bit integers).
+    @return     The sample.
+*/
+static double sampleValue(uint64_t bits, store_format_t format, double center, double step)
+{
+    double val;
+
+    if(format == STORE_FLOAT)
+    {
+        uint32_t pattern = static_cast<uint32_t>(bits);
+        float single;
+
+        std::memcpy(&single, &pattern, sizeof(single));
+        val = single;
+    }
+    else if(format == STORE_INT16)
+    {
+        int64_t q = static_cast<int64_t>(bits);
+        val = (q == INT16_MIN) ? std::numeric_limits<double>::quiet_NaN() : center + step * q;
+    }
+    else
+    {
+        std::memcpy(&val, &bits, sizeof(val));
+    }
+
+    return val;
+}
+
+/*!
+    @brief      Returns the format of the samples of a single row chunk, stored as they are (there is
+    no range to scale 16-bit integers to, they are stored in single precision).
+    @param      format      The format of the column.
+    @return     The format of the samples.
+*/
+static store_format_t rowFormat(store_format_t format)
+{
+    return (format == STORE_INT16) ? STORE_FLOAT : format;
+}
+
+/*!
+    @brief      Returns the bytes of a sample of a single row chunk.
+    @param      format      The format of the column.
+    @return     The bytes.
+*/
+static size_t rowBytes(store_format_t format)
+{
+    return (rowFormat(format) == STORE_DOUBLE) ? sizeof(double) : sizeof(float);
+}
+
+/*!
+    @brief      Compresses a column. The bit pattern of every sample (converted to the format) is
+    predicted by a linear extrapolation of the previous two (second order delta, exact in integer
+    arithmetic), the residual is zigzag encoded and stored without its zero leading bytes. The
+    lengths (0-8 bytes) are stored first, two per byte, followed by the residuals. The 16-bit
+    integers start with the center of the range and the quantization step.
+    @param      in      The samples.
+    @param      n       The number of samples.
+    @param      format  The format of the samples.
+    @param      out     The compressed column, appended.
+*/
+static void encodeColumn(const double *in, size_t n, store_format_t format, std::vector<char> &out)
+{
+    double center = 0, step = 0;
+
+    if(format == STORE_INT16)
+    {
+        double lo = INFINITY, hi = -INFINITY;
+
+        for(size_t i = 0; i < n; i++)
+        {
+            if(std::isfinite(in[i])) { lo = std::min(lo, in[i]); hi = std::max(hi, in[i]); }
+        }
+
+        center = (lo <= hi) ? lo / 2 + hi / 2 : 0;
+        step = (lo < hi) ? (hi / 2 - lo / 2) / INT16_MAX : 0;
+
+        out.insert(out.end(), reinterpret_cast<const char *>(&center), reinterpret_cast<const char *>(&center + 1));
+        out.insert(out.end(), reinterpret_cast<const char *>(&step), reinterpret_cast<const char *>(&step + 1));
+    }
+
+    size_t lens = out.size(), pos = lens + (n + 1) / 2;
+    uint64_t p1 = 0, p2 = 0;
+
+    /* Worst case, the residuals are written as whole words (little endian) and overlap */
+    out.resize(pos + n * sizeof(uint64_t), 0);
+
+    for(size_t i = 0; i < n; i++)
+    {
+        uint64_t bits = sampleBits(in[i], format, center, step), res;
+
+        res = bits - (2 * p1 - p2);
+        res = (res << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(res) >> 63);
+        p2 = i ? p1 : bits;
+        p1 = bits;
+
+        int nb = res ? 8 - __builtin_clzll(res) / 8 : 0;
+
+        out[lens + i / 2] |= static_cast<char>(nb << (4 * (i & 1)));
+        std::memcpy(out.data() + pos, &res, sizeof(res));
+        pos += nb;
+    }
+
+    out.resize(pos);
+}
+
+/*!
+    @brief      Decompresses a column, written by encodeColumn().
+    @param      in      The compressed column.
+    @param      end     The end of the compressed column.
+    @param      n       The number of samples.
+    @param      format  The format of the samples.
+    @param      out     The samples.
+    @return     True in case of success, otherwise false (corrupted column).
+*/
+static bool decodeColumn(const char *in, const char *end, size_t n, store_format_t format, double *out)
+{
+    double center = 0, step = 0;
+
+    if(format == STORE_INT16)
+    {
+        if(end - in < static_cast<std::ptrdiff_t>(2 * sizeof(double))) return false;
+
+        std::memcpy(&center, in, sizeof(double));
+        std::memcpy(&step, in + sizeof(double), sizeof(double));
+        in += 2 * sizeof(double);
+    }
+
+    const unsigned char *lens = reinterpret_cast<const unsigned char *>(in);
+    uint64_t p1 = 0, p2 = 0;
+
+    if(end - in < static_cast<std::ptrdiff_t>((n + 1) / 2)) return false;
+    in += (n + 1) / 2;
+
+    for(size_t i = 0; i < n; i++)
+    {
+        int nb = (lens[i / 2] >> (4 * (i & 1))) & 0xF;
+        uint64_t res = 0, bits;
+
+        if(nb > 8 || end - in < nb) return false;
+
+        for(int b = 0; b < nb; b++) res |= static_cast<uint64_t>(static_cast<unsigned char>(in[b])) << (8 * b);
+        in += nb;
+
+        bits = (res >> 1) ^ (0 - (res & 1));
+        bits += 2 * p1 - p2;
+        p2 = i ? p1 : bits;
+        p1 = bits;
+
+        out[i] = sampleValue(bits, format, center, step);
+    }
+
+    return in == end;
+}
+
+/*!
+    @brief      Constructor, writes the header and starts the I/O thread.
+    @param      file        The waveform file.
+    @param      title       The title of the simulation.
+    @param      vars        The variables, the scale (time/frequency/sweep) first, except for OP.
+    @param      complex     Complex variables (AC), two columns each.
+    @param      scale       The first variable is the scale (time/frequency/sweep).
+    @param      format      The format of the samples (the scale is in double precision).
+*/
+wave_writer::wave_writer(const std::string &file, const std::string &title, const std::vector<raw_var_t> &vars,
+                         bool complex, bool scale, store_format_t format)
+                         : _out(file, std::ios::binary | std::ios::trunc), _scale(scale), _format(format)
+{
+    auto put = [&](uint64_t val) { _out.write(reinterpret_cast<const char *>(&val), sizeof(val)); };
+    auto put_str = [&](const std::string &str) { put(str.size()); _out.write(str.data(), str.size()); };
+
+    _cols = vars.size() * (complex ? 2 : 1);
+    _chunk_rows = std::clamp<size_t>(_buffer_bytes / (sizeof(double) * std::max<size_t>(_cols, 1)), 1, _max_rows);
+
+    _out.write(wave_magic, sizeof(wave_magic));
+    put(_cols);
+    put(_chunk_rows);
+    put(_block_cols);
+    put(complex);
+    put(vars.size());
+    put_str(title);
+    put(_format);
+    put(_scale);
+
+    for(auto &it : vars) { put_str(it.name); put_str(it.type); }
+
+    _failed = !_out;
+
+    for(auto &it : _buffers) it.resize(_cols * _chunk_rows);
+
+    _packed.resize((_cols + _block_cols - 1) / _block_cols);
+    _sizes.resize(_packed.size());
+    _offsets.resize(_packed.size());
+
+    _thread = std::thread(&wave_writer::Run, this);
+}
+
+/*!
+    @brief      Destructor, finishes the file in case it was not finished.
+*/
+wave_writer::~wave_writer()
+{
+    Finish();
+}
+
+/*!
+    @brief      Copies a point to the chunk buffer, hands the buffer to the thread when it is full.
+    @param      point       The point (one double per column).
+*/
+void wave_writer::Push(const double *point)
+{
+    double *buf = _buffers[_fill].data() + _rows;
+
+    for(size_t col = 0; col < _cols; col++) buf[col * _chunk_rows] = point[col];
+
+    _rows++;
+    _total++;
+
+    if(_rows == _chunk_rows) Flush();
+}
+
+/*!
+    @brief      Hands the chunk buffer filled to the thread and switches to the other one. Waits
+    while the thread is still writing the other buffer.
+*/
+void wave_writer::Flush(void)
+{
+    if(!_rows) return;
+
+    {
+        auto begin = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        _cond.wait(lock, [&]() { return _pending < 0; });
+        _stats.stall_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        _pending = static_cast<int>(_fill);
+        _pending_first = _total - _rows;
+        _pending_rows = _rows;
+    }
+
+    _cond.notify_all();
+    _fill ^= 1;
+    _rows = 0;
+}
+
+/*!
+    @brief      Writes the last chunk and the index, and closes the file.
+    @return     True in case of success, otherwise false (I/O failure).
+*/
+bool wave_writer::Finish(void)
+{
+    if(_finished) return !_failed;
+
+    Flush();
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _done = true;
+    }
+
+    _cond.notify_all();
+    _thread.join();
+
+    /* The index and the footer */
+    auto put = [&](uint64_t val) { _out.write(reinterpret_cast<const char *>(&val), sizeof(val)); };
+    uint64_t index_pos = static_cast<uint64_t>(_out.tellp());
+
+    for(auto &it : _index)
+    {
+        put(it.offset);
+        put(it.first_row);
+        put(it.rows);
+        _out.write(reinterpret_cast<const char *>(&it.t_first), sizeof(double));
+        _out.write(reinterpret_cast<const char *>(&it.t_last), sizeof(double));
+    }
+
+    put(index_pos);
+    put(_index.size());
+    put(_total);
+    _out.write(index_magic, sizeof(index_magic));
+
+    _stats.bytes_in = _total * _cols * sizeof(double);
+    _stats.bytes_out = static_cast<uint64_t>(_out.tellp());
+    _out.close();
+
+    _failed = _failed || !_out;
+    _finished = true;
+
+    return !_failed;
+}
+
+/*!
+    @brief      The I/O thread, compresses and writes the buffers handed until it is done.
+*/
+void wave_writer::Run(void)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while(true)
+    {
+        _cond.wait(lock, [&]() { return _pending >= 0 || _done; });
+        if(_pending < 0) break;
+
+        const auto &buf = _buffers[_pending];
+        uint64_t first = _pending_first, rows = _pending_rows;
+        lock.unlock();
+
+        auto begin = std::chrono::steady_clock::now();
+        WriteChunk(buf, first, rows);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        lock.lock();
+        _stats.write_time += elapsed;
+        _failed = _failed || !_out;
+        _pending = -1;
+        _cond.notify_all();
+    }
+}
+
+/*!
+    @brief      Compresses and writes the chunk of a buffer: the offsets of the blocks of columns (from
+    the start of the chunk), then every block.
+    @param      buf         The buffer, column-major with a leading dimension of _chunk_rows.
+    @param      first_row   The first row of the buffer.
+    @param      rows        Rows of the buffer.
+*/
+void wave_writer::WriteChunk(const std::vector<double> &buf, uint64_t first_row, uint64_t rows)
+{
+    wave_chunk_t entry;
+
+    entry.first_row = first_row;
+    entry.rows = rows;
+    entry.t_first = _scale ? buf[0] : first_row;
+    entry.t_last = _scale ? buf[rows - 1] : first_row + rows - 1;
+
+    /* The blocks are compressed in parallel, then written in order */
+    #pragma omp parallel for schedule(dynamic)
+    for(size_t block = 0; block < _packed.size(); block++)
+    {
+        size_t col = block * _block_cols;
+        size_t ncols = std::min(_block_cols, _cols - col);
+        auto &packed = _packed[block];
+        auto &sizes = _sizes[block];
+
+        packed.clear();
+        sizes.resize(ncols);
+
+        /* A single row has nothing to be predicted from, the bit patterns are stored as they are, without the sizes */
+        if(rows == 1)
+        {
+            sizes.clear();
+
+            for(size_t k = 0; k < ncols; k++)
+            {
+                auto format = (_scale && col + k == 0) ? STORE_DOUBLE : _format;
+                uint64_t bits = sampleBits(buf[(col + k) * _chunk_rows], rowFormat(format), 0, 0);
+                const char *bytes = reinterpret_cast<const char *>(&bits);
+
+                packed.insert(packed.end(), bytes, bytes + rowBytes(format));
+            }
+
+            continue;
+        }
+
+        for(size_t k = 0; k < ncols; k++)
+        {
+            size_t before = packed.size();
+            auto format = (_scale && col + k == 0) ? STORE_DOUBLE : _format;
+            encodeColumn(buf.data() + (col + k) * _chunk_rows, rows, format, packed);
+            sizes[k] = static_cast<uint32_t>(packed.size() - before);
+        }
+
+        /* Few rows, the sizes would weigh as much as the samples, the reader adds up the lengths */
+        if(rows < wave_sized_rows) sizes.clear();
+    }
+
+    uint64_t offset = _offsets.size() * sizeof(uint64_t);
+
+    for(size_t block = 0; block < _packed.size(); block++)
+    {
+        _offsets[block] = offset;
+        offset += _sizes[block].size() * sizeof(uint32_t) + _packed[block].size();
+    }
+
+    entry.offset = static_cast<uint64_t>(_out.tellp());
+    _index.push_back(entry);
+
+    _out.write(reinterpret_cast<const char *>(_offsets.data()), _offsets.size() * sizeof(uint64_t));
+
+    for(size_t block = 0; block < _packed.size(); block++)
+    {
+        _out.write(reinterpret_cast<const char *>(_sizes[block].data()), _sizes[block].size() * sizeof(uint32_t));
+        _out.write(_packed[block].data(), _packed[block].size());
+    }
+}
+
+/*!
+    @brief      Opens a waveform file, reads the header and the index.
+    @param      file        The waveform file.
+    @return     True in case of success, otherwise false (not a waveform file or not finished).
+*/
+bool wave_reader::Open(const std::string &file)
+{
+    auto get = [&]() { uint64_t val = 0; _in.read(reinterpret_cast<char *>(&val), sizeof(val)); return val; };
+    auto get_str = [&]() { std::string str(get(), '\0'); _in.read(&str[0], str.size()); return str; };
+    char magic[8];
+    uint64_t complex, nvars, format, index_pos, chunks;
+
+    _in.open(file, std::ios::binary);
+    _in.read(magic, sizeof(magic));
+    if(!_in || std::memcmp(magic, wave_magic, sizeof(magic))) return false;
+
+    _cols = get();
+    get();                      /* Rows of a chunk, the index has the rows of every chunk */
+    _block_cols = get();
+    complex = get();
+    nvars = get();
+    _title = get_str();
+    format = get();
+    _scale = get() != 0;
+    _complex = complex != 0;
+
+    if(!_in || format > STORE_INT16 || nvars * (_complex ? 2 : 1) != _cols || !_block_cols) return false;
+
+    _format = static_cast<store_format_t>(format);
+    _vars.resize(nvars);
+    for(auto &it : _vars) { it.name = get_str(); it.type = get_str(); }
+
+    /* The footer, the index */
+    _in.seekg(-static_cast<std::streamoff>(3 * sizeof(uint64_t) + sizeof(magic)), std::ios::end);
+    index_pos = get();
+    chunks = get();
+    _rows = get();
+    _in.read(magic, sizeof(magic));
+    if(!_in || std::memcmp(magic, index_magic, sizeof(magic))) return false;
+
+    _in.seekg(index_pos);
+    _index.resize(chunks);
+
+    for(auto &it : _index)
+    {
+        it.offset = get();
+        it.first_row = get();
+        it.rows = get();
+        _in.read(reinterpret_cast<char *>(&it.t_first), sizeof(double));
+        _in.read(reinterpret_cast<char *>(&it.t_last), sizeof(double));
+    }
+
+    return static_cast<bool>(_in);
+}
+
+/*!
+    @brief      Reads a range of rows of a column, only that column of the chunks in the range is
+    read and decompressed.
+    @param      col         The column (variable, or real/imaginary part of a complex variable).
+    @param      vals        The samples of rows [first, last).
+    @param      first       The first row.
+    @param      last        The row after the last (clipped to the rows of the file).
+    @return     True in case of success, otherwise false.
+*/
+bool wave_reader::ReadColumn(size_t col, std::vector<double> &vals, uint64_t first, uint64_t last)
+{
+    uint64_t block = col / _block_cols, pos = col % _block_cols;
+    uint64_t ncols = std::min<uint64_t>(_block_cols, _cols - block * _block_cols);
+    std::vector<uint32_t> sizes(ncols);
+    std::vector<double> chunk;
+
+    vals.clear();
+    if(col >= _cols) return false;
+
+    last = std::min(last, _rows);
+
+    for(auto &it : _index)
+    {
+        if(it.first_row + it.rows <= first || it.first_row >= last) continue;
+
+        /* The offset of the block, from the start of the chunk */
+        uint64_t offset = 0;
+
+        _in.seekg(it.offset + block * sizeof(uint64_t));
+        _in.read(reinterpret_cast<char *>(&offset), sizeof(offset));
+        _in.seekg(it.offset + offset);
+        auto format = (_scale && col == 0) ? STORE_DOUBLE : _format;
+
+        /* A single row chunk has the samples as they are */
+        if(it.rows == 1)
+        {
+            uint64_t skip = 0, bits = 0;
+            for(uint64_t k = 0; k < pos; k++) skip += rowBytes((_scale && block * _block_cols + k == 0) ? STORE_DOUBLE : _format);
+
+            _in.seekg(skip, std::ios::cur);
+            _in.read(reinterpret_cast<char *>(&bits), rowBytes(format));
+            if(!_in) return false;
+
+            if(first <= it.first_row && it.first_row < last) vals.push_back(sampleValue(bits, rowFormat(format), 0, 0));
+            continue;
+        }
+
+        if(it.rows < wave_sized_rows)
+        {
+            /* Few rows, the size of every column from its lengths (two per byte) */
+            uint64_t lens_sz = (it.rows + 1) / 2;
+
+            for(uint64_t k = 0; k <= pos; k++)
+            {
+                auto format_k = (_scale && block * _block_cols + k == 0) ? STORE_DOUBLE : _format;
+                uint64_t prefix = (format_k == STORE_INT16) ? 2 * sizeof(double) : 0, bytes = 0;
+
+                _packed.resize(prefix + lens_sz);
+                _in.read(_packed.data(), _packed.size());
+                if(!_in) return false;
+
+                for(uint64_t i = 0; i < it.rows; i++) bytes += (static_cast<unsigned char>(_packed[prefix + i / 2]) >> (4 * (i & 1))) & 0xF;
+
+                if(k < pos)
+                {
+                    _in.seekg(bytes, std::ios::cur);
+                    continue;
+                }
+
+                _packed.resize(prefix + lens_sz + bytes);
+                _in.read(_packed.data() + prefix + lens_sz, bytes);
+            }
+        }
+        else
+        {
+            _in.read(reinterpret_cast<char *>(sizes.data()), ncols * sizeof(uint32_t));
+
+            uint64_t skip = 0;
+            for(uint64_t k = 0; k < pos; k++) skip += sizes[k];
+
+            _packed.resize(sizes[pos]);
+            _in.seekg(skip, std::ios::cur);
+            _in.read(_packed.data(), _packed.size());
+        }
+
+        chunk.resize(it.rows);
+        if(!_in || !decodeColumn(_packed.data(), _packed.data() + _packed.size(), it.rows, format, chunk.data())) return false;
+
+        uint64_t begin = std::max(first, it.first_row) - it.first_row;
+        uint64_t end = std::min(last, it.first_row + it.rows) - it.first_row;
+        vals.insert(vals.end(), chunk.begin() + begin, chunk.begin() + end);
+    }
+
+    return true;
+}
+
+/*!
+    @brief      Finds the rows of a range of the scale (time/frequency/sweep), through the index
+    and the scale of the chunks at the ends of the range.
+    @param      t_begin     The start of the range.
+    @param      t_end       The end of the range.
+    @param      first       The first row in the range.
+    @param      last        The row after the last row in the range.
+*/
+void wave_reader::RowRange(double t_begin, double t_end, uint64_t &first, uint64_t &last)
+{
+    first = _rows;
+    last = 0;
+
+    for(auto &it : _index)
+    {
+        if(it.t_last < t_begin || it.t_first > t_end) continue;
+        first = std::min(first, it.first_row);
+        last = std::max(last, it.first_row + it.rows);
+    }
+
+    if(first >= last) { first = last = 0; return; }
+
+    /* Exact ends, from the scale of the chunks at the ends */
+    std::vector<double> scale;
+
+    if(ReadColumn(0, scale, first, last))
+    {
+        auto lo = std::find_if(scale.begin(), scale.end(), [&](double t) { return t >= t_begin; });
+        auto hi = std::find_if(lo, scale.end(), [&](double t) { return t > t_end; });
+        last = first + (hi - scale.begin());
+        first += lo - scale.begin();
+    }
+}
@@ -0,0 +1,167 @@
+#ifndef __WAVE_FILE_H
+#define __WAVE_FILE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "raw_writer.hpp"
+#include "simulator_types.hpp"
+
+/** Index entry of a chunk of the waveform file. */
+typedef struct wave_chunk_index
+{
+    uint64_t offset = 0;            //!< File offset of the chunk.
+    uint64_t first_row = 0;         //!< The first row (point) of the chunk.
+    uint64_t rows = 0;              //!< Rows of the chunk.
+    double t_first = 0;             //!< Scale (time/frequency/sweep) of the first row.
+    double t_last = 0;              //!< Scale of the last row.
+} wave_chunk_t;
+
+/** Statistics of the waveform file writer. */
+typedef struct wave_writer_statistics
+{
+    uint64_t bytes_in = 0;          //!< Bytes of the points pushed (uncompressed).
+    uint64_t bytes_out = 0;         //!< Bytes of the file.
+    double write_time = 0;          //!< Time of the thread compressing and writing (s).
+    double stall_time = 0;          //!< Time the simulation waited for a free buffer (s).
+} wave_stats_t;
+
+//! Writer of the chunked, compressed, columnar waveform file (asynchronous).
+/*!
+  The points (rows, every variable is a column, two for complex) are split in chunks of rows,
+  sized so that a chunk (rows x columns) fits in _buffer_bytes, down to a single row. The columns
+  of a chunk are grouped in blocks of _block_cols columns. Every column is compressed on its own:
+  the bit pattern of every sample is stored as the (second order) delta from the previous two,
+  without its zero leading bytes, so a smooth or constant waveform takes a few bytes per sample.
+  The chunk starts with the offset of every block, and the block with the compressed size of every
+  column, therefore a reader decompresses only the columns it needs.\n
+  Very wide rows give chunks of few rows, where the sizes of the columns would weigh as much as
+  the samples: below 16 rows the sizes are left out (the reader adds up the lengths of the columns
+  before the one it needs), and a chunk of a single row has nothing to predict from, its samples
+  are stored as they are (16-bit integers in single precision).\n
+  With a reduced sample format (see store_format_t) the samples are converted before compression,
+  to single precision or to 16-bit integers scaled to the range of the column in the chunk (stored
+  at the start of the column), and the bit patterns of the converted samples are compressed. The
+  scale is always kept in double precision.\n
+  The index of the chunks (offset, rows, scale range, one entry per chunk whatever the columns) is
+  written at the end of the file, so any column or range of rows/time is read without scanning the
+  file.\n
+  The simulation fills a chunk buffer while the previous one is compressed (the blocks of columns
+  in parallel) and written by a background thread (double buffering). When both buffers are full,
+  the simulation waits, the time waited is reported (see Stats()).
+*/
+class wave_writer
+{
+    public:
+        wave_writer(const std::string &file, const std::string &title, const std::vector<raw_var_t> &vars,
+                    bool complex, bool scale, store_format_t format = STORE_DOUBLE);
+        ~wave_writer();
+
+        void Push(const double *point);
+        bool Finish(void);
+
+        /*!
+            @brief      Returns whether the file was opened and all the writes succeeded so far.
+            @return     True in case of success, otherwise false.
+        */
+        bool Valid(void) const noexcept { return !_failed; }
+
+        /*!
+            @brief      Returns the statistics of the writer, final after Finish().
+            @return     The statistics.
+        */
+        const wave_stats_t &Stats(void) const noexcept { return _stats; }
+
+    private:
+        void Flush(void);
+        void Run(void);
+        void WriteChunk(const std::vector<double> &buf, uint64_t first_row, uint64_t rows);
+
+        static constexpr size_t _buffer_bytes = 32 * 1024 * 1024;  //!< Size of a chunk buffer (exceeded only by a single row).
+        static constexpr size_t _max_rows = 4096;                   //!< Maximum rows of a chunk.
+        static constexpr size_t _block_cols = 1024;                 //!< Columns of a block.
+
+        std::ofstream _out;                 //!< The waveform file.
+        size_t _cols;                       //!< Columns of a row.
+        size_t _chunk_rows;                 //!< Rows of a chunk.
+        bool _scale;                        //!< The first column is the scale (time/frequency/sweep).
+        store_format_t _format;             //!< The format of the samples (except for the scale).
+        bool _failed = false;               //!< Open or write failure.
+        bool _finished = false;             //!< The writer is finished (file closed).
+        std::vector<wave_chunk_t> _index;   //!< The index of the chunks written.
+        std::vector<uint64_t> _offsets;     //!< Workspace of the offsets of the blocks of a chunk.
+        std::vector<std::vector<char>> _packed;         //!< Workspace of the compressed columns, per block.
+        std::vector<std::vector<uint32_t>> _sizes;      //!< Workspace of the compressed sizes of the columns, per block.
+        wave_stats_t _stats;                //!< Statistics.
+
+        /* Double buffering, the simulation fills one buffer (column-major) and the thread writes the other */
+        std::vector<double> _buffers[2];    //!< The chunk buffers.
+        size_t _fill = 0;                   //!< The buffer filled by the simulation.
+        size_t _rows = 0;                   //!< Rows in the buffer filled.
+        uint64_t _total = 0;                //!< Rows pushed.
+        int _pending = -1;                  //!< The buffer handed to the thread (-1 for none).
+        uint64_t _pending_first = 0;        //!< The first row of the buffer handed.
+        uint64_t _pending_rows = 0;         //!< Rows of the buffer handed.
+        bool _done = false;                 //!< No more chunks, the thread exits.
+        std::mutex _mutex;                  //!< Protects the hand-over.
+        std::condition_variable _cond;      //!< Signals the hand-over (both ways).
+        std::thread _thread;                //!< The background compression/I/O thread.
+};
+
+//! Reader of the waveform file, with random access to any column and range of rows or time.
+class wave_reader
+{
+    public:
+        bool Open(const std::string &file);
+        bool ReadColumn(size_t col, std::vector<double> &vals, uint64_t first = 0, uint64_t last = UINT64_MAX);
+        void RowRange(double t_begin, double t_end, uint64_t &first, uint64_t &last);
+
+        /*!
+            @brief      Returns the variables of the file, the scale first (except for OP).
+            @return     The variables.
+        */
+        const std::vector<raw_var_t> &Variables(void) const noexcept { return _vars; }
+
+        /*!
+            @brief      Returns whether the variables are complex (two columns each, real and imaginary).
+            @return     True for complex, otherwise false.
+        */
+        bool Complex(void) const noexcept { return _complex; }
+
+        /*!
+            @brief      Returns the format of the samples (the scale is in double precision).
+            @return     The format.
+        */
+        store_format_t Format(void) const noexcept { return _format; }
+
+        /*!
+            @brief      Returns the number of rows (points).
+            @return     The rows.
+        */
+        uint64_t Rows(void) const noexcept { return _rows; }
+
+        /*!
+            @brief      Returns the number of columns of a row.
+            @return     The columns.
+        */
+        size_t Columns(void) const noexcept { return _cols; }
+
+    private:
+        std::ifstream _in;                  //!< The waveform file.
+        std::string _title;                 //!< The title.
+        std::vector<raw_var_t> _vars;       //!< The variables.
+        bool _complex = false;              //!< Complex variables.
+        bool _scale = false;                //!< The first column is the scale (time/frequency/sweep).
+        store_format_t _format = STORE_DOUBLE;  //!< The format of the samples (except for the scale).
+        size_t _cols = 0;                   //!< Columns of a row.
+        uint64_t _rows = 0;                 //!< Rows of the file.
+        uint64_t _block_cols = 0;           //!< Columns of a block.
+        std::vector<wave_chunk_t> _index;   //!< The index of the chunks.
+        std::vector<char> _packed;          //!< Workspace of a compressed column.
+};
+
+#endif // __WAVE_FILE_H //
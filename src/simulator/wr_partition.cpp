@@ -0,0 +1,140 @@
+#include "wr_partition.hpp"
+
+/*!
+    @brief      Extracts the matrices of the partition from the whole system and factorizes
+    the left hand matrix. Every unknown is either in the partition (local index) or in another one,
+    where it is a boundary unknown (boundary index) of the partition.
+    @param      lhs_mat     The left hand matrix of the whole system (G + a*C).
+    @param      rh_mat      The right hand matrix of the whole system (a*C or a*C - G).
+    @param      part        The partition of every unknown.
+    @param      local       The index of every unknown inside its partition.
+    @param      bnd         The boundary index of every unknown (-1 when it is not a boundary one).
+    @param      mna         The MNA engine (sources and plot indices).
+    @param      x0          The initial solution of the whole system (OP).
+    @param      type        The linear solver of the partition.
+    @param      spd         Whether the system is symmetric positive definite.
+    @return     True in case of success, otherwise false (factorization failure).
+*/
+bool wr_partition::Build(const SparMatRowD &lhs_mat, const SparMatRowD &rh_mat, const std::vector<IntTp> &part,
+                         const std::vector<IntTp> &local, const std::vector<IntTp> &bnd, MNA &mna, const DensVecD &x0,
+                         solver_t type, bool spd)
+{
+    IntTp dim = _vars.size();
+    IntTp id = part[_vars.front()];
+    IntTp bnd_dim = 0;
+    tripletList_d lhs_trip, rh_trip, lhs_bnd_trip, rh_bnd_trip;
+
+    for(auto it : bnd) bnd_dim = std::max(bnd_dim, it + 1);
+
+    /* Rows of the partition, split in the partition and boundary columns */
+    auto extract = [&](const SparMatRowD &mat, tripletList_d &inner, tripletList_d &outer)
+    {
+        for(IntTp row = 0; row < dim; row++)
+        {
+            for(SparMatRowD::InnerIterator it(mat, _vars[row]); it; ++it)
+            {
+                if(part[it.col()] == id) inner.push_back(triplet_eig_d(row, local[it.col()], it.value()));
+                else outer.push_back(triplet_eig_d(row, bnd[it.col()], it.value()));
+            }
+        }
+    };
+
+    extract(lhs_mat, lhs_trip, lhs_bnd_trip);
+    extract(rh_mat, rh_trip, rh_bnd_trip);
+
+    _lhs_mat.resize(dim, dim);
+    _lhs_mat.setFromTriplets(lhs_trip.begin(), lhs_trip.end());
+    _rh_mat.resize(dim, dim);
+    _rh_mat.setFromTriplets(rh_trip.begin(), rh_trip.end());
+    _lhs_bnd.resize(dim, bnd_dim);
+    _lhs_bnd.setFromTriplets(lhs_bnd_trip.begin(), lhs_bnd_trip.end());
+    _rh_bnd.resize(dim, bnd_dim);
+    _rh_bnd.setFromTriplets(rh_bnd_trip.begin(), rh_bnd_trip.end());
+
+    /* Own unknowns that are boundary of other partitions */
+    for(IntTp row = 0; row < dim; row++)
+    {
+        if(bnd[_vars[row]] != -1) _bnd_own.push_back({row, bnd[_vars[row]]});
+    }
+
+    /* Transient sources, all the rows are reset after every evaluation */
+    mna.CreateTRANSourceRows(_source_rows);
+    for(auto row : _source_rows)
+    {
+        if(part[row] == id) _sources.push_back({local[row], row});
+    }
+
+    /* Results */
+    auto &nodes_idx = mna.NodesIdx();
+    auto &sources_idx = mna.SourceIdx();
+
+    for(size_t k = 0; k < nodes_idx.size(); k++)
+    {
+        if(part[nodes_idx[k]] == id) _plot_nodes.push_back({local[nodes_idx[k]], k});
+    }
+
+    for(size_t k = 0; k < sources_idx.size(); k++)
+    {
+        if(part[sources_idx[k]] == id) _plot_sources.push_back({local[sources_idx[k]], k});
+    }
+
+    /* Initial solution and workspaces */
+    _x0.resize(dim);
+    for(IntTp row = 0; row < dim; row++) _x0[row] = x0[_vars[row]];
+
+    _x.resize(dim);
+    _rh.resize(dim);
+    _full.setZero(x0.size());
+
+    _solver = CreateLinearSolver<SparMatD>(type, spd);
+
+    return _solver->factor(_lhs_mat);
+}
+
+/*!
+    @brief      Solves the whole transient of the partition (fixed timestep), with the waveforms of the
+    boundary unknowns of the previous iteration. The waveforms of the own boundary unknowns and the
+    results of the plotted unknowns are written for every timepoint except the first (OP).
+    @param      mna         The MNA engine (sources and timepoints).
+    @param      trap        Trapezoidal method (sources at both ends of the step), otherwise Euler.
+    @param      wave_old    The waveforms of the boundary unknowns, previous iteration (one column per timepoint).
+    @param      wave_new    The waveforms of the boundary unknowns, current iteration.
+    @param      res_nodes   The results of the nodes (rows reserved).
+    @param      res_sources The results of the sources (rows reserved).
+    @return     True in case of success, otherwise false (solver failure).
+*/
+bool wr_partition::Sweep(MNA &mna, bool trap, const DenseMatD &wave_old, DenseMatD &wave_new,
+                         result_store<double> &res_nodes, result_store<double> &res_sources)
+{
+    auto &sim_vector = mna.SimVals();
+    bool coupled = (_lhs_bnd.nonZeros() + _rh_bnd.nonZeros()) > 0;
+
+    _x = _x0;
+
+    for(size_t i = 1; i < sim_vector.size(); i++)
+    {
+        /* Own history and the boundary waveforms */
+        _rh.noalias() = _rh_mat * _x;
+
+        if(coupled)
+        {
+            _rh.noalias() += _rh_bnd * wave_old.col(i - 1);
+            _rh.noalias() -= _lhs_bnd * wave_old.col(i);
+        }
+
+        /* Sources, evaluated on the whole system and reset */
+        mna.UpdateTRANVec(_full, sim_vector[i]);
+        if(trap) mna.UpdateTRANVec(_full, sim_vector[i - 1]);
+
+        for(auto &it : _sources) _rh[it.first] += _full[it.second];
+        for(auto row : _source_rows) _full[row] = 0;
+
+        if(!_solver->solve(_rh, _x)) return false;
+
+        for(auto &it : _bnd_own) wave_new(it.second, i) = _x[it.first];
+        for(auto &it : _plot_nodes) res_nodes(i, it.second) = _x[it.first];
+        for(auto &it : _plot_sources) res_sources(i, it.second) = _x[it.first];
+    }
+
+    return true;
+}
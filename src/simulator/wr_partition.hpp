@@ -0,0 +1,66 @@
+#ifndef __WR_PARTITION_H
+#define __WR_PARTITION_H
+
+#include "mna.hpp"
+#include "linear_solver.hpp"
+#include "result_store.hpp"
+
+//! A partition of the circuit for the waveform relaxation transient.
+/*!
+  The unknowns of the transient system are split in partitions (see MNA::CreateTRANPartitions).
+  For the fixed timestep methods every step solves (G + a*C)*x(k) = R*x(k-1) + e, therefore the rows
+  of a partition p are:\n
+  L_pp*x_p(k) = R_pp*x_p(k-1) + e_p - L_pb*w(k) + R_pb*w(k-1)\n
+  where w are the boundary unknowns, the unknowns of the other partitions that appear in the rows of
+  p. The partition solves its whole transient from the waveforms of the boundary unknowns of the previous
+  iteration, with its own (small) factorization of L_pp, and returns the waveforms of its own boundary
+  unknowns. Different partitions can be solved in parallel.
+*/
+class wr_partition
+{
+    public:
+        /*!
+            @brief      Constructor.
+            @param      vars    The unknowns of the partition (global indices).
+        */
+        wr_partition(std::vector<IntTp> &&vars) noexcept : _vars(std::move(vars)) {}
+
+        bool Build(const SparMatRowD &lhs_mat, const SparMatRowD &rh_mat, const std::vector<IntTp> &part,
+                   const std::vector<IntTp> &local, const std::vector<IntTp> &bnd, MNA &mna, const DensVecD &x0,
+                   solver_t type, bool spd);
+        bool Sweep(MNA &mna, bool trap, const DenseMatD &wave_old, DenseMatD &wave_new,
+                   result_store<double> &res_nodes, result_store<double> &res_sources);
+
+        /*!
+            @brief      Returns the number of unknowns of the partition.
+            @return     The dimension.
+        */
+        IntTp Dim(void) const noexcept { return _vars.size(); }
+
+        /*!
+            @brief      Returns the statistics of the solver of the partition.
+            @return     The statistics.
+        */
+        const solver_stats_t &Stats(void) const noexcept { return _solver->Stats(); }
+
+    private:
+        typedef std::pair<IntTp, IntTp> idx_pair_t;     //!< Local index of an unknown, and its index elsewhere.
+
+        std::vector<IntTp> _vars;                       //!< The unknowns of the partition (global indices).
+        std::vector<IntTp> _source_rows;                //!< The rows of all the transient sources (global indices).
+        std::vector<idx_pair_t> _sources;               //!< The rows with transient sources (local, global).
+        std::vector<idx_pair_t> _bnd_own;               //!< The boundary unknowns of the partition (local, boundary).
+        std::vector<idx_pair_t> _plot_nodes;            //!< The nodes to plot (local, results column).
+        std::vector<idx_pair_t> _plot_sources;          //!< The sources to plot (local, results column).
+        SparMatD _lhs_mat;                              //!< The left hand matrix of the partition (L_pp).
+        SparMatD _rh_mat;                               //!< The right hand matrix of the partition (R_pp).
+        SparMatD _lhs_bnd;                              //!< The coupling to the boundary unknowns (L_pb).
+        SparMatD _rh_bnd;                               //!< The coupling to the boundary unknowns (R_pb).
+        std::unique_ptr<linear_solver<SparMatD>> _solver;   //!< The factorization of L_pp.
+        DensVecD _x0;                                   //!< The initial solution (OP).
+        DensVecD _x;                                    //!< Workspace of the solution.
+        DensVecD _rh;                                   //!< Workspace of the right hand side.
+        DensVecD _full;                                 //!< Workspace of the sources (whole system).
+};
+
+#endif // __WR_PARTITION_H //
@@ -1,6 +1,9 @@
 #ifndef __SIMULATOR_TYPES_H
 #define __SIMULATOR_TYPES_H
 
+#include <string>
+#include "base_types.hpp"
+
 /** Enumeration containing all the error codes used in the program. */
 typedef enum return_enum_codes
 {
@@ -28,6 +31,10 @@ typedef enum return_enum_codes
 	FAIL_SIMULATOR_SOLVE = 17,                      //!< Failure during the simulator's solve step.
 	FAIL_PLOTTER_IO_OPERATIONS = 21,                //!< Failure during plotter's IO operation (pipe/file).
     FAIL_SIMULATOR_FALLTHROUTH_ODE_OPTION = 23,     //!< Unknown ODE option (debug only).
+    FAIL_SIMULATOR_TIMESTEP_TOO_SMALL = 24,         //!< Adaptive timestep below the minimum (truncation error not met).
+    FAIL_SIMULATOR_RESTART = 25,                    //!< No valid checkpoint to restart the transient from (or SAVE ALL).
+    FAIL_SIMULATOR_INITIAL_STATE = 26,              //!< Initial state file (x(0)) missing, invalid or not writable.
+    FAIL_SIMULATOR_OUTPUT = 27,                     //!< Failure writing the output files (rawfile, waveform file, measurements).
 } return_codes_e;
 
 /** Enumeration containing all the SPICE cards supported by the simulator. */
@@ -63,8 +70,116 @@ typedef enum ODE_methods
     BACKWARDS_EULER = 0,    //!< Backwards Euler differentiation method.
     TRAPEZOIDAL,            //!< Trapezoidal differentiation method.
     GEAR2,                  //!< Gear 2 differentiation method.
+    BDF,                    //!< Variable order (1-6) BDF differentiation method, with adaptive timestep.
+    EXPINT,                 //!< Exponential integrator (Krylov matrix exponential), steps between the source breakpoints.
 } ODE_meth_t;
 
+/** Enumeration for the different linear solvers. */
+typedef enum linear_solver_types
+{
+    SOLVER_AUTO = 0,        //!< Picked by the simulator, based on the system structure.
+    SOLVER_KLU,             //!< KLU direct solver (needs BSPICE_EIGEN_USE_KLU).
+    SOLVER_SPARSELU,        //!< Eigen SparseLU direct solver.
+    SOLVER_CHOLESKY,        //!< Eigen simplicial Cholesky (LLT), SPD systems only.
+    SOLVER_BICGSTAB,        //!< Eigen BiCGSTAB iterative solver (ILUT preconditioner).
+    SOLVER_CG,              //!< Eigen Conjugate Gradient iterative solver (IC preconditioner), SPD systems only.
+    SOLVER_BTF,             //!< Block triangular form, with the diagonal blocks solved in parallel (needs BSPICE_EIGEN_USE_KLU, SuiteSparse).
+    SOLVER_MIXED,           //!< Reduced precision LU with iterative refinement (falls back to full precision LU).
+} solver_t;
+
+/** Enumeration for the different downsampling methods of the plots (display only). */
+typedef enum downsample_methods
+{
+    DOWNSAMPLE_NONE = 0,    //!< Every point is plotted.
+    DOWNSAMPLE_MINMAX,      //!< First, last, minimum and maximum of every trace per bucket of the x axis.
+    DOWNSAMPLE_LTTB,        //!< Largest-Triangle-Three-Buckets, a point of every trace per bucket.
+} downsample_t;
+
+/** Enumeration for the different sample formats of the stored results (plotted unknowns). */
+typedef enum store_formats
+{
+    STORE_DOUBLE = 0,       //!< Double precision, exact.
+    STORE_FLOAT,            //!< Single precision (half the memory).
+    STORE_INT16,            //!< 16-bit integers scaled to the range of every column per chunk of rows (a quarter of the memory).
+} store_format_t;
+
+/** Enumeration for the different measurements (MEASURE card). */
+typedef enum measure_types
+{
+    MEAS_TRIG_TARG = 0,     //!< Distance between two crossings (e.g. delay, rise time).
+    MEAS_WHEN,              //!< Point of a crossing.
+    MEAS_AVG,               //!< Average over a range.
+    MEAS_RMS,               //!< Root mean square over a range.
+    MEAS_MIN,               //!< Minimum over a range.
+    MEAS_MAX,               //!< Maximum over a range.
+    MEAS_PP,                //!< Peak to peak over a range.
+    MEAS_INTEG,             //!< Integral over a range.
+} measure_t;
+
+/** Enumeration for the part of a (complex) signal used by a measurement. */
+typedef enum measure_signal_parts
+{
+    MEAS_DEFAULT = 0,       //!< The value (real analyses), the magnitude (AC).
+    MEAS_REAL,              //!< Real part (VR/IR).
+    MEAS_IMAG,              //!< Imaginary part (VI/II).
+    MEAS_MAG,               //!< Magnitude (VM/IM).
+    MEAS_PHASE,             //!< Phase in degrees (VP/IP).
+    MEAS_DB,                //!< Magnitude in dB (VDB/IDB).
+} meas_part_t;
+
+/** A signal of a measurement, a node voltage or a source current. */
+typedef struct measure_signal
+{
+    std::string name;               //!< The node or the element.
+    bool current = false;           //!< Current of the element, otherwise node voltage.
+    meas_part_t part = MEAS_DEFAULT;    //!< The part of the signal.
+} meas_signal_t;
+
+/** A crossing of a measurement (TRIG/TARG/WHEN), the signal crossing a value or a fixed point (AT). */
+typedef struct measure_crossing
+{
+    meas_signal_t sig;              //!< The signal.
+    double val = 0;                 //!< The value crossed, or the point for AT.
+    bool at = false;                //!< Fixed point (AT), no signal.
+    int edge = 0;                   //!< Rising (1), falling (-1) or any (0) crossing.
+    int count = 1;                  //!< The crossing counted (RISE/FALL/CROSS = count).
+    double td = 0;                  //!< Crossings before this point are ignored (TD).
+} meas_cross_t;
+
+/** A measurement (MEASURE card). */
+typedef struct measure_specification
+{
+    std::string name;               //!< The name.
+    analysis_t analysis = TRAN;     //!< The analysis of the measurement (TRAN/AC/DC).
+    measure_t type = MEAS_AVG;      //!< The measurement.
+    meas_signal_t sig;              //!< The signal (AVG/RMS/MIN/MAX/PP/INTEG).
+    double from = -1e300;           //!< The start of the range (FROM).
+    double to = 1e300;              //!< The end of the range (TO).
+    meas_cross_t trig;              //!< The trigger (TRIG) or the crossing (WHEN).
+    meas_cross_t targ;              //!< The target (TARG).
+} measure_spec_t;
+
+/** The simulator options (OPTIONS card), with their defaults. */
+typedef struct simulator_options
+{
+    ODE_meth_t ode_method = BACKWARDS_EULER;    //!< ODE method of the transient.
+    IntTp max_order = 6;                        //!< Maximum order of the variable order BDF method (MAXORD).
+    solver_t solver = SOLVER_AUTO;              //!< Linear solver of the analysis (SOLVER).
+    bool lu_stats = false;                      //!< The LU factorization is measured once, to compare with Cholesky (LUSTATS).
+    bool adaptive = false;                      //!< Transient timestep adapted to the truncation error, otherwise fixed (ADAPTIVE).
+    double reltol = 1e-3;                       //!< Relative tolerance of the transient truncation error (RELTOL).
+    double abstol = 1e-6;                       //!< Absolute tolerance of the transient truncation error (ABSTOL).
+    double max_step = 0;                        //!< Maximum adaptive timestep (TMAX, 0 for 1/50 of the span).
+    double cache_mem = 256;                     //!< Memory budget of the transient factorization cache (CACHEMEM, MB).
+    bool relaxation = false;                    //!< Transient solved with waveform relaxation on circuit partitions (WR).
+    IntTp partitions = 0;                       //!< Number of waveform relaxation partitions (WR=<n>, 0 for one per thread).
+    double ckpt_interval = 0;                   //!< Wall clock interval of the transient checkpoints (CHECKPOINT, s, 0 for none).
+    bool uic = false;                           //!< Transient starts from the initial conditions, without the OP (UIC).
+    downsample_t downsample = DOWNSAMPLE_MINMAX;    //!< Downsampling method of the plots (DOWNSAMPLE).
+    IntTp plot_points = 2000;                   //!< Buckets of the x axis of the downsampled plots (PLOTPOINTS).
+    store_format_t store_format = STORE_DOUBLE; //!< Sample format of the stored results (STORE).
+} sim_options_t;
+
 /* TODO - More C++ way of defining it */
 #define TRANSIENT_SOURCE_TYPENUM 5
 
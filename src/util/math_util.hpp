@@ -22,6 +22,9 @@ void StepVecGen(std::vector<T> &vec, T start, T end, T step)
 	/* Avoid infinite loops */
 	if(step == 0) return;
 
+	/* Allocated once, the points can be millions (transient) */
+	if(step > 0 && start <= end) vec.reserve(vec.size() + static_cast<size_t>((end - start) / step) + 2);
+
 	/* Incrementally add */
 	while(start <= end)
 	{
@@ -497,6 +497,174 @@ return_codes_e parser::parsePLOTCard(const std::vector<std::string> &tokens,
 	return RETURN_SUCCESS;
 }
 
+/*!
+	@brief  Function verifies the syntaxes for an initial conditions spice card (.IC):
+            => .IC  V(nodename1)=value1 ... V(nodenameN)=valueN
+	Along with this, it returns the initial node voltages of the transient. Since the tokenization
+	eliminates the parentheses, the tokens are {V nodename =value}, {V nodename = value} or {V nodename value}.
+	@param      tokens      The tokens that form the card.
+	@param      ic_nodes    The names of the nodes.
+	@param      ic_vals     The initial voltages of the nodes.
+	@return     RETURN_SUCCESS or appropriate failure code.
+*/
+return_codes_e parser::parseICCard(const std::vector<std::string> &tokens,
+                                   std::vector<std::string> &ic_nodes,
+                                   std::vector<double> &ic_vals)
+{
+	size_t idx = 1;
+
+	if(tokens.size() < 4) return FAIL_PARSER_INVALID_FORMAT;
+
+	while(idx < tokens.size())
+	{
+		/* Node, no need to check if it exists - This is taken care from the caller */
+		if(tokens[idx] != "V" || idx + 2 >= tokens.size()) return FAIL_PARSER_INVALID_FORMAT;
+
+		std::string node = tokens[idx + 1];
+		std::string value = tokens[idx + 2];
+		idx += 3;
+
+		/* Value, with the equal sign attached or separate */
+		if(value == "=")
+		{
+			if(idx >= tokens.size()) return FAIL_PARSER_INVALID_FORMAT;
+			value = tokens[idx++];
+		}
+		else if(value[0] == '=')
+		{
+			value = value.substr(1);
+		}
+
+		if(!IsValidFpValue(value)) return FAIL_PARSER_INVALID_FORMAT;
+
+		ic_nodes.push_back(node);
+		ic_vals.push_back(resolveFloatNum(value));
+	}
+
+	return RETURN_SUCCESS;
+}
+
+/*!
+	@brief  Function verifies the syntax for a save spice card (.SAVE), only the save all form is
+	supported (the plotted nodes/sources are given by the .PLOT/.PRINT cards):
+            => .SAVE ALL or .SAVE * or .SAVE V(*)
+	@param      tokens      The tokens that form the card.
+	@param      save_all    Save all the unknowns of the simulation.
+	@return     RETURN_SUCCESS or appropriate failure code.
+*/
+return_codes_e parser::parseSAVECard(const std::vector<std::string> &tokens, bool &save_all)
+{
+	bool all = (tokens.size() == 2 && (tokens[1] == "ALL" || tokens[1] == "*"));
+	bool wildcard = (tokens.size() == 3 && tokens[1] == "V" && tokens[2] == "*");
+
+	if(!all && !wildcard) return FAIL_PARSER_INVALID_FORMAT;
+
+	save_all = true;
+
+	return RETURN_SUCCESS;
+}
+
+/*!
+	@brief  Function verifies the syntax for a measurement spice card (.MEASURE or .MEAS):
+            => .MEAS <TRAN|AC|DC> name TRIG <crossing> TARG <crossing>
+            => .MEAS <TRAN|AC|DC> name WHEN V(node)=value [RISE|FALL|CROSS=count] [TD=value]
+            => .MEAS <TRAN|AC|DC> name <AVG|RMS|MIN|MAX|PP|INTEG> V(node) [FROM=value] [TO=value]
+	where a crossing is V(node) VAL=value [RISE|FALL|CROSS=count] [TD=value] or AT=value. The signals
+	are node voltages V(node) or source currents I(source), with VR/VI/VM/VP/VDB (and the I forms)
+	for a part of a complex (AC) signal.
+	@param      tokens      The tokens that form the card.
+	@param      spec        The measurement.
+	@return     RETURN_SUCCESS or appropriate failure code.
+*/
+return_codes_e parser::parseMEASCard(const std::vector<std::string> &tokens, measure_spec_t &spec)
+{
+	std::vector<std::string> tk;
+	size_t pos = 4;
+
+	/* The assignments are split, {KEY=VALUE}, {KEY =VALUE} and {KEY = VALUE} all become {KEY, =, VALUE} */
+	for(auto &it : tokens)
+	{
+		size_t start = 0, eq;
+
+		while((eq = it.find('=', start)) != std::string::npos)
+		{
+			if(eq > start) tk.push_back(it.substr(start, eq - start));
+			tk.push_back("=");
+			start = eq + 1;
+		}
+
+		if(start < it.size()) tk.push_back(it.substr(start));
+	}
+
+	if(tk.size() < 5 || !IsValidName(tk[2])) return FAIL_PARSER_INVALID_FORMAT;
+
+	if(tk[1] == "TRAN") spec.analysis = TRAN;
+	else if(tk[1] == "AC") spec.analysis = AC;
+	else if(tk[1] == "DC") spec.analysis = DC;
+	else return FAIL_PARSER_INVALID_FORMAT;
+
+	spec.name = tk[2];
+
+	if(tk[3] == "TRIG")
+	{
+		spec.type = MEAS_TRIG_TARG;
+
+		if(!parseMeasCrossing(tk, pos, spec.trig, false)) return FAIL_PARSER_INVALID_FORMAT;
+		if(pos >= tk.size() || tk[pos++] != "TARG") return FAIL_PARSER_INVALID_FORMAT;
+		if(!parseMeasCrossing(tk, pos, spec.targ, false)) return FAIL_PARSER_INVALID_FORMAT;
+	}
+	else if(tk[3] == "WHEN")
+	{
+		spec.type = MEAS_WHEN;
+
+		if(!parseMeasCrossing(tk, pos, spec.trig, true)) return FAIL_PARSER_INVALID_FORMAT;
+	}
+	else
+	{
+		if(tk[3] == "AVG") spec.type = MEAS_AVG;
+		else if(tk[3] == "RMS") spec.type = MEAS_RMS;
+		else if(tk[3] == "MIN") spec.type = MEAS_MIN;
+		else if(tk[3] == "MAX") spec.type = MEAS_MAX;
+		else if(tk[3] == "PP") spec.type = MEAS_PP;
+		else if(tk[3] == "INTEG" || tk[3] == "INTEGRAL") spec.type = MEAS_INTEG;
+		else return FAIL_PARSER_INVALID_FORMAT;
+
+		if(!parseMeasSignal(tk, pos, spec.sig)) return FAIL_PARSER_INVALID_FORMAT;
+
+		/* The range, optional */
+		while(pos < tk.size())
+		{
+			const std::string &key = tk[pos];
+
+			if(key == "FROM" && parseMeasValue(tk, pos, spec.from)) continue;
+			if(key == "TO" && parseMeasValue(tk, pos, spec.to)) continue;
+
+			return FAIL_PARSER_INVALID_FORMAT;
+		}
+
+		if(spec.from >= spec.to) return FAIL_PARSER_ANALYSIS_INVALID_ARGS;
+	}
+
+	return (pos == tk.size()) ? RETURN_SUCCESS : FAIL_PARSER_INVALID_FORMAT;
+}
+
+/*!
+	@brief  Function verifies the syntax of a numeric option value of the OPTIONS spice card
+	(<OPTION>=<VALUE>) and returns it. The value must be positive.
+	@param      token   The value token.
+	@param      val     The value.
+	@return     RETURN_SUCCESS or appropriate failure code.
+*/
+return_codes_e parser::parseOptionValue(const std::string &token, double &val)
+{
+    if(!IsValidFpValue(token)) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+
+    val = resolveFloatNum(token);
+    if(!(val > 0)) return FAIL_PARSER_UKNOWN_OPTION_OR_REPETITION;
+
+    return RETURN_SUCCESS;
+}
+
 
 
 /*!
@@ -645,3 +813,105 @@ bool parser::IsValidIntValue(const std::string &token)
 {
     return std::regex_match(token, _integer_number);
 }
+
+/*!
+    @brief      Internal function that parses the signal of a measurement, {V node} or {I source}
+    (the parentheses are eliminated by the tokenization), or one of the part forms (VR, VI, VM, VP, VDB).
+    @param      tokens      The tokens of the card.
+    @param      pos         The position of the signal, moved after it.
+    @param      sig         The signal.
+    @return     Valid(true) syntax or not(false).
+*/
+bool parser::parseMeasSignal(const std::vector<std::string> &tokens, size_t &pos, meas_signal_t &sig)
+{
+    if(pos + 1 >= tokens.size()) return false;
+
+    const std::string &type = tokens[pos];
+    std::string part = type.substr(1);
+
+    if(type[0] != 'V' && type[0] != 'I') return false;
+    if(!IsValidNode(tokens[pos + 1])) return false;
+
+    if(part.empty()) sig.part = MEAS_DEFAULT;
+    else if(part == "R") sig.part = MEAS_REAL;
+    else if(part == "I") sig.part = MEAS_IMAG;
+    else if(part == "M") sig.part = MEAS_MAG;
+    else if(part == "P") sig.part = MEAS_PHASE;
+    else if(part == "DB") sig.part = MEAS_DB;
+    else return false;
+
+    sig.current = (type[0] == 'I');
+    sig.name = tokens[pos + 1];
+    pos += 2;
+
+    return true;
+}
+
+/*!
+    @brief      Internal function that parses a crossing of a measurement, {signal VAL = value} for
+    TRIG/TARG, {signal = value} for WHEN, followed by the optional {RISE|FALL|CROSS = count} and
+    {TD = value}. A TRIG/TARG can also be a fixed point, {AT = value}.
+    @param      tokens      The tokens of the card (assignments split).
+    @param      pos         The position of the crossing, moved after it.
+    @param      cross       The crossing.
+    @param      when        WHEN crossing, otherwise TRIG/TARG.
+    @return     Valid(true) syntax or not(false).
+*/
+bool parser::parseMeasCrossing(const std::vector<std::string> &tokens, size_t &pos, meas_cross_t &cross, bool when)
+{
+    if(!when && pos < tokens.size() && tokens[pos] == "AT")
+    {
+        cross.at = true;
+        return parseMeasValue(tokens, pos, cross.val);
+    }
+
+    if(!parseMeasSignal(tokens, pos, cross.sig)) return false;
+
+    /* The value, {= value} for WHEN (the node/source is the key), {VAL = value} for TRIG/TARG */
+    if(when) pos--;
+    else if(pos >= tokens.size() || tokens[pos] != "VAL") return false;
+
+    if(!parseMeasValue(tokens, pos, cross.val)) return false;
+
+    /* The options, up to the next part of the card */
+    while(pos < tokens.size())
+    {
+        const std::string &key = tokens[pos];
+        double val;
+
+        if(key == "TD")
+        {
+            if(!parseMeasValue(tokens, pos, cross.td)) return false;
+        }
+        else if(key == "RISE" || key == "FALL" || key == "CROSS")
+        {
+            if(pos + 2 >= tokens.size() || !IsValidIntValue(tokens[pos + 2]) || !parseMeasValue(tokens, pos, val) || val < 1) return false;
+
+            cross.edge = (key == "RISE") ? 1 : ((key == "FALL") ? -1 : 0);
+            cross.count = static_cast<int>(val);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return true;
+}
+
+/*!
+    @brief      Internal function that parses an assignment of a measurement, {KEY = value}.
+    @param      tokens      The tokens of the card (assignments split).
+    @param      pos         The position of the key, moved after the value.
+    @param      val         The value.
+    @return     Valid(true) syntax or not(false).
+*/
+bool parser::parseMeasValue(const std::vector<std::string> &tokens, size_t &pos, double &val)
+{
+    if(pos + 2 >= tokens.size() || tokens[pos + 1] != "=" || !IsValidFpValue(tokens[pos + 2])) return false;
+
+    val = resolveFloatNum(tokens[pos + 2]);
+    pos += 3;
+
+    return true;
+}
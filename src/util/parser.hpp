@@ -64,6 +64,17 @@ class parser
 		                             std::vector<std::string> &plot_nodes,
 		                             std::vector<std::string> &plot_sources);
 
+		return_codes_e parseICCard(const std::vector<std::string> &tokens,
+		                           std::vector<std::string> &ic_nodes,
+		                           std::vector<double> &ic_vals);
+
+		return_codes_e parseSAVECard(const std::vector<std::string> &tokens, bool &save_all);
+
+		return_codes_e parseMEASCard(const std::vector<std::string> &tokens, measure_spec_t &spec);
+
+		/* Spice options */
+		return_codes_e parseOptionValue(const std::string &token, double &val);
+
     private:
 		/* Grammar methods for components */
 		IntTp resolveNodeID(hashmap_str_t &nodes, const std::string &node);
@@ -76,6 +87,11 @@ class parser
         bool IsValidFpValue(const std::string &token);
         bool IsValidIntValue(const std::string &token);
 
+        /* Methods for the MEASURE card */
+        bool parseMeasSignal(const std::vector<std::string> &tokens, size_t &pos, meas_signal_t &sig);
+        bool parseMeasCrossing(const std::vector<std::string> &tokens, size_t &pos, meas_cross_t &cross, bool when);
+        bool parseMeasValue(const std::vector<std::string> &tokens, size_t &pos, double &val);
+
         /* Methods for Spice Elements */
         bool isValidTwoNodeElement(const std::vector<std::string> &tokens);
         bool isValidFourNodeElement(const std::vector<std::string> &tokens);
@@ -0,0 +1,231 @@
+/*!
+    @file       alloc_test.cpp
+    @brief      Checks that the fixed timestep transient does not allocate per timestep.
+
+    The global allocation functions (malloc family and operator new/delete) are replaced by
+    counting ones. The same RC ladder is simulated with a small and a large number of
+    timesteps, for every fixed timestep method with the Cholesky and the SparseLU solvers (and
+    KLU, when compiled in), driven by a current source and by a grounded voltage source
+    (eliminated on the Cholesky path). The allocations of the two runs must be the same up to a
+    constant (the time points vector grows geometrically before the loop). Both runs fit in one
+    chunk of results (see result_store), so the results allocate the same.
+
+    The allocation free SparseLU solve is also checked against SparseLU::solve.
+*/
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include "test_util.hpp"
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void *__libc_memalign(size_t align, size_t size);
+extern "C" void __libc_free(void *ptr);
+
+static std::atomic<size_t> alloc_count(0);     //!< Number of allocations.
+static std::atomic<bool> alloc_counting(false); //!< Allocations are counted.
+
+/*!
+    @brief      Counts an allocation, when counting.
+*/
+static inline void count_alloc(void) noexcept
+{
+    if(alloc_counting.load(std::memory_order_relaxed)) alloc_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+/* The malloc family */
+extern "C" void *malloc(size_t size) { count_alloc(); return __libc_malloc(size); }
+extern "C" void *calloc(size_t count, size_t size) { count_alloc(); return __libc_calloc(count, size); }
+extern "C" void *realloc(void *ptr, size_t size) { count_alloc(); return __libc_realloc(ptr, size); }
+extern "C" void free(void *ptr) { __libc_free(ptr); }
+
+extern "C" int posix_memalign(void **ptr, size_t align, size_t size)
+{
+    count_alloc();
+    *ptr = __libc_memalign(align, size);
+    return *ptr ? 0 : ENOMEM;
+}
+
+extern "C" void *aligned_alloc(size_t align, size_t size) { count_alloc(); return __libc_memalign(align, size); }
+
+/* The global operator new/delete, on the malloc family (counted once) */
+void *operator new(size_t size)
+{
+    void *ptr = malloc(size ? size : 1);
+    if(!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return malloc(size ? size : 1); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return malloc(size ? size : 1); }
+
+void *operator new(size_t size, std::align_val_t align)
+{
+    void *ptr = nullptr;
+    if(posix_memalign(&ptr, static_cast<size_t>(align), size ? size : 1)) throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size, std::align_val_t align) { return operator new(size, align); }
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+
+/*!
+    @brief      Returns the RC ladder netlist (SPD, the voltage source is eliminated).
+    @param      source      The driving source, current (I) or voltage (V).
+    @param      method      The ODE method (METHOD option).
+    @param      solver      The linear solver (SOLVER option).
+    @param      steps       The number of timesteps.
+    @return     The netlist.
+*/
+static std::string netlist(const std::string &source, const std::string &method, const std::string &solver, size_t steps)
+{
+    std::string text = "* RC ladder\n.OPTIONS METHOD=" + method + " SOLVER=" + solver + "\n";
+
+    if(source == "I") text += "I1 0 1 0 PULSE 0 1E-3 1E-4 1E-5 1E-5 2E-4 5E-4\n";
+    else text += "V1 1 0 0 PULSE 0 1 1E-4 1E-5 1E-5 2E-4 5E-4\n";
+
+    for(int k = 1; k <= 8; k++)
+    {
+        text += "R" + std::to_string(k) + " " + std::to_string(k) + " " + std::to_string(k + 1) + " 1000\n";
+        text += "C" + std::to_string(k) + " " + std::to_string(k + 1) + " 0 1E-9\n";
+    }
+
+    return text + "R9 9 0 1000\n.TRAN 1E-6 " + std::to_string(steps) + "E-6\n.PLOT V 1 V 5 V 9\n";
+}
+
+/*!
+    @brief      Runs a transient and counts the allocations of the simulator (construction and run).
+    @param      source      The driving source, current (I) or voltage (V).
+    @param      method      The ODE method (METHOD option).
+    @param      solver      The linear solver (SOLVER option).
+    @param      steps       The number of timesteps.
+    @param      count       The allocations.
+    @return     True in case of success, otherwise false.
+*/
+static bool count_run(const std::string &source, const std::string &method, const std::string &solver, size_t steps, size_t &count)
+{
+    auto circuit_manager = load_netlist("alloc_test_" + source + "_" + method + "_" + solver + ".cir", netlist(source, method, solver, steps));
+    if(!circuit_manager) return false;
+
+    alloc_count = 0;
+    alloc_counting = true;
+
+    simulator sim_manager(*circuit_manager);
+    return_codes_e err = sim_manager.run();
+
+    alloc_counting = false;
+    count = alloc_count;
+
+    return err == RETURN_SUCCESS && sim_manager.NodesResults().Rows() == sim_manager.SimulationVec().size();
+}
+
+/*!
+    @brief      Checks the allocation free SparseLU solve of the direct solver (sparselu_adapter) against
+    SparseLU::solve, on an unsymmetric 2D grid with enough fill for supernodes of many columns.
+    @return     True in case of success, otherwise false.
+*/
+static bool check_sparselu_solve(void)
+{
+    constexpr IntTp n = 30, dim = n * n;
+    tripletList_d trip;
+
+    for(IntTp y = 0; y < n; y++)
+    {
+        for(IntTp x = 0; x < n; x++)
+        {
+            IntTp k = y * n + x;
+            trip.push_back(triplet_eig_d(k, k, 4.5));
+
+            if(x + 1 < n)
+            {
+                trip.push_back(triplet_eig_d(k, k + 1, -1.2));
+                trip.push_back(triplet_eig_d(k + 1, k, -0.8));
+            }
+
+            if(y + 1 < n)
+            {
+                trip.push_back(triplet_eig_d(k, k + n, -1.1));
+                trip.push_back(triplet_eig_d(k + n, k, -0.9));
+            }
+        }
+    }
+
+    SparMatD mat(dim, dim);
+    mat.setFromTriplets(trip.begin(), trip.end());
+
+    DensVecD rh(dim), sol;
+    for(IntTp k = 0; k < dim; k++) rh[k] = std::sin(k + 1.0);
+
+    auto solver = CreateLinearSolver<SparMatD>(SOLVER_SPARSELU, false);
+    if(!solver->factor(mat) || !solver->solve(rh, sol)) return false;
+
+    return check_against_lu("SparseLU adapter", mat, rh, sol, 1e-12);
+}
+
+/*!
+    @brief      The test entry point.
+    @return     0 in case of success, otherwise 1.
+*/
+int main(void)
+{
+    /* Both within one chunk of results */
+    constexpr size_t small_steps = 1000, large_steps = 4000;
+    /* Time points vector growth (geometric), before the loop */
+    constexpr size_t slack = 8;
+    std::vector<std::string> solvers = {"CHOL"};
+    bool pass = true;
+
+    /* SparseLU allocates per solve without the supernodal solve of the adapter (other Eigen versions) */
+#ifdef BSPICE_SPARSELU_SUPERNODAL_SOLVE
+    solvers.push_back("LU");
+#endif
+
+#ifdef BSPICE_EIGEN_USE_KLU
+    solvers.push_back("KLU");
+#endif
+
+    if(!check_sparselu_solve())
+    {
+        std::cerr << "[FAIL]: SparseLU solve differs from SparseLU::solve\n";
+        pass = false;
+    }
+
+    for(std::string source : {"I", "V"})
+    {
+        for(auto &solver : solvers)
+        {
+            for(std::string method : {"EULER", "TRAP", "GEAR2"})
+            {
+                std::string name = source + "/" + method + "/" + solver;
+                size_t small = 0, large = 0;
+
+                if(!count_run(source, method, solver, small_steps, small) || !count_run(source, method, solver, large_steps, large))
+                {
+                    std::cerr << "[FAIL]: " << name << " transient failed\n";
+                    pass = false;
+                    continue;
+                }
+
+                if(large > small + slack)
+                {
+                    std::cerr << "[FAIL]: " << name << " allocations, " << small_steps << " steps: " << small
+                              << ", " << large_steps << " steps: " << large << "\n";
+                    pass = false;
+                }
+            }
+        }
+    }
+
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+/*!
+    @file       btf_test.cpp
+    @brief      Checks the BTF linear solver against a plain LU solve (Eigen SparseLU).
+
+    The system has a known block triangular form: strongly connected diagonal blocks (a cycle
+    through the variables of every block, singletons included) coupled only to the blocks before
+    them, some with the zero diagonal of a voltage source branch. The rows and the columns are then
+    shuffled, so that the matching and the blocks are found by btf_order. The solutions of one and
+    many right hand sides must match SparseLU, for real and complex systems, before and after a
+    numeric refactorization with new values.
+*/
+#include <algorithm>
+#include <complex>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include "btf_solver.hpp"
+#include "test_util.hpp"
+
+/*!
+    @brief      Builds the shuffled block triangular system.
+    @param      gen         The random generator of the values.
+    @param      mat         The matrix.
+    @param      blocks      The number of diagonal blocks of the form.
+*/
+template<typename MatTp>
+static void build_system(std::mt19937 &gen, MatTp &mat, IntTp &blocks)
+{
+    typedef typename MatTp::Scalar ScalarTp;
+    typedef Eigen::Triplet<ScalarTp, IntTp> TripletTp;
+
+    const std::vector<IntTp> block_sz = {1, 5, 12, 1, 1, 20, 3, 8, 2, 1};
+    std::uniform_real_distribution<double> val(0.5, 1.5);
+    std::vector<TripletTp> trip;
+    std::vector<IntTp> start = {0};
+
+    auto value = [&]()
+    {
+        if constexpr (std::is_same<ScalarTp, double>::value) return val(gen);
+        else return ScalarTp(val(gen), val(gen));
+    };
+
+    for(auto sz : block_sz) start.push_back(start.back() + sz);
+    blocks = 0;
+
+    IntTp dim = start.back();
+    std::uniform_int_distribution<IntTp> pick(0, dim - 1);
+
+    for(size_t b = 0; b < block_sz.size(); b++)
+    {
+        IntTp first = start[b], sz = block_sz[b];
+
+        /* Cycle through the variables, the block is strongly connected */
+        for(IntTp k = 0; k < sz; k++)
+        {
+            IntTp var = first + k;
+            trip.push_back(TripletTp(var, var, ScalarTp(4) + value()));
+            if(sz > 1) trip.push_back(TripletTp(var, first + (k + 1) % sz, -value()));
+        }
+
+        blocks++;
+
+        /* A voltage source branch on the last variable, zero diagonal (the cycle closes on the node).
+           The branch row fixes the node, which splits off in a block of its own */
+        if(sz > 3)
+        {
+            IntTp node = first, branch = first + sz - 1;
+
+            trip.erase(std::remove_if(trip.begin(), trip.end(), [&](const TripletTp &it) { return it.row() == branch && it.col() == branch; }), trip.end());
+            trip.push_back(TripletTp(node, branch, ScalarTp(1)));
+            blocks++;
+        }
+
+        /* Couplings to the blocks before */
+        for(IntTp k = 0; b > 0 && k < 2 * sz; k++)
+        {
+            IntTp col = pick(gen) % first;
+            trip.push_back(TripletTp(first + pick(gen) % sz, col, -value()));
+        }
+    }
+
+    /* Shuffled rows and columns */
+    std::vector<IntTp> row_perm(dim), col_perm(dim);
+    std::iota(row_perm.begin(), row_perm.end(), 0);
+    std::iota(col_perm.begin(), col_perm.end(), 0);
+    std::shuffle(row_perm.begin(), row_perm.end(), gen);
+    std::shuffle(col_perm.begin(), col_perm.end(), gen);
+
+    for(auto &it : trip) it = TripletTp(row_perm[it.row()], col_perm[it.col()], it.value());
+
+    mat.resize(dim, dim);
+    mat.setFromTriplets(trip.begin(), trip.end());
+    mat.makeCompressed();
+}
+
+/*!
+    @brief      Compares the BTF solutions against SparseLU, before and after a refactorization.
+    @param      name        The name of the system, for the report.
+    @return     True in case of success, otherwise false.
+*/
+template<typename MatTp>
+static bool check_system(const std::string &name)
+{
+    typedef typename btf_linear_solver<MatTp>::VecTp VecTp;
+    typedef typename btf_linear_solver<MatTp>::MultiVecTp MultiVecTp;
+
+    std::mt19937 gen(17);
+    MatTp mat;
+    IntTp blocks = 0;
+    bool pass = true;
+
+    build_system(gen, mat, blocks);
+
+    btf_linear_solver<MatTp> btf(SOLVER_BTF);
+
+    if(!btf.analyze(mat) || btf.Stats().blocks != blocks || btf.Stats().levels < 2)
+    {
+        std::cerr << "[FAIL]: " << name << " block triangular form, " << btf.Stats().blocks << " blocks (expected " << blocks << ")\n";
+        return false;
+    }
+
+    for(int pass_num = 0; pass_num < 2; pass_num++)
+    {
+        /* Same pattern, new values */
+        if(pass_num) for(IntTp k = 0; k < mat.nonZeros(); k++) mat.valuePtr()[k] *= 1.0 + 0.25 * std::sin(k + 1.0);
+
+        VecTp rh = VecTp::Random(mat.rows()), sol;
+        MultiVecTp rh_multi = MultiVecTp::Random(mat.rows(), 3), sol_multi;
+
+        if(!btf.refactor(mat) || !btf.solve(rh, sol) || !btf.solveMulti(rh_multi, sol_multi))
+        {
+            std::cerr << "[FAIL]: " << name << " factorization or solve failed\n";
+            return false;
+        }
+
+        std::string run = name + (pass_num ? " (refactorized)" : "");
+        pass = check_against_lu(run, mat, rh, sol, 1e-10) && pass;
+        pass = check_against_lu(run + " multiple right hand sides", mat, rh_multi, sol_multi, 1e-10) && pass;
+    }
+
+    return pass;
+}
+
+/*!
+    @brief      The test entry point.
+    @return     0 in case of success, otherwise 1.
+*/
+int main(void)
+{
+    bool pass = check_system<SparMatD>("real");
+    pass = check_system<SparMatCompD>("complex") && pass;
+
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+/*!
+    @file       ckpt_test.cpp
+    @brief      Checks the restart of a killed transient from its last checkpoint (--restart).
+
+    The transient runs in a child process (this executable, with the options as argument) with
+    checkpoints, and is killed (SIGKILL) once the first checkpoint is written. The restarted run must
+    give the results of an uninterrupted one. A restart with another .PLOT (rows of results of
+    another size) must be rejected, and leave the checkpoint for the right netlist.
+*/
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "test_util.hpp"
+
+/** The netlist file, the checkpoint is the same name with .ckpt */
+static const std::string netlist_file = "ckpt_test.cir";
+
+/*!
+    @brief      Returns the netlist of an RC ladder (20 stages), driven by a pulse, with checkpoints.
+    @param      options     The transient options (METHOD and others).
+    @param      plot        The .PLOT card.
+    @return     The netlist.
+*/
+static std::string netlist(const std::string &options, const std::string &plot = ".PLOT V 2 V 11 V 21 I V1")
+{
+    std::string text = "* RC ladder\n"
+                       ".OPTIONS " + options + " CHECKPOINT=0.02\n"
+                       "V1 1 0 0 PULSE 0 1 1E-8 1E-8 1E-8 2E-7 5E-7\n";
+
+    for(int k = 1; k <= 20; k++)
+    {
+        text += "R" + std::to_string(k) + " " + std::to_string(k) + " " + std::to_string(k + 1) + " 100\n";
+        text += "C" + std::to_string(k) + " " + std::to_string(k + 1) + " 0 1E-10\n";
+    }
+
+    return text + ".TRAN 1E-9 5E-4\n" + plot + "\n";
+}
+
+/*!
+    @brief      Runs the transient in a child process and kills it once a checkpoint is written.
+    @param      self        This executable.
+    @param      options     The transient options (METHOD and others).
+    @return     True in case the child was killed after a checkpoint, otherwise false.
+*/
+static bool run_killed(const char *self, const std::string &options)
+{
+    std::string ckpt = netlist_file + ".ckpt";
+    std::filesystem::remove(ckpt);
+
+    pid_t pid = fork();
+    if(pid < 0) return false;
+
+    if(pid == 0)
+    {
+        execl(self, self, options.c_str(), static_cast<char *>(nullptr));
+        _exit(2);
+    }
+
+    /* The state file is renamed into place once complete */
+    bool written = false;
+    for(int k = 0; k < 10000 && !written; k++)
+    {
+        written = std::filesystem::exists(ckpt);
+        if(!written) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    kill(pid, SIGKILL);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    if(!written || !WIFSIGNALED(status))
+    {
+        std::cerr << "[FAIL]: " << options << ", the transient ended before it was killed after a checkpoint\n";
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+    @brief      Kills the transient after a checkpoint, and compares the restarted run against an
+    uninterrupted one.
+    @param      self        This executable.
+    @param      options     The transient options (METHOD and others).
+    @return     True in case of success, otherwise false.
+*/
+static bool check_restart(const char *self, const std::string &options)
+{
+    sim_args_t args;
+    args.restart = true;
+
+    auto ref = run_netlist(netlist_file, netlist(options));
+    if(!ref || !run_killed(self, options)) return false;
+
+    /* Another .PLOT, the rows of the checkpoint don't fit */
+    if(!run_netlist(netlist_file, netlist(options, ".PLOT V 2 V 11"), args, FAIL_SIMULATOR_RESTART)) return false;
+
+    auto sim_manager = run_netlist(netlist_file, netlist(options), args);
+    if(!sim_manager) return false;
+
+    return compare_results(options + " nodes", sim_manager->NodesResults(), ref->NodesResults(), 1e-9) &&
+           compare_results(options + " sources", sim_manager->SourceResults(), ref->SourceResults(), 1e-9);
+}
+
+/*!
+    @brief      The test entry point, or the transient to be killed with the options as argument.
+    @param      argc        The number of arguments.
+    @param      argv        The arguments.
+    @return     0 in case of success, otherwise 1.
+*/
+int main(int argc, char *argv[])
+{
+    if(argc > 1) return run_netlist(netlist_file, netlist(argv[1])) ? 0 : 1;
+
+    bool pass = true;
+
+    for(std::string options : {"METHOD=TRAP", "METHOD=GEAR2", "METHOD=EULER ADAPTIVE", "METHOD=BDF"})
+    {
+        if(!check_restart(argv[0], options))
+        {
+            std::cerr << "[FAIL]: " << options << " restart from a checkpoint\n";
+            pass = false;
+        }
+    }
+
+    return pass ? 0 : 1;
+}
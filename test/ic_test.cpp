@@ -0,0 +1,82 @@
+/*!
+    @file       ic_test.cpp
+    @brief      Checks the transient from a given initial state (UIC) with a voltage source.
+
+    With UIC the OP is skipped and x(0) is zero apart from the IC nodes, so the node of the
+    voltage source (an algebraic unknown) is inconsistent at t=0. Every method must still give
+    the source voltage from the first timestep on. The trapezoidal method alone would keep the
+    initial error oscillating (0, 2, 0, 2, ...), so it has to start with an Euler step.
+*/
+#include <cmath>
+#include <iostream>
+#include "test_util.hpp"
+
+/*!
+    @brief      Returns the RC netlist, driven by a 1V source, with UIC.
+    @param      options     The transient options (METHOD and others).
+    @return     The netlist.
+*/
+static std::string netlist(const std::string &options)
+{
+    return "* RC with UIC\n"
+           ".OPTIONS " + options + " UIC\n"
+           "V1 1 0 1\n"
+           "R1 1 2 1000\n"
+           "C1 2 0 1E-6\n"
+           ".TRAN 1E-5 1E-3\n"
+           ".PLOT V 1 V 2\n";
+}
+
+/*!
+    @brief      Runs the transient and checks the voltage of the source node after t=0.
+    @param      options     The transient options (METHOD and others).
+    @return     True in case of success, otherwise false.
+*/
+static bool check_run(const std::string &options)
+{
+    auto sim_manager = run_netlist("ic_test.cir", netlist(options));
+    if(!sim_manager) return false;
+
+    /* Column 0 is v(1), column 1 is v(2) */
+    auto &nodes = sim_manager->NodesResults();
+    if(nodes.Rows() < 2) return false;
+
+    for(size_t row = 1; row < nodes.Rows(); row++)
+    {
+        if(std::abs(nodes.Get(row, 0) - 1) > 1e-9)
+        {
+            std::cerr << "[FAIL]: " << options << ", v(1) = " << nodes.Get(row, 0) << " at row " << row << "\n";
+            return false;
+        }
+    }
+
+    /* The capacitor charges towards the source (tau = 1ms) */
+    double v2 = nodes.Get(nodes.Rows() - 1, 1), ref = 1 - std::exp(-1.0);
+    if(std::abs(v2 - ref) > 1e-2)
+    {
+        std::cerr << "[FAIL]: " << options << ", v(2) = " << v2 << " at the end, expected " << ref << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+    @brief      The test entry point.
+    @return     0 in case of success, otherwise 1.
+*/
+int main(void)
+{
+    bool pass = true;
+
+    for(std::string options : {"METHOD=EULER", "METHOD=TRAP", "METHOD=GEAR2", "METHOD=TRAP ADAPTIVE", "METHOD=TRAP WR"})
+    {
+        if(!check_run(options))
+        {
+            std::cerr << "[FAIL]: " << options << " transient from UIC\n";
+            pass = false;
+        }
+    }
+
+    return pass ? 0 : 1;
+}
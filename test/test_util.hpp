@@ -0,0 +1,159 @@
+/*!
+    @file       test_util.hpp
+    @brief      Helpers shared by the tests: netlists written from text and run through the simulator,
+    results compared against a reference run, and solutions compared against a plain LU solve.
+
+    The netlists are written to the working directory of the test (the build directory) and removed
+    once parsed. Every helper reports the reason of a failure on cerr, prefixed with [FAIL].
+*/
+#ifndef __TEST_UTIL_H
+#define __TEST_UTIL_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include "circuit.hpp"
+#include "sim_engine.hpp"
+
+/*!
+    @brief      Writes a text file (netlist).
+    @param      file        The file.
+    @param      text        The contents.
+    @return     True in case of success, otherwise false.
+*/
+inline bool write_text(const std::string &file, const std::string &text)
+{
+    std::ofstream out(file);
+    out << text;
+
+    return static_cast<bool>(out);
+}
+
+/*!
+    @brief      Writes a netlist and parses it, the file is removed once parsed.
+    @param      file        The netlist file.
+    @param      netlist     The netlist.
+    @return     The circuit in case of success, otherwise nullptr.
+*/
+inline std::unique_ptr<circuit> load_netlist(const std::string &file, const std::string &netlist)
+{
+    if(!write_text(file, netlist))
+    {
+        std::cerr << "[FAIL]: " << file << " can't be written\n";
+        return nullptr;
+    }
+
+    auto circuit_manager = std::make_unique<circuit>(file);
+    std::remove(file.c_str());
+
+    if(circuit_manager->errcode() != RETURN_SUCCESS)
+    {
+        std::cerr << "[FAIL]: " << file << " parser error " << circuit_manager->errcode() << "\n";
+        return nullptr;
+    }
+
+    return circuit_manager;
+}
+
+/*!
+    @brief      Writes a netlist, parses it and runs the simulator on it.
+    @param      file        The netlist file (removed once parsed).
+    @param      netlist     The netlist.
+    @param      args        The command line arguments of the simulation.
+    @param      expected    The expected result of the run.
+    @return     The simulator in case the run ends with the expected result, otherwise nullptr.
+*/
+inline std::unique_ptr<simulator> run_netlist(const std::string &file, const std::string &netlist, const sim_args_t &args = sim_args_t(),
+                                              return_codes_e expected = RETURN_SUCCESS)
+{
+    auto circuit_manager = load_netlist(file, netlist);
+    if(!circuit_manager) return nullptr;
+
+    auto sim_manager = std::make_unique<simulator>(*circuit_manager, args);
+    return_codes_e err = sim_manager->run();
+
+    if(err != expected)
+    {
+        std::cerr << "[FAIL]: " << file << " simulator returned " << err << " (expected " << expected << ")\n";
+        return nullptr;
+    }
+
+    return sim_manager;
+}
+
+/*!
+    @brief      Compares results against the reference ones, the rows and the columns must be the same and
+    every sample within the tolerance, relative to the peak of its column (at least 1).
+    @param      name        The name of the comparison, for the report.
+    @param      res         The results.
+    @param      ref         The reference results.
+    @param      tol         The tolerance.
+    @return     True in case of success, otherwise false.
+*/
+inline bool compare_results(const std::string &name, const result_store<double> &res, const result_store<double> &ref, double tol)
+{
+    if(res.Rows() != ref.Rows() || res.Cols() != ref.Cols())
+    {
+        std::cerr << "[FAIL]: " << name << ", " << res.Rows() << "x" << res.Cols() << " results, expected " << ref.Rows() << "x" << ref.Cols() << "\n";
+        return false;
+    }
+
+    for(size_t col = 0; col < ref.Cols(); col++)
+    {
+        double peak = 1, err = 0;
+        size_t worst = 0;
+
+        for(size_t row = 0; row < ref.Rows(); row++) peak = std::max(peak, std::abs(ref.Get(row, col)));
+
+        for(size_t row = 0; row < ref.Rows(); row++)
+        {
+            double diff = std::abs(res.Get(row, col) - ref.Get(row, col));
+            if(diff > err) { err = diff; worst = row; }
+        }
+
+        if(err > tol * peak)
+        {
+            std::cerr << "[FAIL]: " << name << ", column " << col << " differs by " << err << " at row " << worst << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+    @brief      Checks a solution against the one of a plain LU solve (Eigen SparseLU).
+    @param      name        The name of the comparison, for the report.
+    @param      mat         The matrix.
+    @param      rh          The right hand side(s).
+    @param      sol         The solution(s).
+    @param      tol         The tolerance, relative to the norm of the reference solution.
+    @return     True in case of success, otherwise false.
+*/
+template<typename MatTp, typename VecTp>
+inline bool check_against_lu(const std::string &name, const MatTp &mat, const VecTp &rh, const VecTp &sol, double tol)
+{
+    Eigen::SparseLU<MatTp, Eigen::COLAMDOrdering<IntTp>> lu;
+    lu.compute(mat);
+
+    if(lu.info() != Eigen::Success)
+    {
+        std::cerr << "[FAIL]: " << name << ", the reference LU factorization failed\n";
+        return false;
+    }
+
+    VecTp ref = lu.solve(rh);
+
+    if((sol - ref).norm() > tol * ref.norm())
+    {
+        std::cerr << "[FAIL]: " << name << ", the solution differs from SparseLU by " << (sol - ref).norm() / ref.norm() << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+#endif // __TEST_UTIL_H //
@@ -0,0 +1,187 @@
+/*!
+    @file       wave_test.cpp
+    @brief      Checks the round trip of the waveform file (wave_writer/wave_reader).
+
+    Every sample format (double, float, 16-bit integers) with:
+    - Files of a single row, of fewer rows than the sized chunks (16), and of many rows, whose last
+    chunk is a single row or a few rows.
+    - Column counts within one block of columns (1024), filling it, and over two blocks.\n
+    Every column is read back whole, and a few of them on a range of rows found by RowRange.
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include "wave_file.hpp"
+
+/** The timestep of the scale (first column) */
+static constexpr double wave_step = 1e-9;
+
+/*!
+    @brief      Returns the sample of a row and column: the scale (time), a constant, a NaN (one
+    sample of column 2) and sines of growing amplitude.
+    @param      row         The row.
+    @param      col         The column.
+    @return     The sample.
+*/
+static double sample(size_t row, size_t col)
+{
+    if(col == 0) return row * wave_step;
+    if(col == 1) return 0.5;
+    if(col == 2 && row == 3) return std::numeric_limits<double>::quiet_NaN();
+
+    return (col + 1) * std::sin(1e-3 * row + 0.1 * col);
+}
+
+/*!
+    @brief      Checks samples read back against the ones written, within the precision of the format:
+    exact in double precision, rounded to single precision, or quantized to the range of the column.
+    @param      name        The name of the check, for the report.
+    @param      vals        The samples read back.
+    @param      col         The column.
+    @param      first       The row of the first sample.
+    @param      rows        The rows of the file.
+    @param      format      The format of the samples.
+    @return     True in case of success, otherwise false.
+*/
+static bool check_column(const std::string &name, const std::vector<double> &vals, size_t col, size_t first, size_t rows,
+                         store_format_t format)
+{
+    double lo = INFINITY, hi = -INFINITY;
+
+    for(size_t row = 0; format == STORE_INT16 && row < rows; row++)
+    {
+        double val = sample(row, col);
+        if(std::isfinite(val)) { lo = std::min(lo, val); hi = std::max(hi, val); }
+    }
+
+    for(size_t k = 0; k < vals.size(); k++)
+    {
+        double ref = sample(first + k, col), val = vals[k];
+        bool ok;
+
+        if(std::isnan(ref)) ok = std::isnan(val);
+        else if(col == 0 || format == STORE_DOUBLE) ok = (val == ref);
+        else if(format == STORE_FLOAT) ok = (val == static_cast<float>(ref));
+        else ok = std::abs(val - ref) <= std::max((hi - lo) / INT16_MAX, std::abs(ref) * 1e-7);
+
+        if(!ok)
+        {
+            std::cerr << "[FAIL]: " << name << ", column " << col << " row " << first + k << " is " << val << ", expected " << ref << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+    @brief      Writes a waveform file and reads it back.
+    @param      rows        The rows.
+    @param      cols        The columns, the scale first.
+    @param      format      The format of the samples.
+    @return     True in case of success, otherwise false.
+*/
+static bool check_file(size_t rows, size_t cols, store_format_t format)
+{
+    const std::string file = "wave_test.wave";
+    std::string name = std::to_string(rows) + "x" + std::to_string(cols) + " format " + std::to_string(format);
+    std::vector<raw_var_t> vars(cols);
+    std::vector<double> point(cols), vals;
+
+    vars[0] = {"time", "time"};
+    for(size_t col = 1; col < cols; col++) vars[col] = {"v(" + std::to_string(col) + ")", "voltage"};
+
+    {
+        wave_writer writer(file, "wave_test", vars, false, true, format);
+
+        for(size_t row = 0; row < rows; row++)
+        {
+            for(size_t col = 0; col < cols; col++) point[col] = sample(row, col);
+            writer.Push(point.data());
+        }
+
+        if(!writer.Finish())
+        {
+            std::cerr << "[FAIL]: " << name << ", the file can't be written\n";
+            return false;
+        }
+    }
+
+    wave_reader reader;
+    bool pass = reader.Open(file);
+
+    if(!pass || reader.Rows() != rows || reader.Columns() != cols || reader.Format() != format || reader.Variables().size() != cols)
+    {
+        std::cerr << "[FAIL]: " << name << ", wrong header or index\n";
+        std::remove(file.c_str());
+        return false;
+    }
+
+    /* Whole columns */
+    for(size_t col = 0; pass && col < cols; col++)
+    {
+        pass = reader.ReadColumn(col, vals) && vals.size() == rows;
+        if(!pass) std::cerr << "[FAIL]: " << name << ", column " << col << " can't be read\n";
+
+        pass = pass && check_column(name, vals, col, 0, rows, format);
+    }
+
+    /* The middle third of the scale, halfway between the timepoints */
+    uint64_t first = 0, last = 0;
+    reader.RowRange((rows / 3 - 0.5) * wave_step, (2 * rows / 3 + 0.5) * wave_step, first, last);
+
+    if(pass && (first != rows / 3 || last != 2 * rows / 3 + 1))
+    {
+        std::cerr << "[FAIL]: " << name << ", rows [" << first << ", " << last << ") of the range, expected [";
+        std::cerr << rows / 3 << ", " << 2 * rows / 3 + 1 << ")\n";
+        pass = false;
+    }
+
+    for(size_t col : {size_t(0), size_t(2), cols / 2, cols - 1})
+    {
+        if(!pass) break;
+
+        pass = reader.ReadColumn(col, vals, first, last) && vals.size() == last - first;
+        if(!pass) std::cerr << "[FAIL]: " << name << ", column " << col << " can't be read in rows [" << first << ", " << last << ")\n";
+
+        pass = pass && check_column(name, vals, col, first, rows, format);
+    }
+
+    /* After the end of the scale */
+    reader.RowRange(rows * wave_step, (rows + 10) * wave_step, first, last);
+
+    if(pass && first != last)
+    {
+        std::cerr << "[FAIL]: " << name << ", rows [" << first << ", " << last << ") after the end of the scale\n";
+        pass = false;
+    }
+
+    std::remove(file.c_str());
+
+    return pass;
+}
+
+/*!
+    @brief      The test entry point.
+    @return     0 in case of success, otherwise 1.
+*/
+int main(void)
+{
+    bool pass = true;
+
+    for(auto format : {STORE_DOUBLE, STORE_FLOAT, STORE_INT16})
+    {
+        /* Chunks of 4096 rows up to 1024 columns (last chunk of 1 or 7 rows), 4092 with 1025 (5 or 11 rows) */
+        for(size_t cols : {5, 1024, 1025})
+        {
+            for(size_t rows : {1, 7, 4097, 4103})
+            {
+                pass = check_file(rows, cols, format) && pass;
+            }
+        }
+    }
+
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+/*!
+    @file       wr_test.cpp
+    @brief      Checks the waveform relaxation transient (WR option) against the sequential one.
+
+    The circuit has four domains, joined by the three kinds of weak couplings: a floating
+    capacitor (both ways), a VCVS and a VCCS (one way each). With a small coupling capacitor the
+    iterations converge and the results must be the ones of the sequential method. With a coupling
+    capacitor larger than the grounded ones they do not converge, and the whole circuit has to be
+    solved with the sequential method, with the same results.
+*/
+#include <iostream>
+#include "test_util.hpp"
+
+/*!
+    @brief      Returns the netlist of the four domains, driven by a pulse.
+    @param      options     The transient options (METHOD and others).
+    @param      coupling    The coupling capacitor between the first two domains.
+    @return     The netlist.
+*/
+static std::string netlist(const std::string &options, const std::string &coupling)
+{
+    return "* Four domains, coupling capacitor, VCVS and VCCS\n"
+           ".OPTIONS " + options + "\n"
+           "V1 1 0 0 PULSE 0 1 1E-8 1E-8 1E-8 2E-7 5E-7\n"
+           "R1 1 2 1000\n"
+           "C1 2 0 1E-9\n"
+           "CC 2 3 " + coupling + "\n"
+           "R2 3 0 1000\n"
+           "C2 3 0 1E-9\n"
+           "R3 3 4 1000\n"
+           "C3 4 0 1E-9\n"
+           "E1 5 0 4 0 0.5\n"
+           "R4 5 6 1000\n"
+           "C4 6 0 1E-9\n"
+           "G1 0 7 6 0 1E-3\n"
+           "R5 7 0 1000\n"
+           "C5 7 0 1E-9\n"
+           ".TRAN 1E-9 2E-6\n"
+           ".PLOT V 2 V 3 V 4 V 6 V 7\n";
+}
+
+/*!
+    @brief      Runs the transient with waveform relaxation (4 partitions, one per domain) and
+    compares it against the sequential one.
+    @param      method      The ODE method (METHOD option).
+    @param      coupling    The coupling capacitor between the first two domains.
+    @param      iters       The expected waveform relaxation iterations.
+    @param      fallback    The iterations are expected not to converge.
+    @return     True in case of success, otherwise false.
+*/
+static bool check_run(const std::string &method, const std::string &coupling, IntTp iters, bool fallback)
+{
+    std::string name = method + ", CC = " + coupling;
+
+    auto ref = run_netlist("wr_test.cir", netlist(method, coupling));
+    auto sim_manager = run_netlist("wr_test.cir", netlist(method + " WR=4", coupling));
+    if(!ref || !sim_manager) return false;
+
+    auto &stats = sim_manager->RelaxationStats();
+    if(stats.partitions != 4 || stats.iters != iters || stats.fallback != fallback)
+    {
+        std::cerr << "[FAIL]: " << name << ", " << stats.partitions << " partitions, " << stats.iters << " iterations";
+        std::cerr << (stats.fallback ? " (fallback)" : "") << ", expected 4 partitions, " << iters << " iterations";
+        std::cerr << (fallback ? " (fallback)" : "") << "\n";
+        return false;
+    }
+
+    /* Converged within RELTOL/ABSTOL (defaults) of the sequential method, or the sequential method itself */
+    return compare_results(name, sim_manager->NodesResults(), ref->NodesResults(), fallback ? 1e-12 : 1e-3);
+}
+
+/*!
+    @brief      The test entry point.
+    @return     0 in case of success, otherwise 1.
+*/
+int main(void)
+{
+    bool pass = true;
+
+    for(std::string method : {"METHOD=EULER", "METHOD=TRAP"})
+    {
+        /* Weak coupling, the waveforms settle once they went through the chain of domains */
+        pass = check_run(method, "1E-10", 6, false) && pass;
+
+        /* Strong coupling, not converged in the maximum iterations */
+        pass = check_run(method, "1E-6", relaxation_state_t::max_iters, true) && pass;
+    }
+
+    return pass ? 0 : 1;
+}